@@ -0,0 +1,46 @@
+#pragma once
+
+#include <my_vulkan/my_vulkan.hpp>
+
+#include <chrono>
+#include <cstddef>
+
+// headless device without validation layers, they would dominate the
+// timings
+struct benchmark_setup_t
+{
+    benchmark_setup_t()
+    : instance{"my_vulkan benchmark"}
+    , physical_device{
+        my_vulkan::pick_physical_device(0, instance.get(), nullptr, {})
+    }
+    , queue_indices{
+        .graphics = my_vulkan::find_graphics_queue(physical_device),
+        .present = 0,
+        .transfer = my_vulkan::find_transfer_queue(physical_device)
+    }
+    , logical_device{
+        physical_device,
+        queue_indices,
+        {},
+        {}
+    }
+    {
+    }
+    my_vulkan::instance_t instance;
+    VkPhysicalDevice physical_device;
+    my_vulkan::queue_family_indices_t queue_indices;
+    my_vulkan::device_t logical_device;
+};
+
+// average seconds per call of f
+template<typename f_t>
+double seconds_per_iteration(size_t iterations, f_t&& f)
+{
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < iterations; ++i)
+        f(i);
+    std::chrono::duration<double> elapsed =
+        std::chrono::steady_clock::now() - start;
+    return elapsed.count() / iterations;
+}
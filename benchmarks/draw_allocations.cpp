@@ -0,0 +1,116 @@
+// heap allocations per draw recorded through command_buffer_t::scope_t,
+// counting the binds and push constants a renderer records before each
+// draw. the draw itself needs a pipeline and is left out, it takes no
+// containers. fails if recording allocates at all
+#include "benchmark_setup.hpp"
+
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+
+static std::atomic<size_t> num_allocations{0};
+
+void* operator new(size_t size)
+{
+    ++num_allocations;
+    if (auto p = std::malloc(size ? size : 1))
+        return p;
+    throw std::bad_alloc{};
+}
+
+void operator delete(void* p) noexcept
+{
+    std::free(p);
+}
+
+void operator delete(void* p, size_t) noexcept
+{
+    std::free(p);
+}
+
+using namespace my_vulkan;
+
+int main()
+{
+    benchmark_setup_t setup;
+    auto& device = setup.logical_device;
+    constexpr VkDeviceSize uniform_size = 256;
+    buffer_t uniforms{
+        device,
+        2 * uniform_size,
+        VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
+        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT
+    };
+    buffer_t vertices[] = {
+        {device, 1024, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT},
+        {device, 1024, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT}
+    };
+    buffer_t instances{device, 1024, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT};
+    buffer_t indices{device, 1024, VK_BUFFER_USAGE_INDEX_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT};
+    descriptor_set_layout_t set_layout{
+        device.get(),
+        {{0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, 1, VK_SHADER_STAGE_VERTEX_BIT, nullptr}}
+    };
+    descriptor_pool_t descriptor_pool{
+        device.get(),
+        {{VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, 1}},
+        1
+    };
+    auto descriptor_set = descriptor_pool.make_descriptor_set(set_layout.get());
+    descriptor_set.update_buffer_write(
+        0,
+        VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC,
+        {{uniforms.get(), 0, uniform_size}}
+    );
+    auto vk_set_layout = set_layout.get();
+    VkPushConstantRange push_range{VK_SHADER_STAGE_VERTEX_BIT, 0, 64};
+    VkPipelineLayoutCreateInfo layout_info = {};
+    layout_info.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+    layout_info.setLayoutCount = 1;
+    layout_info.pSetLayouts = &vk_set_layout;
+    layout_info.pushConstantRangeCount = 1;
+    layout_info.pPushConstantRanges = &push_range;
+    VkPipelineLayout layout;
+    vk_require(
+        vkCreatePipelineLayout(device.get(), &layout_info, nullptr, &layout),
+        "creating pipeline layout"
+    );
+    command_pool_t command_pool{device.get(), device.graphics_queue()};
+    auto command_buffer = command_pool.make_buffer();
+    constexpr size_t num_draws = 100000;
+    size_t allocations;
+    double seconds;
+    {
+        auto commands = command_buffer.begin(VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT);
+        auto descriptor_set_handle = descriptor_set.get();
+        float push_data[16] = {};
+        auto before = num_allocations.load();
+        seconds = seconds_per_iteration(num_draws, [&](size_t i) {
+            uint32_t dynamic_offset = uint32_t(i % 2 * uniform_size);
+            commands.bind_descriptor_set(
+                VK_PIPELINE_BIND_POINT_GRAPHICS,
+                layout,
+                {descriptor_set_handle},
+                0,
+                {dynamic_offset}
+            );
+            commands.bind_vertex_buffers({
+                {vertices[i % 2].get(), 0},
+                {instances.get(), 0}
+            });
+            commands.bind_index_buffer(indices.get(), VK_INDEX_TYPE_UINT32);
+            commands.push_constants(layout, VK_SHADER_STAGE_VERTEX_BIT, push_data);
+        });
+        allocations = num_allocations.load() - before;
+        commands.end();
+    }
+    vkDestroyPipelineLayout(device.get(), layout, nullptr);
+    std::printf(
+        "%zu draws: %.3f allocations and %.3f us per draw\n",
+        num_draws,
+        double(allocations) / num_draws,
+        seconds * 1e6
+    );
+    return allocations ? 1 : 0;
+}
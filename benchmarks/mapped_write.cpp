@@ -0,0 +1,56 @@
+// host to device memory write throughput, through the persistent mapping
+// against a vkMapMemory/vkUnmapMemory pair per write
+#include "benchmark_setup.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+using namespace my_vulkan;
+
+static double megabytes_per_second(size_t write_size, double seconds)
+{
+    return write_size / seconds / (1024 * 1024);
+}
+
+int main()
+{
+    benchmark_setup_t setup;
+    auto& device = setup.logical_device;
+    constexpr VkDeviceSize memory_size = 16 << 20;
+    constexpr VkMemoryPropertyFlags properties =
+        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
+        VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+    auto type = findMemoryType(setup.physical_device, ~0u, properties);
+    // mapped once when created
+    device_memory_t persistent{device, {memory_size, type.index, {}, nullptr, properties}};
+    // without property flags the memory is mapped per write
+    device_memory_t unmapped{device, {memory_size, type.index}};
+    std::vector<char> source(memory_size, 1);
+    std::printf("%10s %12s %12s\n", "size", "map MB/s", "mapped MB/s");
+    for (size_t write_size = 256; write_size <= memory_size; write_size *= 16)
+    {
+        size_t writes_per_memory = memory_size / write_size;
+        size_t iterations = std::max<size_t>(writes_per_memory, 16);
+        auto offset_of = [&](size_t i) {
+            return VkDeviceSize(i % writes_per_memory * write_size);
+        };
+        auto map_seconds = seconds_per_iteration(iterations, [&](size_t i) {
+            auto mapping = unmapped.map(
+                device_memory_t::region_t{offset_of(i), write_size}
+            );
+            std::memcpy(mapping.data(), source.data(), write_size);
+        });
+        auto mapped_seconds = seconds_per_iteration(iterations, [&](size_t i) {
+            persistent.set_data(source.data(), write_size, offset_of(i));
+        });
+        std::printf(
+            "%10zu %12.1f %12.1f\n",
+            write_size,
+            megabytes_per_second(write_size, map_seconds),
+            megabytes_per_second(write_size, mapped_seconds)
+        );
+    }
+    return 0;
+}
@@ -0,0 +1,196 @@
+// render_queue_t without a device: a shuffled scene is pushed and drained,
+// the sorted order and the state change counters are checked, then the
+// time per queued draw is measured. fails if any check does
+#include "benchmark_setup.hpp"
+
+#include <my_vulkan/helpers/render_queue.hpp>
+
+#include <algorithm>
+#include <cstdio>
+#include <random>
+#include <set>
+#include <tuple>
+#include <type_traits>
+#include <vector>
+
+using my_vulkan::helpers::make_sort_key;
+using my_vulkan::helpers::render_packet_t;
+using my_vulkan::helpers::render_queue_t;
+
+// non dispatchable handles are pointers or integers depending on the
+// platform
+template<typename handle_t>
+static handle_t fake_handle(uint64_t value)
+{
+    if constexpr (std::is_pointer<handle_t>::value)
+        return reinterpret_cast<handle_t>(uintptr_t(value));
+    else
+        return handle_t(value);
+}
+
+static size_t num_failures = 0;
+
+static void check(bool condition, const char* what)
+{
+    if (condition)
+        return;
+    std::fprintf(stderr, "failed: %s\n", what);
+    ++num_failures;
+}
+
+struct draw_t
+{
+    uint64_t pipeline;
+    uint64_t descriptor_set;
+    uint64_t texture;
+    float depth;
+};
+
+static std::vector<draw_t> make_scene(size_t num_draws)
+{
+    std::vector<draw_t> scene;
+    for (size_t i = 0; i < num_draws; ++i)
+        scene.push_back({i % 8, i / 8 % 32, i * 7 % 64, float(i % 100) / 100});
+    std::shuffle(scene.begin(), scene.end(), std::mt19937{1});
+    return scene;
+}
+
+// the push index goes into the range, to check the order against
+static void push_scene(render_queue_t& queue, const std::vector<draw_t>& scene)
+{
+    for (size_t i = 0; i < scene.size(); ++i)
+    {
+        render_packet_t packet;
+        packet.pipeline = fake_handle<VkPipeline>(scene[i].pipeline + 1);
+        packet.descriptor_set = fake_handle<VkDescriptorSet>(scene[i].descriptor_set + 1);
+        packet.range = {uint32_t(i), 1};
+        queue.push(
+            packet,
+            fake_handle<VkImageView>(scene[i].texture + 1),
+            scene[i].depth
+        );
+    }
+}
+
+static void check_scene_order()
+{
+    auto scene = make_scene(20000);
+    render_queue_t queue;
+    queue.begin_frame();
+    push_scene(queue, scene);
+    std::vector<uint32_t> order;
+    queue.drain([&](const render_packet_t& packet){
+        order.push_back(packet.range.offset);
+    });
+    check(order.size() == scene.size(), "every packet is drained");
+    check(queue.size() == 0, "drain empties the queue");
+    // ids are kept until the next begin_frame
+    auto key_of = [&](uint32_t index){
+        auto& draw = scene[index];
+        return make_sort_key(
+            queue.pipeline_id(fake_handle<VkPipeline>(draw.pipeline + 1)),
+            queue.descriptor_set_id(fake_handle<VkDescriptorSet>(draw.descriptor_set + 1)),
+            queue.texture_id(fake_handle<VkImageView>(draw.texture + 1)),
+            draw.depth
+        );
+    };
+    bool sorted = true;
+    bool stable = true;
+    for (size_t i = 1; i < order.size(); ++i)
+    {
+        auto previous = key_of(order[i - 1]);
+        auto current = key_of(order[i]);
+        sorted = sorted && previous <= current;
+        stable = stable && (previous != current || order[i - 1] < order[i]);
+    }
+    check(sorted, "packets are drained in key order");
+    check(stable, "equal keys keep their push order");
+    std::set<std::tuple<uint64_t, uint64_t>> descriptor_sets;
+    for (auto& draw : scene)
+        descriptor_sets.emplace(draw.pipeline, draw.descriptor_set);
+    auto unsorted = queue.unsorted_state_changes();
+    auto sorted_changes = queue.sorted_state_changes();
+    check(sorted_changes.pipelines == 8, "each pipeline is bound once");
+    check(
+        sorted_changes.descriptor_sets == descriptor_sets.size(),
+        "each descriptor set of a pipeline is bound once"
+    );
+    check(sorted_changes.pipelines <= unsorted.pipelines, "fewer pipeline changes");
+    check(sorted_changes.descriptor_sets <= unsorted.descriptor_sets, "fewer descriptor set changes");
+    check(sorted_changes.textures <= unsorted.textures, "fewer texture changes");
+    std::printf(
+        "%zu draws, pipeline/set/texture changes %zu/%zu/%zu unsorted, %zu/%zu/%zu sorted\n",
+        scene.size(),
+        unsorted.pipelines,
+        unsorted.descriptor_sets,
+        unsorted.textures,
+        sorted_changes.pipelines,
+        sorted_changes.descriptor_sets,
+        sorted_changes.textures
+    );
+}
+
+// only bytes 1 and 2 differ, the others are skipped by the sort
+static void check_raw_keys()
+{
+    std::mt19937 random{2};
+    std::vector<uint64_t> keys;
+    for (size_t i = 0; i < 5000; ++i)
+        keys.push_back(0xabcd000000000000ull | uint64_t(random() % 300) << 8 | 0x42);
+    render_queue_t queue;
+    for (size_t i = 0; i < keys.size(); ++i)
+    {
+        render_packet_t packet;
+        packet.range = {uint32_t(i), 1};
+        queue.push(keys[i], packet);
+    }
+    std::vector<uint32_t> order;
+    queue.drain([&](const render_packet_t& packet){
+        order.push_back(packet.range.offset);
+    });
+    std::vector<uint32_t> expected(keys.size());
+    for (size_t i = 0; i < expected.size(); ++i)
+        expected[i] = uint32_t(i);
+    std::stable_sort(
+        expected.begin(),
+        expected.end(),
+        [&](uint32_t x, uint32_t y){return keys[x] < keys[y];}
+    );
+    check(order == expected, "raw keys sort like a stable sort");
+}
+
+static void check_id_cap()
+{
+    render_queue_t queue;
+    bool capped = true;
+    for (uint64_t i = 0; i < 0x10010; ++i)
+        capped =
+            capped &&
+            queue.texture_id(fake_handle<VkImageView>(i + 1)) == std::min<uint64_t>(i, 0xffff);
+    check(capped, "ids count up and stop at 0xffff");
+    check(queue.texture_id(fake_handle<VkImageView>(6)) == 5, "ids stay stable");
+    queue.begin_frame();
+    check(queue.texture_id(fake_handle<VkImageView>(0x10000)) == 0, "begin_frame resets the ids");
+}
+
+int main()
+{
+    check_scene_order();
+    check_raw_keys();
+    check_id_cap();
+    constexpr size_t iterations = 100;
+    auto scene = make_scene(20000);
+    render_queue_t queue;
+    size_t num_drained = 0;
+    auto seconds = seconds_per_iteration(iterations, [&](size_t) {
+        queue.begin_frame();
+        push_scene(queue, scene);
+        queue.drain([&](const render_packet_t&){ ++num_drained; });
+    });
+    std::printf(
+        "%.1f ns per queued draw (%zu)\n",
+        seconds * 1e9 / scene.size(),
+        num_drained
+    );
+    return num_failures ? 1 : 0;
+}
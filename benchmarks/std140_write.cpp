@@ -0,0 +1,125 @@
+// std140 writes of a uniform block through the per member vectors
+// to_std140 used to build, against write_std140 with the layout known at
+// compile time. the layouts are checked below
+#include "benchmark_setup.hpp"
+
+#include <my_vulkan/helpers/to_std140.hpp>
+
+#include <boost/fusion/include/define_struct.hpp>
+
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+namespace bench
+{
+    typedef std::array<float, 3> float3_t;
+}
+
+BOOST_FUSION_DEFINE_STRUCT(
+    (bench), uniforms_t,
+    (float, scale)
+    (glm::vec3, position)
+    (glm::mat3, rotation)
+    (bench::float3_t, weights)
+    (int, mode)
+)
+
+BOOST_FUSION_DEFINE_STRUCT(
+    (bench), vertex_t,
+    (glm::vec3, position)
+    (float, weight)
+    (glm::vec2, uv)
+)
+
+BOOST_FUSION_DEFINE_STRUCT(
+    (bench), nested_t,
+    (float, x)
+    (bench::vertex_t, vertex)
+    (bench::float3_t, weights)
+    (glm::mat3, rotation)
+    (int, mode)
+)
+
+BOOST_FUSION_DEFINE_STRUCT((bench), empty_t, )
+
+template<typename T, block_layout_t layout>
+using offsets_of = block_layout_traits<T, layout>;
+
+static_assert(offsets_of<bench::uniforms_t, block_layout_t::std140>::offsets[0] == 0);
+static_assert(offsets_of<bench::uniforms_t, block_layout_t::std140>::offsets[1] == 16);
+static_assert(offsets_of<bench::uniforms_t, block_layout_t::std140>::offsets[2] == 32);
+static_assert(offsets_of<bench::uniforms_t, block_layout_t::std140>::offsets[3] == 80);
+static_assert(offsets_of<bench::uniforms_t, block_layout_t::std140>::offsets[4] == 128);
+static_assert(std140_size<bench::uniforms_t> == 144);
+// arrays keep their element stride and structs their member alignment
+static_assert(offsets_of<bench::uniforms_t, block_layout_t::std430>::offsets[3] == 80);
+static_assert(offsets_of<bench::uniforms_t, block_layout_t::std430>::offsets[4] == 92);
+static_assert(std430_size<bench::uniforms_t> == 96);
+
+// a float packs into the tail of a vec3
+static_assert(offsets_of<bench::vertex_t, block_layout_t::std140>::offsets[1] == 12);
+static_assert(offsets_of<bench::vertex_t, block_layout_t::std430>::offsets[2] == 16);
+static_assert(std140_size<bench::vertex_t> == 32);
+static_assert(std430_size<bench::vertex_t> == 32);
+
+static_assert(offsets_of<bench::nested_t, block_layout_t::std140>::offsets[1] == 16);
+static_assert(offsets_of<bench::nested_t, block_layout_t::std140>::offsets[2] == 48);
+static_assert(offsets_of<bench::nested_t, block_layout_t::std140>::offsets[3] == 96);
+static_assert(std140_size<bench::nested_t> == 160);
+static_assert(offsets_of<bench::nested_t, block_layout_t::std430>::offsets[2] == 48);
+static_assert(offsets_of<bench::nested_t, block_layout_t::std430>::offsets[3] == 64);
+static_assert(std430_size<bench::nested_t> == 128);
+
+static_assert(std140_size<bench::empty_t> == 0);
+
+// what to_std140 did for structs before the layouts were computed at
+// compile time, one vector per member and one for the result
+template<typename struct_t>
+static std::vector<char> member_wise_std140(const struct_t& the_struct)
+{
+    std::vector<char> result;
+    boost::fusion::for_each(
+        the_struct,
+        [&](auto v){
+            auto data = to_std140(v);
+            size_t aligned_size = roundedup(result.size(), data.align);
+            if (aligned_size > result.size())
+                result.resize(aligned_size);
+            result.insert(result.end(), data.data.begin(), data.data.end());
+        }
+    );
+    return result;
+}
+
+int main()
+{
+    constexpr size_t iterations = 1000000;
+    bench::uniforms_t uniforms;
+    uniforms.scale = 2;
+    uniforms.position = glm::vec3{1, 2, 3};
+    uniforms.rotation = glm::mat3{1};
+    uniforms.weights = {0.25f, 0.5f, 0.25f};
+    uniforms.mode = 1;
+    // stands in for mapped uniform memory
+    std::vector<char> destination(std140_size<bench::uniforms_t>);
+    size_t checksum = 0;
+    auto member_wise_seconds = seconds_per_iteration(iterations, [&](size_t i) {
+        uniforms.mode = int(i);
+        auto data = member_wise_std140(uniforms);
+        std::memcpy(destination.data(), data.data(), data.size());
+        checksum += size_t(destination[128]);
+    });
+    auto in_place_seconds = seconds_per_iteration(iterations, [&](size_t i) {
+        uniforms.mode = int(i);
+        write_std140(uniforms, destination.data());
+        checksum += size_t(destination[128]);
+    });
+    std::printf(
+        "member wise %.1f ns, in place %.1f ns per write (%zu)\n",
+        member_wise_seconds * 1e9,
+        in_place_seconds * 1e9,
+        checksum
+    );
+    return 0;
+}
@@ -246,7 +246,8 @@ public:
             readFile("26_shader_depth.frag"),
 #endif
             {},
-            true
+            true,
+            logical_device.load_pipeline_cache("pipeline_cache.bin").get()
     }
     , texture_view{texture_image.view(VK_IMAGE_ASPECT_COLOR_BIT)}
     , texture_sampler{
@@ -271,6 +272,11 @@ public:
         texture_sampler.get(),
         graphics_pipeline.uniform_layout()
     )}
+    , _gpu_profiler{std::make_unique<my_vulkan::gpu_profiler_t>(
+        logical_device,
+        logical_device.graphics_queue(),
+        swap_chain->depth()
+    )}
     {
     }
     
@@ -313,6 +319,7 @@ private:
     std::vector<my_vulkan::buffer_t> uniform_buffers;
     my_vulkan::descriptor_pool_t descriptor_pool;
     std::vector<my_vulkan::descriptor_set_t> descriptor_sets;
+    std::unique_ptr<my_vulkan::gpu_profiler_t> _gpu_profiler;
     std::string _title{"Vulkan-test"};
     size_t _nbframes{0};
     double  _lasttime{0.0f};
@@ -362,6 +369,9 @@ private:
 
             std::stringstream ss;
             ss << _title << " [" << fps << " FPS]";
+            for (auto& zone : _gpu_profiler->statistics())
+                ss << " [" << zone.name << " " << zone.avg_ms << " ms GPU]";
+            _gpu_profiler->reset_statistics();
 
             glfwSetWindowTitle(window, ss.str().c_str());
 
@@ -429,6 +439,11 @@ private:
         recreate_depth_image();
         create_renderpass();
         recreate_framebuffer();
+        _gpu_profiler = std::make_unique<my_vulkan::gpu_profiler_t>(
+            logical_device,
+            logical_device.graphics_queue(),
+            swap_chain->depth()
+        );
 
     }
     void recreate_depth_image()
@@ -643,14 +658,18 @@ private:
             return outcome.failure;
         auto& working_set = *outcome.working_set;
         updateUniformBuffer(logical_device.get(), working_set.phase());
-        draw_commands(
-            working_set.commands(),
-            vertex_buffer.get(),
-            graphics_pipeline,
-            index_buffer.get(),
-            descriptor_sets[working_set.phase()],
-            _frambuffers[working_set.phase()].get()
-        );
+        _gpu_profiler->begin_frame(working_set.phase(), working_set.commands());
+        {
+            auto zone = _gpu_profiler->zone(working_set.commands(), "scene");
+            draw_commands(
+                working_set.commands(),
+                vertex_buffer.get(),
+                graphics_pipeline,
+                index_buffer.get(),
+                descriptor_sets[working_set.phase()],
+                _frambuffers[working_set.phase()].get()
+            );
+        }
         return working_set.finish();
     }
 
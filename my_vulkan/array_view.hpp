@@ -0,0 +1,70 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <initializer_list>
+#include <vector>
+
+namespace my_vulkan
+{
+    // non owning view of contiguous elements for passing arrays to vulkan
+    // without copying them into a vector first. braced lists work as well,
+    // they live until the end of the full expression.
+    template<typename T>
+    struct array_view_t
+    {
+        array_view_t()
+        : _data{nullptr}
+        , _size{0}
+        {}
+        array_view_t(const T* data, size_t size)
+        : _data{data}
+        , _size{size}
+        {}
+        array_view_t(std::initializer_list<T> elements)
+        : _data{elements.begin()}
+        , _size{elements.size()}
+        {}
+        array_view_t(const std::vector<T>& elements)
+        : _data{elements.data()}
+        , _size{elements.size()}
+        {}
+        template<size_t n>
+        array_view_t(const std::array<T, n>& elements)
+        : _data{elements.data()}
+        , _size{n}
+        {}
+        template<size_t n>
+        array_view_t(const T (&elements)[n])
+        : _data{elements}
+        , _size{n}
+        {}
+        const T* data() const
+        {
+            return _data;
+        }
+        size_t size() const
+        {
+            return _size;
+        }
+        bool empty() const
+        {
+            return _size == 0;
+        }
+        const T* begin() const
+        {
+            return _data;
+        }
+        const T* end() const
+        {
+            return _data + _size;
+        }
+        const T& operator[](size_t i) const
+        {
+            return _data[i];
+        }
+    private:
+        const T* _data;
+        size_t _size;
+    };
+}
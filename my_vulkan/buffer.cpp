@@ -1,7 +1,9 @@
 #include "buffer.hpp"
  #include <memory>
+#include <cstring>
 
 #include "utils.hpp"
+#include "staging_ring.hpp"
 
 namespace my_vulkan
 {
@@ -15,6 +17,7 @@ namespace my_vulkan
     : buffer_t{
         device.get(),
         device.physical_device(),
+        &device,
         size,
         usage,
         properties,
@@ -33,8 +36,34 @@ namespace my_vulkan
         PFN_vkGetMemoryFdKHR pfn_vkGetMemoryFdKHR,
         std::optional<VkExternalMemoryHandleTypeFlags> external_handle_type
     )
+    : buffer_t{
+        device,
+        physical_device,
+        nullptr,
+        size,
+        usage,
+        properties,
+        pfn_vkGetMemoryFdKHR,
+        external_handle_type
+    }
+    {
+    }
+
+    buffer_t::buffer_t(
+        VkDevice device,
+        VkPhysicalDevice physical_device,
+        device_t* owner,
+        VkDeviceSize size,
+        VkBufferUsageFlags usage,
+        VkMemoryPropertyFlags properties,
+        PFN_vkGetMemoryFdKHR pfn_vkGetMemoryFdKHR,
+        std::optional<VkExternalMemoryHandleTypeFlags> external_handle_type
+    )
     : _device{device}
     , _physical_device{physical_device}
+    , _owner{owner}
+    // exported memory keeps its dedicated allocation
+    , _allocator{owner && !external_handle_type ? &owner->memory_allocator() : nullptr}
     , _size{size}
     , _fpGetMemoryFdKHR {pfn_vkGetMemoryFdKHR}
     {
@@ -56,17 +85,30 @@ namespace my_vulkan
             memRequirements.memoryTypeBits,
             properties
         );
-        _memory = std::make_unique<device_memory_t>(
-            _device,
-            device_memory_t::config_t {
-                .size = memRequirements.size,
-                .type_index = memory_type.index,
-                .external_handle_types=external_handle_type,
-                .pfn_vkGetMemoryFdKHR=_fpGetMemoryFdKHR
-            }
-        );
+        if (_allocator)
+        {
+            _memory = std::make_unique<device_memory_t>(
+                _device,
+                *_allocator,
+                memRequirements,
+                memory_type.index
+            );
+        }
+        else
+        {
+            _memory = std::make_unique<device_memory_t>(
+                _device,
+                device_memory_t::config_t {
+                    .size = memRequirements.size,
+                    .type_index = memory_type.index,
+                    .external_handle_types=external_handle_type,
+                    .pfn_vkGetMemoryFdKHR=_fpGetMemoryFdKHR,
+                    .property_flags=memory_type.properties
+                }
+            );
+        }
         _memory_properties = memory_type.properties;
-        vkBindBufferMemory(_device, _buffer, _memory->get(), 0);
+        vkBindBufferMemory(_device, _buffer, _memory->get(), _memory->offset());
     }
 
     VkMemoryPropertyFlags buffer_t::memory_properties() const
@@ -95,6 +137,9 @@ namespace my_vulkan
         cleanup();
         _buffer = other._buffer;
         _physical_device = other._physical_device;
+        _owner = other._owner;
+        _allocator = other._allocator;
+        _memory_properties = other._memory_properties;
         _memory = std::move(other._memory);
         std::swap(_device, other._device);
         std::swap(_size, other._size);
@@ -109,26 +154,37 @@ namespace my_vulkan
 
     void buffer_t::load_data(command_pool_t& command_pool, const void* data)
     {
-        buffer_t staging_buffer{
-            _device,
-            _physical_device,
-            _size,
-            VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-            nullptr
-        };
-        staging_buffer.memory()->set_data(data, _size);
-        my_vulkan::buffer_t result{
-            _device,
-            _physical_device,
-            _size,
-            VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT,
-            VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
-            nullptr
-        };
+        if (!_owner)
+        {
+            buffer_t staging_buffer{
+                _device,
+                _physical_device,
+                _size,
+                VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+                VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+                nullptr
+            };
+            staging_buffer.memory()->set_data(data, _size);
+            auto oneshot_scope = command_pool.begin_oneshot();
+            oneshot_scope.commands().copy(staging_buffer.get(), get(), {{0, 0, _size}});
+            oneshot_scope.execute_and_wait();
+            return;
+        }
+        auto& staging_ring = _owner->staging_ring();
+        auto staging = staging_ring.allocate(_size);
+        std::memcpy(staging.data, data, _size);
         auto oneshot_scope = command_pool.begin_oneshot();
-        oneshot_scope.commands().copy(staging_buffer.get(), get(), {{0, 0, _size}});
-        oneshot_scope.execute_and_wait();
+        oneshot_scope.commands().copy(staging.buffer, get(), {{staging.offset, 0, _size}});
+        auto submission = staging_ring.retire({staging});
+        try
+        {
+            oneshot_scope.execute_and_wait(submission.fence);
+        }
+        catch (...)
+        {
+            staging_ring.abandon(submission);
+            throw;
+        }
     }
 
     VkDeviceSize buffer_t::size() const
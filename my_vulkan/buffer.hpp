@@ -38,9 +38,21 @@ namespace my_vulkan
         void load_data(command_pool_t& command_pool, const void* data);
         ~buffer_t();
     private:
+        buffer_t(
+            VkDevice device,
+            VkPhysicalDevice physical_device,
+            device_t* owner,
+            VkDeviceSize size,
+            VkBufferUsageFlags usage,
+            VkMemoryPropertyFlags properties,
+            PFN_vkGetMemoryFdKHR pfn_vkGetMemoryFdKHR,
+            std::optional<VkExternalMemoryHandleTypeFlags> external_handle_type
+        );
         void cleanup();
         VkDevice _device;
         VkPhysicalDevice _physical_device;
+        device_t* _owner;
+        memory_allocator_t* _allocator;
         VkDeviceSize _size;
         VkBuffer _buffer;
         PFN_vkGetMemoryFdKHR _fpGetMemoryFdKHR;
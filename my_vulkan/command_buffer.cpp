@@ -1,9 +1,107 @@
 #include "command_buffer.hpp"
 #include "utils.hpp"
+#include <algorithm>
+#include <optional>
 #include <utility>
 
 namespace my_vulkan
 {
+    struct command_buffer_t::scope_t::state_cache_t
+    {
+        // only graphics and compute are tracked, other bind points
+        // always record
+        static constexpr size_t max_bind_points = 2;
+        static constexpr size_t max_sets = 8;
+        static constexpr size_t max_vertex_bindings = 16;
+        static constexpr size_t max_viewports = 16;
+        static constexpr size_t max_dynamic_offsets = 8;
+        struct bound_set_t
+        {
+            VkDescriptorSet set{VK_NULL_HANDLE};
+            uint32_t dynamic_offsets[max_dynamic_offsets]{};
+            size_t num_dynamic_offsets{0};
+        };
+        struct bind_point_t
+        {
+            VkPipeline pipeline{VK_NULL_HANDLE};
+            // the sets were bound with
+            VkPipelineLayout layout{VK_NULL_HANDLE};
+            bound_set_t sets[max_sets]{};
+        };
+        struct index_buffer_t
+        {
+            VkBuffer buffer;
+            VkDeviceSize offset;
+            VkIndexType type;
+        };
+        bind_point_t bind_points[max_bind_points];
+        std::optional<buffer_binding_t> vertex_buffers[max_vertex_bindings];
+        std::optional<index_buffer_t> index_buffer;
+        std::optional<VkViewport> viewports[max_viewports];
+        std::optional<VkRect2D> scissors[max_viewports];
+        skipped_commands_t skipped;
+        void invalidate()
+        {
+            *this = state_cache_t{skipped};
+        }
+        state_cache_t() = default;
+        explicit state_cache_t(skipped_commands_t skipped)
+        : skipped{skipped}
+        {}
+    };
+
+    static bool same(const VkViewport& x, const VkViewport& y)
+    {
+        return
+            x.x == y.x && x.y == y.y &&
+            x.width == y.width && x.height == y.height &&
+            x.minDepth == y.minDepth && x.maxDepth == y.maxDepth;
+    }
+
+    static bool same(const VkRect2D& x, const VkRect2D& y)
+    {
+        return
+            x.offset.x == y.offset.x && x.offset.y == y.offset.y &&
+            x.extent.width == y.extent.width && x.extent.height == y.extent.height;
+    }
+
+    static bool same(
+        const command_buffer_t::scope_t::buffer_binding_t& x,
+        const command_buffer_t::scope_t::buffer_binding_t& y
+    )
+    {
+        return x.buffer == y.buffer && x.offset == y.offset;
+    }
+
+    // true if every element is already in the cache, otherwise the cache
+    // is updated to the new elements
+    template<typename T, size_t n>
+    static bool update_cached(
+        std::optional<T> (&cache)[n],
+        uint32_t first,
+        array_view_t<T> elements
+    )
+    {
+        if (first + elements.size() > n)
+        {
+            // recorded but not tracked, forget what it overwrites
+            for (size_t i = first; i < n; ++i)
+                cache[i].reset();
+            return false;
+        }
+        bool unchanged = true;
+        for (size_t i = 0; i < elements.size(); ++i)
+        {
+            auto& entry = cache[first + i];
+            if (!entry || !same(*entry, elements[i]))
+            {
+                unchanged = false;
+                entry = elements[i];
+            }
+        }
+        return unchanged;
+    }
+
     command_buffer_t::command_buffer_t(
         VkDevice device,
         VkCommandPool command_pool,
@@ -53,6 +151,32 @@ namespace my_vulkan
         return scope_t{_command_buffer, flags};
     }
 
+    command_buffer_t::scope_t command_buffer_t::begin(
+        VkCommandBufferUsageFlags flags,
+        const VkCommandBufferInheritanceInfo& inheritance
+    )
+    {
+        return scope_t{_command_buffer, flags, &inheritance};
+    }
+
+    command_buffer_t::scope_t command_buffer_t::begin_secondary(
+        VkRenderPass render_pass,
+        uint32_t subpass,
+        VkFramebuffer framebuffer,
+        VkCommandBufferUsageFlags flags
+    )
+    {
+        VkCommandBufferInheritanceInfo inheritance = {};
+        inheritance.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+        inheritance.renderPass = render_pass;
+        inheritance.subpass = subpass;
+        inheritance.framebuffer = framebuffer;
+        return begin(
+            flags | VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT,
+            inheritance
+        );
+    }
+
     command_buffer_t::~command_buffer_t()
     {
         cleanup();
@@ -69,13 +193,15 @@ namespace my_vulkan
 
     command_buffer_t::scope_t::scope_t(
         VkCommandBuffer command_buffer,
-        VkCommandBufferUsageFlags flags
+        VkCommandBufferUsageFlags flags,
+        const VkCommandBufferInheritanceInfo* inheritance
     )
     : _command_buffer{command_buffer}
     {
         VkCommandBufferBeginInfo beginInfo = {};
         beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
         beginInfo.flags = flags;
+        beginInfo.pInheritanceInfo = inheritance;
         vk_require(
             vkBeginCommandBuffer(_command_buffer, &beginInfo),
             "begining command buffer recording"
@@ -94,14 +220,33 @@ namespace my_vulkan
     {
         end();
         std::swap(_command_buffer, other._command_buffer);
+        std::swap(_state, other._state);
         return *this;
     }
 
+    void command_buffer_t::scope_t::enable_state_cache()
+    {
+        if (!_state)
+            _state = std::make_unique<state_cache_t>();
+    }
+
+    void command_buffer_t::scope_t::invalidate_state()
+    {
+        if (_state)
+            _state->invalidate();
+    }
+
+    command_buffer_t::scope_t::skipped_commands_t
+    command_buffer_t::scope_t::skipped_commands() const
+    {
+        return _state ? _state->skipped : skipped_commands_t{};
+    }
+
     void command_buffer_t::scope_t::begin_render_pass(
         VkRenderPass renderPass,
         VkFramebuffer framebuffer,
         VkRect2D render_area,
-        std::vector<VkClearValue> clear_values,
+        array_view_t<VkClearValue> clear_values,
         VkSubpassContents contents
     )
     {
@@ -123,10 +268,15 @@ namespace my_vulkan
     }
 
     void command_buffer_t::scope_t::set_viewport(
-        std::vector<VkViewport> viewports,
+        array_view_t<VkViewport> viewports,
         uint32_t first
     )
     {
+        if (_state && update_cached(_state->viewports, first, viewports))
+        {
+            ++_state->skipped.viewports;
+            return;
+        }
         vkCmdSetViewport(
             _command_buffer,
             first,
@@ -136,10 +286,15 @@ namespace my_vulkan
     }
 
     void command_buffer_t::scope_t::set_scissor(
-        std::vector<VkRect2D> scissors,
+        array_view_t<VkRect2D> scissors,
         uint32_t first
     )
     {
+        if (_state && update_cached(_state->scissors, first, scissors))
+        {
+            ++_state->skipped.scissors;
+            return;
+        }
         vkCmdSetScissor(
             _command_buffer,
             first,
@@ -170,8 +325,8 @@ namespace my_vulkan
     // }
 
     void command_buffer_t::scope_t::clear(
-        std::vector<VkClearAttachment> attachements,
-        std::vector<VkClearRect> rects
+        array_view_t<VkClearAttachment> attachements,
+        array_view_t<VkClearRect> rects
     )
     {
         vkCmdClearAttachments(
@@ -189,11 +344,34 @@ namespace my_vulkan
         std::optional<VkRect2D> target_rect
     )
     {
-        vkCmdBindPipeline(
-            _command_buffer, 
-            bind_point, 
-            pipeline
-        );
+        auto cached = _state && bind_point < state_cache_t::max_bind_points ?
+            &_state->bind_points[bind_point] :
+            nullptr;
+        if (cached && cached->pipeline == pipeline)
+        {
+            ++_state->skipped.pipelines;
+        }
+        else
+        {
+            vkCmdBindPipeline(
+                _command_buffer, 
+                bind_point, 
+                pipeline
+            );
+            if (cached)
+            {
+                cached->pipeline = pipeline;
+                // a pipeline with static viewport state clobbers the
+                // dynamic one
+                if (bind_point == VK_PIPELINE_BIND_POINT_GRAPHICS)
+                {
+                    for (auto& viewport : _state->viewports)
+                        viewport.reset();
+                    for (auto& scissor : _state->scissors)
+                        scissor.reset();
+                }
+            }
+        }
         if (target_rect)
         {
             VkViewport viewport{
@@ -204,41 +382,42 @@ namespace my_vulkan
                 0,
                 1
             };
-            vkCmdSetViewport(
-                _command_buffer,
-                0,
-                1,
-                &viewport
-            );
-            vkCmdSetScissor(
-                _command_buffer,
-                0,
-                1,
-                &*target_rect
-            );
+            set_viewport({viewport});
+            set_scissor({*target_rect});
         }
     }
 
     void command_buffer_t::scope_t::bind_vertex_buffers(
-        std::vector<buffer_binding_t> bindings,
+        array_view_t<buffer_binding_t> bindings,
         uint32_t offset
     )
     {
-        // transpose AoS->SoA
-        std::vector<VkBuffer> buffers;
-        std::vector<VkDeviceSize> offsets;
-        for (size_t i = 0; i < bindings.size(); ++i)
+        if (_state && update_cached(_state->vertex_buffers, offset, bindings))
         {
-            buffers.push_back(bindings[i].buffer);
-            offsets.push_back(bindings[i].offset);
+            ++_state->skipped.vertex_buffers;
+            return;
+        }
+        // transpose AoS->SoA on the stack, in chunks if there are more
+        // bindings than the arrays hold
+        constexpr size_t chunk_size = 16;
+        VkBuffer buffers[chunk_size];
+        VkDeviceSize offsets[chunk_size];
+        for (size_t begin = 0; begin < bindings.size(); begin += chunk_size)
+        {
+            auto count = std::min(chunk_size, bindings.size() - begin);
+            for (size_t i = 0; i < count; ++i)
+            {
+                buffers[i] = bindings[begin + i].buffer;
+                offsets[i] = bindings[begin + i].offset;
+            }
+            vkCmdBindVertexBuffers(
+                _command_buffer,
+                offset + uint32_t(begin),
+                uint32_t(count),
+                buffers,
+                offsets
+            );
         }
-        vkCmdBindVertexBuffers(
-            _command_buffer,
-            offset,
-            uint32_t(bindings.size()),
-            buffers.data(),
-            offsets.data()
-        );
     }
 
     void command_buffer_t::scope_t::bind_index_buffer(
@@ -247,22 +426,91 @@ namespace my_vulkan
         size_t offset
     )
     {
+        if (_state)
+        {
+            auto& cached = _state->index_buffer;
+            if (
+                cached &&
+                cached->buffer == buffer &&
+                cached->offset == offset &&
+                cached->type == type
+            )
+            {
+                ++_state->skipped.index_buffers;
+                return;
+            }
+            cached = state_cache_t::index_buffer_t{buffer, offset, type};
+        }
         vkCmdBindIndexBuffer(_command_buffer, buffer, offset, type);        
     }
 
     void command_buffer_t::scope_t::bind_descriptor_set(
         VkPipelineBindPoint bind_point,
         VkPipelineLayout layout,
-        std::vector<VkDescriptorSet> descriptors,
-        uint32_t offset,
-        std::vector<uint32_t> dynamic_offset
+        array_view_t<VkDescriptorSet> descriptors,
+        uint32_t first_set,
+        array_view_t<uint32_t> dynamic_offset
     )
     {
+        auto cached = _state && bind_point < state_cache_t::max_bind_points ?
+            &_state->bind_points[bind_point] :
+            nullptr;
+        if (cached && first_set + descriptors.size() <= state_cache_t::max_sets)
+        {
+            // which offsets belong to which set is only known when a
+            // single set is bound
+            bool tracked =
+                descriptors.size() == 1 ?
+                dynamic_offset.size() <= state_cache_t::max_dynamic_offsets :
+                dynamic_offset.empty();
+            bool unchanged = tracked;
+            if (cached->layout != layout)
+            {
+                // compatibility of the layouts is not known, so every set
+                // of the bind point may be disturbed, not only later ones
+                unchanged = false;
+                *cached = state_cache_t::bind_point_t{cached->pipeline, layout};
+            }
+            for (size_t i = 0; i < descriptors.size(); ++i)
+            {
+                auto& bound = cached->sets[first_set + i];
+                unchanged =
+                    unchanged &&
+                    bound.set == descriptors[i] &&
+                    std::equal(
+                        dynamic_offset.begin(),
+                        dynamic_offset.end(),
+                        bound.dynamic_offsets,
+                        bound.dynamic_offsets + bound.num_dynamic_offsets
+                    );
+                // untracked offsets are rebound next time
+                bound = {};
+                if (tracked)
+                {
+                    bound.set = descriptors[i];
+                    std::copy(
+                        dynamic_offset.begin(),
+                        dynamic_offset.end(),
+                        bound.dynamic_offsets
+                    );
+                    bound.num_dynamic_offsets = dynamic_offset.size();
+                }
+            }
+            if (unchanged)
+            {
+                ++_state->skipped.descriptor_sets;
+                return;
+            }
+        }
+        else if (cached)
+        {
+            *cached = state_cache_t::bind_point_t{cached->pipeline};
+        }
         vkCmdBindDescriptorSets(
             _command_buffer,
             bind_point,
             layout,
-            0, 
+            first_set,
             static_cast<uint32_t>(descriptors.size()),
             descriptors.data(),
             static_cast<uint32_t>(dynamic_offset.size()),
@@ -284,6 +532,59 @@ namespace my_vulkan
         );
     }
 
+    void command_buffer_t::scope_t::draw_indirect(
+        VkBuffer buffer,
+        VkDeviceSize offset,
+        uint32_t draw_count,
+        uint32_t stride
+    )
+    {
+        vkCmdDrawIndirect(_command_buffer, buffer, offset, draw_count, stride);
+    }
+
+    void command_buffer_t::scope_t::draw_indexed_indirect(
+        VkBuffer buffer,
+        VkDeviceSize offset,
+        uint32_t draw_count,
+        uint32_t stride
+    )
+    {
+        vkCmdDrawIndexedIndirect(_command_buffer, buffer, offset, draw_count, stride);
+    }
+
+    void command_buffer_t::scope_t::dispatch(
+        uint32_t group_count_x,
+        uint32_t group_count_y,
+        uint32_t group_count_z
+    )
+    {
+        vkCmdDispatch(
+            _command_buffer,
+            group_count_x,
+            group_count_y,
+            group_count_z
+        );
+    }
+
+    void command_buffer_t::scope_t::dispatch_indirect(
+        VkBuffer buffer,
+        VkDeviceSize offset
+    )
+    {
+        vkCmdDispatchIndirect(_command_buffer, buffer, offset);
+    }
+
+    void command_buffer_t::scope_t::push_constants(
+        VkPipelineLayout layout,
+        VkShaderStageFlags stages,
+        uint32_t offset,
+        uint32_t size,
+        const void* data
+    )
+    {
+        vkCmdPushConstants(_command_buffer, layout, stages, offset, size, data);
+    }
+
     void command_buffer_t::scope_t::draw_indexed(
         index_range_t index_range,
         uint32_t vertex_offset,
@@ -308,14 +609,14 @@ namespace my_vulkan
     void command_buffer_t::scope_t::pipeline_barrier(
         VkPipelineStageFlags src_stage_mask,
         VkPipelineStageFlags dst_stage_mask,
-        std::vector<VkMemoryBarrier> barriers,
+        array_view_t<VkMemoryBarrier> barriers,
         VkDependencyFlags dependency_flags
     )
     {
         pipeline_barrier(
             src_stage_mask,
             dst_stage_mask,
-            std::move(barriers),
+            barriers,
             {},
             {},
             dependency_flags
@@ -325,7 +626,7 @@ namespace my_vulkan
     void command_buffer_t::scope_t::pipeline_barrier(
         VkPipelineStageFlags src_stage_mask,
         VkPipelineStageFlags dst_stage_mask,
-        std::vector<VkBufferMemoryBarrier> barriers,
+        array_view_t<VkBufferMemoryBarrier> barriers,
         VkDependencyFlags dependency_flags
     )
     {
@@ -333,7 +634,7 @@ namespace my_vulkan
             src_stage_mask,
             dst_stage_mask,
             {},
-            std::move(barriers),
+            barriers,
             {},
             dependency_flags
         );   
@@ -342,7 +643,7 @@ namespace my_vulkan
     void command_buffer_t::scope_t::pipeline_barrier(
         VkPipelineStageFlags src_stage_mask,
         VkPipelineStageFlags dst_stage_mask,
-        std::vector<VkImageMemoryBarrier> barriers,
+        array_view_t<VkImageMemoryBarrier> barriers,
         VkDependencyFlags dependency_flags
     )
     {
@@ -351,7 +652,7 @@ namespace my_vulkan
             dst_stage_mask,
             {},
             {},
-            std::move(barriers),
+            barriers,
             dependency_flags
         );   
     }
@@ -359,9 +660,9 @@ namespace my_vulkan
     void command_buffer_t::scope_t::pipeline_barrier(
         VkPipelineStageFlags src_stage_mask,
         VkPipelineStageFlags dst_stage_mask,
-        std::vector<VkMemoryBarrier> memory_barriers,
-        std::vector<VkBufferMemoryBarrier> buffer_barriers,
-        std::vector<VkImageMemoryBarrier> image_barriers,
+        array_view_t<VkMemoryBarrier> memory_barriers,
+        array_view_t<VkBufferMemoryBarrier> buffer_barriers,
+        array_view_t<VkImageMemoryBarrier> image_barriers,
         VkDependencyFlags dependency_flags
     )
     {
@@ -382,7 +683,7 @@ namespace my_vulkan
     void command_buffer_t::scope_t::copy(
         VkBuffer src,
         VkBuffer dst,
-        std::vector<VkBufferCopy> operations
+        array_view_t<VkBufferCopy> operations
     )
     {
         vkCmdCopyBuffer(
@@ -398,7 +699,7 @@ namespace my_vulkan
         VkBuffer src,
         VkImage dst,
         VkImageLayout dst_layout,
-        std::vector<VkBufferImageCopy> operations
+        array_view_t<VkBufferImageCopy> operations
     )
     {
         vkCmdCopyBufferToImage(
@@ -415,7 +716,7 @@ namespace my_vulkan
         VkImage src,
         VkBuffer dst,
         VkImageLayout src_layout,
-        std::vector<VkBufferImageCopy> operations
+        array_view_t<VkBufferImageCopy> operations
     )
     {
         vkCmdCopyImageToBuffer(
@@ -433,7 +734,7 @@ namespace my_vulkan
         VkImageLayout src_layout,
         VkImage dst,
         VkImageLayout dst_layout,
-        std::vector<VkImageCopy> operations
+        array_view_t<VkImageCopy> operations
     )
     {
         vkCmdCopyImage(
@@ -452,7 +753,7 @@ namespace my_vulkan
         VkImageLayout src_layout,
         VkImage dst,
         VkImageLayout dst_layout,
-        std::vector<VkImageBlit> operations,
+        array_view_t<VkImageBlit> operations,
         VkFilter filter
     )
     {
@@ -468,6 +769,39 @@ namespace my_vulkan
         );
     }
 
+    void command_buffer_t::scope_t::reset_query_pool(
+        VkQueryPool pool,
+        uint32_t first,
+        uint32_t count
+    )
+    {
+        vkCmdResetQueryPool(_command_buffer, pool, first, count);
+    }
+
+    void command_buffer_t::scope_t::write_timestamp(
+        VkPipelineStageFlagBits stage,
+        VkQueryPool pool,
+        uint32_t query
+    )
+    {
+        vkCmdWriteTimestamp(_command_buffer, stage, pool, query);
+    }
+
+    void command_buffer_t::scope_t::execute_commands(
+        array_view_t<VkCommandBuffer> command_buffers
+    )
+    {
+        if (command_buffers.empty())
+            return;
+        vkCmdExecuteCommands(
+            _command_buffer,
+            uint32_t(command_buffers.size()),
+            command_buffers.data()
+        );
+        // state is undefined after executing secondary command buffers
+        invalidate_state();
+    }
+
     command_buffer_t::scope_t::~scope_t()
     {
         end();
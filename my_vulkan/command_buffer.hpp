@@ -1,8 +1,10 @@
 #pragma once
 
 #include <vulkan/vulkan.h>
+#include <memory>
 #include <vector>
 #include "utils.hpp"
+#include "array_view.hpp"
 
 namespace my_vulkan
 {
@@ -12,7 +14,8 @@ namespace my_vulkan
         {
             scope_t(
                 VkCommandBuffer command_buffer,
-                VkCommandBufferUsageFlags flags
+                VkCommandBufferUsageFlags flags,
+                const VkCommandBufferInheritanceInfo* inheritance = nullptr
             );
             scope_t(const scope_t&) = delete;
             scope_t(scope_t&& other) noexcept;
@@ -24,30 +27,47 @@ namespace my_vulkan
                 VkBuffer buffer;
                 VkDeviceSize offset;
             };
+            // commands the state cache did not record because the state
+            // they set was already bound
+            struct skipped_commands_t
+            {
+                size_t pipelines{0};
+                size_t descriptor_sets{0};
+                size_t vertex_buffers{0};
+                size_t index_buffers{0};
+                size_t viewports{0};
+                size_t scissors{0};
+            };
+            // from now on skip binds and dynamic state that would not
+            // change anything
+            void enable_state_cache();
+            // after recording commands into the buffer without the scope
+            void invalidate_state();
+            skipped_commands_t skipped_commands() const;
 
             void begin_render_pass(
                 VkRenderPass renderPass,
                 VkFramebuffer framebuffer,
                 VkRect2D render_area,
-                std::vector<VkClearValue> clear_values = {},
+                array_view_t<VkClearValue> clear_values = {},
                 VkSubpassContents contents = VK_SUBPASS_CONTENTS_INLINE
             );
             void next_subpass(
                 VkSubpassContents contents = VK_SUBPASS_CONTENTS_INLINE
             );
             void set_viewport(
-                std::vector<VkViewport> viewports,
+                array_view_t<VkViewport> viewports,
                 uint32_t first = 0
             );
             void set_scissor(
-                std::vector<VkRect2D> scissors,
+                array_view_t<VkRect2D> scissors,
                 uint32_t first = 0
             );
             // void set_depth_test_enabled(bool enabled);
             // void set_blending_enabled(bool enabled);
             void clear(
-                std::vector<VkClearAttachment> attachements,
-                std::vector<VkClearRect> rects
+                array_view_t<VkClearAttachment> attachements,
+                array_view_t<VkClearRect> rects
             );
             void bind_pipeline(
                 VkPipelineBindPoint bind_point,
@@ -55,7 +75,7 @@ namespace my_vulkan
                 std::optional<VkRect2D> target_rect = std::nullopt
             );
             void bind_vertex_buffers(
-                std::vector<buffer_binding_t> bindings,
+                array_view_t<buffer_binding_t> bindings,
                 uint32_t offset = 0
             );
             void bind_index_buffer(
@@ -66,9 +86,9 @@ namespace my_vulkan
             void bind_descriptor_set(
                 VkPipelineBindPoint bind_point,
                 VkPipelineLayout    layout,
-                std::vector<VkDescriptorSet> descriptors,
-                uint32_t offset = 0,
-                std::vector<uint32_t> dynamic_offset = {}
+                array_view_t<VkDescriptorSet> descriptors,
+                uint32_t first_set = 0,
+                array_view_t<uint32_t> dynamic_offset = {}
             );
             void draw_indexed(
                 index_range_t index_range,
@@ -79,75 +99,136 @@ namespace my_vulkan
                 index_range_t index_range,
                 index_range_t instance_range = {0, 1}
             );
+            // draw_count commands read from buffer, more than one needs
+            // the multiDrawIndirect feature
+            void draw_indirect(
+                VkBuffer buffer,
+                VkDeviceSize offset,
+                uint32_t draw_count,
+                uint32_t stride = sizeof(VkDrawIndirectCommand)
+            );
+            void draw_indexed_indirect(
+                VkBuffer buffer,
+                VkDeviceSize offset,
+                uint32_t draw_count,
+                uint32_t stride = sizeof(VkDrawIndexedIndirectCommand)
+            );
+            // outside of a render pass
+            void dispatch(
+                uint32_t group_count_x,
+                uint32_t group_count_y = 1,
+                uint32_t group_count_z = 1
+            );
+            // buffer holds a VkDispatchIndirectCommand at offset
+            void dispatch_indirect(
+                VkBuffer buffer,
+                VkDeviceSize offset = 0
+            );
+            void push_constants(
+                VkPipelineLayout layout,
+                VkShaderStageFlags stages,
+                uint32_t offset,
+                uint32_t size,
+                const void* data
+            );
+            template<typename T>
+            void push_constants(
+                VkPipelineLayout layout,
+                VkShaderStageFlags stages,
+                const T& data,
+                uint32_t offset = 0
+            )
+            {
+                push_constants(layout, stages, offset, uint32_t(sizeof(T)), &data);
+            }
             void end_render_pass();
 
             void pipeline_barrier(
                 VkPipelineStageFlags src_stage_mask,
                 VkPipelineStageFlags dst_stage_mask,
-                std::vector<VkMemoryBarrier> barriers,
+                array_view_t<VkMemoryBarrier> barriers,
                 VkDependencyFlags dependency_flags = 0
             );
 
             void pipeline_barrier(
                 VkPipelineStageFlags src_stage_mask,
                 VkPipelineStageFlags dst_stage_mask,
-                std::vector<VkBufferMemoryBarrier> barriers,
+                array_view_t<VkBufferMemoryBarrier> barriers,
                 VkDependencyFlags dependency_flags = 0
             );
 
             void pipeline_barrier(
                 VkPipelineStageFlags src_stage_mask,
                 VkPipelineStageFlags dst_stage_mask,
-                std::vector<VkImageMemoryBarrier> barriers,
+                array_view_t<VkImageMemoryBarrier> barriers,
                 VkDependencyFlags dependency_flags = 0
             );
 
             void pipeline_barrier(
                 VkPipelineStageFlags src_stage_mask,
                 VkPipelineStageFlags dst_stage_mask,
-                std::vector<VkMemoryBarrier> memory_barriers,
-                std::vector<VkBufferMemoryBarrier> buffer_barriers,
-                std::vector<VkImageMemoryBarrier> image_barriers,
+                array_view_t<VkMemoryBarrier> memory_barriers,
+                array_view_t<VkBufferMemoryBarrier> buffer_barriers,
+                array_view_t<VkImageMemoryBarrier> image_barriers,
                 VkDependencyFlags dependency_flags = 0
             );
 
             void copy(
                 VkBuffer src,
                 VkBuffer dst,
-                std::vector<VkBufferCopy> operations
+                array_view_t<VkBufferCopy> operations
             );
             void copy(
                 VkBuffer src,
                 VkImage dst,
                 VkImageLayout dst_layout,
-                std::vector<VkBufferImageCopy> operations
+                array_view_t<VkBufferImageCopy> operations
             );
             void copy(
                 VkImage src,
                 VkBuffer dst,
                 VkImageLayout src_layout,
-                std::vector<VkBufferImageCopy> operations
+                array_view_t<VkBufferImageCopy> operations
             );
             void copy(
                 VkImage src,
                 VkImageLayout src_layout,
                 VkImage dst,
                 VkImageLayout dst_layout,
-                std::vector<VkImageCopy> operations
+                array_view_t<VkImageCopy> operations
             );
             void blit(
                 VkImage src,
                 VkImageLayout src_layout,
                 VkImage dst,
                 VkImageLayout dst_layout,
-                std::vector<VkImageBlit> operations,
+                array_view_t<VkImageBlit> operations,
                 VkFilter filter = VK_FILTER_NEAREST
             );
 
+            void reset_query_pool(
+                VkQueryPool pool,
+                uint32_t first,
+                uint32_t count
+            );
+            void write_timestamp(
+                VkPipelineStageFlagBits stage,
+                VkQueryPool pool,
+                uint32_t query
+            );
+
+            // the render pass has to be begun with
+            // VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS
+            void execute_commands(
+                array_view_t<VkCommandBuffer> command_buffers
+            );
+
             VkCommandBuffer end();
             ~scope_t();
         private:
+            struct state_cache_t;
             VkCommandBuffer _command_buffer{0};
+            std::unique_ptr<state_cache_t> _state;
         };
  
         command_buffer_t(
@@ -163,6 +244,18 @@ namespace my_vulkan
         VkCommandBuffer get();
         VkDevice device();
         scope_t begin(VkCommandBufferUsageFlags flags);
+        // for secondary command buffers
+        scope_t begin(
+            VkCommandBufferUsageFlags flags,
+            const VkCommandBufferInheritanceInfo& inheritance
+        );
+        // secondary command buffer continuing a subpass
+        scope_t begin_secondary(
+            VkRenderPass render_pass,
+            uint32_t subpass = 0,
+            VkFramebuffer framebuffer = VK_NULL_HANDLE,
+            VkCommandBufferUsageFlags flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT
+        );
         void reset();
     private:
         void cleanup();
@@ -2,6 +2,7 @@
 #include "utils.hpp"
 #include "fence.hpp"
 #include <utility>
+#include <limits>
 
 namespace my_vulkan
 {
@@ -17,12 +18,21 @@ namespace my_vulkan
         return _scope;
     }
 
-    void command_pool_t::one_time_scope_t::execute_and_wait()
+    void command_pool_t::one_time_scope_t::execute_and_wait(VkFence fence)
     {
         commands().end();
-        fence_t fence{_buffer.device()};
-        _queue->submit(_buffer.get(), fence.get());
-        fence.wait();
+        if (fence)
+        {
+            _queue->submit(_buffer.get(), fence);
+            vk_require(
+                vkWaitForFences(_buffer.device(), 1, &fence, VK_TRUE, std::numeric_limits<uint64_t>::max()),
+                "waiting for one time commands"
+            );
+            return;
+        }
+        fence_t temporary_fence{_buffer.device()};
+        _queue->submit(_buffer.get(), temporary_fence.get());
+        temporary_fence.wait();
     }
 
     command_pool_t::command_pool_t(
@@ -89,6 +99,14 @@ namespace my_vulkan
         return {*this};
     }
 
+    void command_pool_t::reset(VkCommandPoolResetFlags flags)
+    {
+        vk_require(
+            vkResetCommandPool(_device, _command_pool, flags),
+            "resetting command pool"
+        );
+    }
+
     void command_pool_t::cleanup()
     {
         if (_device)
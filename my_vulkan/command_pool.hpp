@@ -13,7 +13,8 @@ namespace my_vulkan
         {
             one_time_scope_t(command_pool_t& pool);
             command_buffer_t::scope_t& commands();
-            void execute_and_wait();
+            // fence: signaled by the submission instead of a temporary one
+            void execute_and_wait(VkFence fence = VK_NULL_HANDLE);
         private:
             command_buffer_t _buffer;
             command_buffer_t::scope_t _scope;
@@ -32,6 +33,8 @@ namespace my_vulkan
             VkCommandBufferLevel level = VK_COMMAND_BUFFER_LEVEL_PRIMARY
         );
         one_time_scope_t begin_oneshot();
+        // recycles all command buffers allocated from the pool at once
+        void reset(VkCommandPoolResetFlags flags = 0);
         queue_reference_t& queue();
         VkDevice device();
         ~command_pool_t();
@@ -0,0 +1,93 @@
+#include "command_pool_set.hpp"
+
+#include <stdexcept>
+
+namespace my_vulkan
+{
+    command_pool_set_t::command_pool_set_t(
+        VkDevice device,
+        queue_reference_t& queue,
+        size_t num_frames,
+        size_t num_threads
+    )
+    : _num_frames{num_frames}
+    , _num_threads{num_threads}
+    {
+        if (!num_frames || !num_threads)
+            throw std::invalid_argument{"command pool set needs frames and threads"};
+        for (size_t i = 0; i < num_frames * num_threads; ++i)
+            _pools.push_back({command_pool_t{device, queue}, {}, {}, 0, 0});
+    }
+
+    command_pool_set_t::slot_t& command_pool_set_t::entry(
+        size_t frame,
+        size_t thread
+    )
+    {
+        if (frame >= _num_frames || thread >= _num_threads)
+            throw std::out_of_range{"command pool set index out of range"};
+        return _pools[frame * _num_threads + thread];
+    }
+
+    void command_pool_set_t::begin_frame(size_t frame)
+    {
+        for (size_t thread = 0; thread < _num_threads; ++thread)
+        {
+            auto& slot = entry(frame, thread);
+            // one reset for all buffers instead of one per buffer
+            slot.pool.reset();
+            slot.used_primaries = 0;
+            slot.used_secondaries = 0;
+        }
+        _frame = frame;
+    }
+
+    command_buffer_t& command_pool_set_t::next(
+        slot_t& slot,
+        std::deque<command_buffer_t>& buffers,
+        size_t& used,
+        VkCommandBufferLevel level
+    )
+    {
+        if (used == buffers.size())
+            buffers.push_back(slot.pool.make_buffer(level));
+        return buffers[used++];
+    }
+
+    command_buffer_t& command_pool_set_t::primary(size_t thread)
+    {
+        auto& slot = entry(_frame, thread);
+        return next(
+            slot,
+            slot.primaries,
+            slot.used_primaries,
+            VK_COMMAND_BUFFER_LEVEL_PRIMARY
+        );
+    }
+
+    command_buffer_t& command_pool_set_t::secondary(size_t thread)
+    {
+        auto& slot = entry(_frame, thread);
+        return next(
+            slot,
+            slot.secondaries,
+            slot.used_secondaries,
+            VK_COMMAND_BUFFER_LEVEL_SECONDARY
+        );
+    }
+
+    command_pool_t& command_pool_set_t::pool(size_t frame, size_t thread)
+    {
+        return entry(frame, thread).pool;
+    }
+
+    size_t command_pool_set_t::num_frames() const
+    {
+        return _num_frames;
+    }
+
+    size_t command_pool_set_t::num_threads() const
+    {
+        return _num_threads;
+    }
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+#include <deque>
+
+#include "command_buffer.hpp"
+#include "command_pool.hpp"
+#include "queue.hpp"
+
+namespace my_vulkan
+{
+    // one command pool per frame in flight and recording thread. a thread
+    // only touches its own pools, so recording needs no locking.
+    struct command_pool_set_t
+    {
+        command_pool_set_t(
+            VkDevice device,
+            queue_reference_t& queue,
+            size_t num_frames,
+            size_t num_threads
+        );
+        command_pool_set_t(const command_pool_set_t&) = delete;
+        command_pool_set_t& operator=(const command_pool_set_t&) = delete;
+        // resets the pools of the frame and makes it the current one, the
+        // previous submission of the frame has to be complete
+        void begin_frame(size_t frame);
+        // command buffers of the current frame, valid until the frame
+        // comes around again
+        command_buffer_t& primary(size_t thread);
+        command_buffer_t& secondary(size_t thread);
+        command_pool_t& pool(size_t frame, size_t thread);
+        size_t num_frames() const;
+        size_t num_threads() const;
+    private:
+        struct slot_t
+        {
+            command_pool_t pool;
+            std::deque<command_buffer_t> primaries;
+            std::deque<command_buffer_t> secondaries;
+            size_t used_primaries;
+            size_t used_secondaries;
+        };
+        command_buffer_t& next(
+            slot_t& slot,
+            std::deque<command_buffer_t>& buffers,
+            size_t& used,
+            VkCommandBufferLevel level
+        );
+        slot_t& entry(size_t frame, size_t thread);
+        size_t _num_frames;
+        size_t _num_threads;
+        size_t _frame{0};
+        std::deque<slot_t> _pools;
+    };
+}
@@ -0,0 +1,162 @@
+#include "compute_pipeline.hpp"
+
+#include "utils.hpp"
+
+namespace my_vulkan
+{
+    VkDescriptorSetLayoutBinding storage_buffer_binding(
+        uint32_t binding,
+        VkShaderStageFlags stages,
+        uint32_t count
+    )
+    {
+        return {
+            binding,
+            VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+            count,
+            stages,
+            nullptr
+        };
+    }
+
+    VkDescriptorSetLayoutBinding storage_image_binding(
+        uint32_t binding,
+        VkShaderStageFlags stages,
+        uint32_t count
+    )
+    {
+        return {
+            binding,
+            VK_DESCRIPTOR_TYPE_STORAGE_IMAGE,
+            count,
+            stages,
+            nullptr
+        };
+    }
+
+    compute_pipeline_t::compute_pipeline_t(
+        VkDevice device,
+        const std::vector<VkDescriptorSetLayoutBinding>& uniform_layout,
+        const std::vector<uint8_t>& compute_shader,
+        const std::vector<VkPushConstantRange>& push_constant_ranges,
+        VkPipelineCache pipeline_cache,
+        const char* entry_point
+    )
+    : compute_pipeline_t{
+        device,
+        uniform_layout,
+        shader_module_t{
+            device,
+            compute_shader
+        },
+        push_constant_ranges,
+        pipeline_cache,
+        entry_point
+    }
+    {
+    }
+
+    compute_pipeline_t::compute_pipeline_t(
+        VkDevice device,
+        const std::vector<VkDescriptorSetLayoutBinding>& uniform_layout,
+        const shader_module_t& compute_shader,
+        const std::vector<VkPushConstantRange>& push_constant_ranges,
+        VkPipelineCache pipeline_cache,
+        const char* entry_point
+    )
+    : _device{device}
+    , _uniform_layout{uniform_layout.empty() ? nullptr : new descriptor_set_layout_t{_device, uniform_layout}}
+    {
+        VkPipelineLayoutCreateInfo layout_info = {};
+        layout_info.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+        VkDescriptorSetLayout set_layout = VK_NULL_HANDLE;
+        if (_uniform_layout)
+        {
+            set_layout = _uniform_layout->get();
+            layout_info.setLayoutCount = 1;
+            layout_info.pSetLayouts = &set_layout;
+        }
+        layout_info.pushConstantRangeCount = uint32_t(push_constant_ranges.size());
+        layout_info.pPushConstantRanges = push_constant_ranges.data();
+        vk_require(
+            vkCreatePipelineLayout(device, &layout_info, nullptr, &_layout),
+            "creating compute pipeline layout"
+        );
+
+        VkComputePipelineCreateInfo info = {};
+        info.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+        info.stage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+        info.stage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+        info.stage.module = compute_shader.get();
+        info.stage.pName = entry_point;
+        info.layout = _layout;
+        info.basePipelineHandle = VK_NULL_HANDLE;
+        auto result = vkCreateComputePipelines(
+            device,
+            pipeline_cache,
+            1,
+            &info,
+            nullptr,
+            &_pipeline
+        );
+        if (result != VK_SUCCESS)
+            vkDestroyPipelineLayout(device, _layout, nullptr);
+        vk_require(result, "creating compute pipeline");
+    }
+
+    compute_pipeline_t::compute_pipeline_t(compute_pipeline_t&& other) noexcept
+    : _device{other._device}
+    , _uniform_layout{std::move(other._uniform_layout)}
+    {
+        _pipeline = other._pipeline;
+        _layout = other._layout;
+        other._device = 0;
+    }
+
+    compute_pipeline_t& compute_pipeline_t::operator=(
+        compute_pipeline_t&& other
+    ) noexcept
+    {
+        cleanup();
+        _uniform_layout = std::move(other._uniform_layout);
+        _pipeline = other._pipeline;
+        _layout = other._layout;
+        std::swap(_device, other._device);
+        return *this;
+    }
+
+    compute_pipeline_t::~compute_pipeline_t()
+    {
+        cleanup();
+    }
+
+    void compute_pipeline_t::cleanup()
+    {
+        if (_device)
+        {
+            vkDestroyPipeline(_device, _pipeline, 0);
+            vkDestroyPipelineLayout(_device, _layout, 0);
+            _device = 0;
+        }
+    }
+
+    VkPipeline compute_pipeline_t::get()
+    {
+        return _pipeline;
+    }
+
+    VkPipelineLayout compute_pipeline_t::layout()
+    {
+        return _layout;
+    }
+
+    VkDescriptorSetLayout compute_pipeline_t::uniform_layout()
+    {
+        return _uniform_layout ? _uniform_layout->get() : nullptr;
+    }
+
+    VkDevice compute_pipeline_t::device()
+    {
+        return _device;
+    }
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+#include "descriptor_set_layout.hpp"
+#include "shader_module.hpp"
+
+#include <vector>
+#include <memory>
+
+namespace my_vulkan
+{
+    // layout bindings for the common compute resources
+    VkDescriptorSetLayoutBinding storage_buffer_binding(
+        uint32_t binding,
+        VkShaderStageFlags stages = VK_SHADER_STAGE_COMPUTE_BIT,
+        uint32_t count = 1
+    );
+    VkDescriptorSetLayoutBinding storage_image_binding(
+        uint32_t binding,
+        VkShaderStageFlags stages = VK_SHADER_STAGE_COMPUTE_BIT,
+        uint32_t count = 1
+    );
+
+    struct compute_pipeline_t
+    {
+        compute_pipeline_t(
+            VkDevice device,
+            const std::vector<VkDescriptorSetLayoutBinding>& uniform_layout,
+            const shader_module_t& compute_shader,
+            const std::vector<VkPushConstantRange>& push_constant_ranges = {},
+            VkPipelineCache pipeline_cache = VK_NULL_HANDLE,
+            const char* entry_point = "main"
+        );
+        compute_pipeline_t(
+            VkDevice device,
+            const std::vector<VkDescriptorSetLayoutBinding>& uniform_layout,
+            const std::vector<uint8_t>& compute_shader,
+            const std::vector<VkPushConstantRange>& push_constant_ranges = {},
+            VkPipelineCache pipeline_cache = VK_NULL_HANDLE,
+            const char* entry_point = "main"
+        );
+        compute_pipeline_t(const compute_pipeline_t&) = delete;
+        compute_pipeline_t(compute_pipeline_t&& other) noexcept;
+        compute_pipeline_t& operator=(const compute_pipeline_t&) = delete;
+        compute_pipeline_t& operator=(compute_pipeline_t&& other) noexcept;
+        VkPipeline get();
+        VkPipelineLayout layout();
+        VkDevice device();
+        VkDescriptorSetLayout uniform_layout();
+        ~compute_pipeline_t();
+    private:
+        void cleanup();
+        VkDevice _device;
+        std::unique_ptr<descriptor_set_layout_t> _uniform_layout;
+        VkPipeline _pipeline;
+        VkPipelineLayout _layout;
+    };
+}
@@ -0,0 +1,143 @@
+#include "descriptor_allocator.hpp"
+
+#include "utils.hpp"
+
+#include <algorithm>
+
+namespace my_vulkan
+{
+    descriptor_allocator_t::descriptor_allocator_t(
+        VkDevice device,
+        uint32_t initial_sets_per_pool,
+        uint32_t max_sets_per_pool
+    )
+    : _device{device}
+    , _sets_per_pool{std::max(initial_sets_per_pool, 1u)}
+    , _max_sets_per_pool{std::max(max_sets_per_pool, initial_sets_per_pool)}
+    {
+    }
+
+    auto descriptor_allocator_t::set_capacity(
+        const std::vector<VkDescriptorSetLayoutBinding>& bindings
+    ) -> capacity_t
+    {
+        capacity_t result;
+        result.sets = 1;
+        for (auto& binding : bindings)
+            result.descriptors[binding.descriptorType] += binding.descriptorCount;
+        return result;
+    }
+
+    bool descriptor_allocator_t::fits(
+        const capacity_t& needed,
+        const capacity_t& remaining
+    )
+    {
+        if (needed.sets > remaining.sets)
+            return false;
+        for (auto& entry : needed.descriptors)
+        {
+            auto left = remaining.descriptors.find(entry.first);
+            auto available = left == remaining.descriptors.end() ? 0 : left->second;
+            if (entry.second > available)
+                return false;
+        }
+        return true;
+    }
+
+    descriptor_set_t descriptor_allocator_t::allocate(
+        VkDescriptorSetLayout layout,
+        const std::vector<VkDescriptorSetLayoutBinding>& bindings
+    )
+    {
+        auto needed = set_capacity(bindings);
+        ++_num_sets;
+        for (auto& entry : needed.descriptors)
+            _num_descriptors[entry.first] += entry.second;
+        if (!_current || !fits(needed, _current->remaining))
+            next_pool(needed);
+        VkDescriptorSetAllocateInfo info = {};
+        info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+        info.descriptorPool = _current->pool.get();
+        info.descriptorSetCount = 1;
+        info.pSetLayouts = &layout;
+        VkDescriptorSet set = VK_NULL_HANDLE;
+        vk_require(
+            vkAllocateDescriptorSets(_device, &info, &set),
+            "allocating descriptor set"
+        );
+        auto& remaining = _current->remaining;
+        remaining.sets -= needed.sets;
+        for (auto& entry : needed.descriptors)
+            remaining.descriptors[entry.first] -= entry.second;
+        return {_device, set};
+    }
+
+    void descriptor_allocator_t::next_pool(const capacity_t& needed)
+    {
+        if (_current)
+            _full.push_back(std::move(*_current));
+        _current.reset();
+        // recycled pools may be sized for other sets, the ones this set
+        // does not fit are parked as full until the next reset
+        while (!_free.empty())
+        {
+            auto pool = std::move(_free.back());
+            _free.pop_back();
+            if (fits(needed, pool.remaining))
+            {
+                _current = std::move(pool);
+                return;
+            }
+            _full.push_back(std::move(pool));
+        }
+        _current = make_pool(needed);
+        _sets_per_pool = std::min(_sets_per_pool * 2, _max_sets_per_pool);
+    }
+
+    auto descriptor_allocator_t::make_pool(const capacity_t& needed) -> pool_t
+    {
+        capacity_t capacity;
+        capacity.sets = _sets_per_pool;
+        std::vector<VkDescriptorPoolSize> sizes;
+        for (auto& entry : _num_descriptors)
+        {
+            // average per set so far, rounded up, but always enough for
+            // the set that asked for the pool
+            auto average = (entry.second * _sets_per_pool + _num_sets - 1) / _num_sets;
+            auto per_set = needed.descriptors.find(entry.first);
+            auto count = std::max<size_t>(
+                average,
+                per_set == needed.descriptors.end() ? 0 : per_set->second
+            );
+            if (!count)
+                continue;
+            capacity.descriptors[entry.first] = count;
+            sizes.push_back({entry.first, uint32_t(count)});
+        }
+        return {
+            descriptor_pool_t{_device, sizes, _sets_per_pool, 0},
+            capacity,
+            capacity
+        };
+    }
+
+    void descriptor_allocator_t::reset()
+    {
+        if (_current)
+            _full.push_back(std::move(*_current));
+        _current.reset();
+        for (auto& pool : _full)
+        {
+            pool.pool.reset();
+            pool.remaining = pool.capacity;
+            _free.push_back(std::move(pool));
+        }
+        _full.clear();
+    }
+
+    size_t descriptor_allocator_t::num_pools() const
+    {
+        return (_current ? 1 : 0) + _full.size() + _free.size();
+    }
+}
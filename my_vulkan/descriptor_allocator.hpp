@@ -0,0 +1,69 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+#include <map>
+#include <optional>
+#include <vector>
+
+#include "descriptor_pool.hpp"
+#include "descriptor_set.hpp"
+
+namespace my_vulkan
+{
+    // hands out descriptor sets from a chain of pools that grows when the
+    // current pool runs out. pools are sized from the descriptors the sets
+    // allocated so far needed. sets are never freed one by one, reset()
+    // recycles every pool at once, e.g. with one allocator per frame in
+    // flight. not thread safe.
+    struct descriptor_allocator_t
+    {
+        explicit descriptor_allocator_t(
+            VkDevice device,
+            uint32_t initial_sets_per_pool = 16,
+            uint32_t max_sets_per_pool = 1024
+        );
+        descriptor_allocator_t(const descriptor_allocator_t&) = delete;
+        descriptor_allocator_t(descriptor_allocator_t&&) noexcept = default;
+        descriptor_allocator_t& operator=(const descriptor_allocator_t&) = delete;
+        descriptor_allocator_t& operator=(descriptor_allocator_t&&) noexcept = default;
+        // bindings are the ones layout was created with, the set stays
+        // valid until the next reset
+        descriptor_set_t allocate(
+            VkDescriptorSetLayout layout,
+            const std::vector<VkDescriptorSetLayoutBinding>& bindings
+        );
+        // invalidates all sets, the previous submission using them has to
+        // be complete
+        void reset();
+        size_t num_pools() const;
+    private:
+        struct capacity_t
+        {
+            size_t sets{0};
+            std::map<VkDescriptorType, size_t> descriptors;
+        };
+        // vulkan 1.0 without maintenance1 does not report a pool running
+        // out reliably, so what is left is counted here
+        struct pool_t
+        {
+            descriptor_pool_t pool;
+            capacity_t capacity;
+            capacity_t remaining;
+        };
+        static capacity_t set_capacity(
+            const std::vector<VkDescriptorSetLayoutBinding>& bindings
+        );
+        static bool fits(const capacity_t& needed, const capacity_t& remaining);
+        pool_t make_pool(const capacity_t& needed);
+        void next_pool(const capacity_t& needed);
+        VkDevice _device;
+        uint32_t _sets_per_pool;
+        uint32_t _max_sets_per_pool;
+        std::optional<pool_t> _current;
+        std::vector<pool_t> _full;
+        std::vector<pool_t> _free;
+        // descriptors of each type over all sets allocated so far
+        std::map<VkDescriptorType, size_t> _num_descriptors;
+        size_t _num_sets{0};
+    };
+}
@@ -9,7 +9,8 @@ namespace my_vulkan
     descriptor_pool_t::descriptor_pool_t(
         VkDevice device,
         std::vector<VkDescriptorPoolSize> pool_sizes,
-        size_t max_num_sets
+        size_t max_num_sets,
+        VkDescriptorPoolCreateFlags flags
     )
     : _device{device}
     {
@@ -23,7 +24,7 @@ namespace my_vulkan
         poolInfo.poolSizeCount = uint32_t(pool_sizes.size());
         poolInfo.pPoolSizes = pool_sizes.data();
         poolInfo.maxSets = uint32_t(max_num_sets);
-        poolInfo.flags = VK_DESCRIPTOR_POOL_CREATE_FREE_DESCRIPTOR_SET_BIT;
+        poolInfo.flags = flags;
         vk_require(
             vkCreateDescriptorPool(_device, &poolInfo, nullptr, &_descriptor_pool),
             "creating dexcriptor pool"
@@ -49,6 +50,14 @@ namespace my_vulkan
         return {_device, _descriptor_pool, layout};
     }
 
+    void descriptor_pool_t::reset()
+    {
+        vk_require(
+            vkResetDescriptorPool(_device, _descriptor_pool, 0),
+            "resetting descriptor pool"
+        );
+    }
+
     VkDescriptorPool descriptor_pool_t::get()
     {
         return _descriptor_pool;
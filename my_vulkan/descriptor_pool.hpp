@@ -11,7 +11,9 @@ namespace my_vulkan
         descriptor_pool_t(
             VkDevice device,
             std::vector<VkDescriptorPoolSize> pool_sizes,
-            size_t max_num_sets
+            size_t max_num_sets,
+            // without FREE_DESCRIPTOR_SET_BIT sets are only released by reset
+            VkDescriptorPoolCreateFlags flags = VK_DESCRIPTOR_POOL_CREATE_FREE_DESCRIPTOR_SET_BIT
         );
         descriptor_pool_t(const descriptor_pool_t&) = delete;
         descriptor_pool_t(descriptor_pool_t&& other) noexcept;
@@ -20,6 +22,8 @@ namespace my_vulkan
         ~descriptor_pool_t();
         VkDescriptorPool get();
         descriptor_set_t make_descriptor_set(VkDescriptorSetLayout layout);
+        // returns every set to the pool at once
+        void reset();
     private:
         void cleanup();
         VkDevice _device;
@@ -1,4 +1,5 @@
 #include "descriptor_set.hpp"
+#include "descriptor_update_template.hpp"
 #include "utils.hpp"
 
 #include <stdexcept>
@@ -24,6 +25,16 @@ namespace my_vulkan
         );
     }
 
+    descriptor_set_t::descriptor_set_t(
+        VkDevice device,
+        VkDescriptorSet set
+    )
+    : _device{device}
+    , _descriptor_pool{VK_NULL_HANDLE}
+    , _descriptor_set{set}
+    {
+    }
+
     void descriptor_set_t::update_sampler_write(
         uint32_t binding,
         std::vector<VkSampler> samplers,
@@ -152,6 +163,41 @@ namespace my_vulkan
         );
     }
 
+    void descriptor_set_t::update_storage_buffer_write(
+        uint32_t binding,
+        VkBuffer buffer,
+        VkDeviceSize offset,
+        VkDeviceSize range
+    )
+    {
+        update_buffer_write(
+            binding,
+            VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+            {{buffer, offset, range}}
+        );
+    }
+
+    void descriptor_set_t::update_storage_image_write(
+        uint32_t binding,
+        VkImageView view,
+        VkImageLayout layout
+    )
+    {
+        update_image_write(
+            binding,
+            VK_DESCRIPTOR_TYPE_STORAGE_IMAGE,
+            {{view, layout}}
+        );
+    }
+
+    void descriptor_set_t::update_with_template(
+        const descriptor_update_template_t& update_template,
+        const void* data
+    )
+    {
+        update_template.update(_descriptor_set, data);
+    }
+
     void descriptor_set_t::update_uniform_block_write(
         uint32_t binding,
         uint32_t offset,
@@ -236,12 +282,13 @@ namespace my_vulkan
     {
         if (_device)
         {
-            vkFreeDescriptorSets(
-                _device,
-                _descriptor_pool,
-                1,
-                &_descriptor_set
-            );
+            if (_descriptor_pool)
+                vkFreeDescriptorSets(
+                    _device,
+                    _descriptor_pool,
+                    1,
+                    &_descriptor_set
+                );
             _descriptor_set = 0;
             _device = 0;
         }
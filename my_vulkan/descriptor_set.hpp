@@ -4,6 +4,7 @@
 #include <vector>
 namespace my_vulkan
 {
+    struct descriptor_update_template_t;
     struct descriptor_set_t
     {
         descriptor_set_t(
@@ -11,6 +12,12 @@ namespace my_vulkan
             VkDescriptorPool pool,
             VkDescriptorSetLayout layout
         );
+        // wraps a set owned by a pool that is only reset as a whole, the
+        // set is not freed on destruction
+        descriptor_set_t(
+            VkDevice device,
+            VkDescriptorSet set
+        );
         descriptor_set_t(const descriptor_set_t&) = delete;
         descriptor_set_t(descriptor_set_t&& other) noexcept;
         descriptor_set_t& operator=(const descriptor_set_t&) = delete;
@@ -69,11 +76,30 @@ namespace my_vulkan
             std::vector<VkBufferView> buffer_views,
             uint32_t array_offset = 0
         );
+        // single VK_DESCRIPTOR_TYPE_STORAGE_BUFFER
+        void update_storage_buffer_write(
+            uint32_t binding,
+            VkBuffer buffer,
+            VkDeviceSize offset = 0,
+            VkDeviceSize range = VK_WHOLE_SIZE
+        );
+        // single VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, storage images are
+        // accessed in VK_IMAGE_LAYOUT_GENERAL
+        void update_storage_image_write(
+            uint32_t binding,
+            VkImageView view,
+            VkImageLayout layout = VK_IMAGE_LAYOUT_GENERAL
+        );
         void update_uniform_block_write(
             uint32_t binding,
             uint32_t offset,
             uint32_t size
         );
+        // every binding of the template in one call
+        void update_with_template(
+            const descriptor_update_template_t& update_template,
+            const void* data
+        );
         void update_copy_to(
             VkDescriptorSet target,
             uint32_t source_binding,
@@ -0,0 +1,156 @@
+#include "descriptor_update_template.hpp"
+
+#include "utils.hpp"
+
+#include <utility>
+
+namespace my_vulkan
+{
+    descriptor_update_template_t::descriptor_update_template_t(
+        device_t& device,
+        VkDescriptorSetLayout layout,
+        std::vector<VkDescriptorUpdateTemplateEntryKHR> entries
+    )
+    : _device{device.get()}
+    , _entries{std::move(entries)}
+    {
+        if (!device.descriptor_update_templates())
+            return;
+        auto fpCreate = device.get_proc_record_if_needed<
+            PFN_vkCreateDescriptorUpdateTemplateKHR
+        >("vkCreateDescriptorUpdateTemplateKHR");
+        _fpUpdate = device.get_proc_record_if_needed<
+            PFN_vkUpdateDescriptorSetWithTemplateKHR
+        >("vkUpdateDescriptorSetWithTemplateKHR");
+        _fpDestroy = device.get_proc_record_if_needed<
+            PFN_vkDestroyDescriptorUpdateTemplateKHR
+        >("vkDestroyDescriptorUpdateTemplateKHR");
+        if (!fpCreate || !_fpUpdate || !_fpDestroy)
+            throw std::runtime_error{"descriptor update template functions missing"};
+        VkDescriptorUpdateTemplateCreateInfoKHR info = {};
+        info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_UPDATE_TEMPLATE_CREATE_INFO_KHR;
+        info.descriptorUpdateEntryCount = uint32_t(_entries.size());
+        info.pDescriptorUpdateEntries = _entries.data();
+        info.templateType = VK_DESCRIPTOR_UPDATE_TEMPLATE_TYPE_DESCRIPTOR_SET_KHR;
+        info.descriptorSetLayout = layout;
+        vk_require(
+            fpCreate(_device, &info, nullptr, &_template),
+            "creating descriptor update template"
+        );
+    }
+
+    descriptor_update_template_t::descriptor_update_template_t(
+        descriptor_update_template_t&& other
+    ) noexcept
+    : _device{0}
+    {
+        *this = std::move(other);
+    }
+
+    descriptor_update_template_t& descriptor_update_template_t::operator=(
+        descriptor_update_template_t&& other
+    ) noexcept
+    {
+        cleanup();
+        _entries = std::move(other._entries);
+        _template = other._template;
+        _fpUpdate = other._fpUpdate;
+        _fpDestroy = other._fpDestroy;
+        other._template = VK_NULL_HANDLE;
+        std::swap(_device, other._device);
+        return *this;
+    }
+
+    descriptor_update_template_t::~descriptor_update_template_t()
+    {
+        cleanup();
+    }
+
+    void descriptor_update_template_t::cleanup()
+    {
+        if (_device && _template)
+            _fpDestroy(_device, _template, nullptr);
+        _template = VK_NULL_HANDLE;
+        _device = 0;
+    }
+
+    VkDescriptorUpdateTemplateKHR descriptor_update_template_t::get()
+    {
+        return _template;
+    }
+
+    void descriptor_update_template_t::update(
+        VkDescriptorSet set,
+        const void* data
+    ) const
+    {
+        if (_template)
+            _fpUpdate(_device, set, _template, data);
+        else
+            update_emulated(set, data);
+    }
+
+    void descriptor_update_template_t::update_emulated(
+        VkDescriptorSet set,
+        const void* data
+    ) const
+    {
+        auto bytes = static_cast<const uint8_t*>(data);
+        // reserved up front, the writes point into these
+        size_t num_descriptors = 0;
+        for (auto& entry : _entries)
+            num_descriptors += entry.descriptorCount;
+        std::vector<VkDescriptorImageInfo> images;
+        std::vector<VkDescriptorBufferInfo> buffers;
+        std::vector<VkBufferView> views;
+        images.reserve(num_descriptors);
+        buffers.reserve(num_descriptors);
+        views.reserve(num_descriptors);
+        std::vector<VkWriteDescriptorSet> writes;
+        writes.reserve(_entries.size());
+        for (auto& entry : _entries)
+        {
+            VkWriteDescriptorSet write = {};
+            write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+            write.dstSet = set;
+            write.dstBinding = entry.dstBinding;
+            write.dstArrayElement = entry.dstArrayElement;
+            write.descriptorType = entry.descriptorType;
+            write.descriptorCount = entry.descriptorCount;
+            auto at = [&](uint32_t i){
+                return bytes + entry.offset + i * entry.stride;
+            };
+            switch (entry.descriptorType)
+            {
+            case VK_DESCRIPTOR_TYPE_SAMPLER:
+            case VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER:
+            case VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE:
+            case VK_DESCRIPTOR_TYPE_STORAGE_IMAGE:
+            case VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT:
+                write.pImageInfo = images.data() + images.size();
+                for (uint32_t i = 0; i < entry.descriptorCount; ++i)
+                    images.push_back(*reinterpret_cast<const VkDescriptorImageInfo*>(at(i)));
+                break;
+            case VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER:
+            case VK_DESCRIPTOR_TYPE_STORAGE_TEXEL_BUFFER:
+                write.pTexelBufferView = views.data() + views.size();
+                for (uint32_t i = 0; i < entry.descriptorCount; ++i)
+                    views.push_back(*reinterpret_cast<const VkBufferView*>(at(i)));
+                break;
+            default:
+                write.pBufferInfo = buffers.data() + buffers.size();
+                for (uint32_t i = 0; i < entry.descriptorCount; ++i)
+                    buffers.push_back(*reinterpret_cast<const VkDescriptorBufferInfo*>(at(i)));
+                break;
+            }
+            writes.push_back(write);
+        }
+        vkUpdateDescriptorSets(
+            _device,
+            uint32_t(writes.size()),
+            writes.data(),
+            0,
+            nullptr
+        );
+    }
+}
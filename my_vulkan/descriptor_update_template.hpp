@@ -0,0 +1,41 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+#include <vector>
+
+#include "device.hpp"
+
+namespace my_vulkan
+{
+    // writes all bindings of a set from one packed struct with a single
+    // call. uses VK_KHR_descriptor_update_template when the device was
+    // created with it, otherwise the entries are turned into one
+    // vkUpdateDescriptorSets call.
+    struct descriptor_update_template_t
+    {
+        // entry offsets and strides point into the data passed to update,
+        // at each one sits a VkDescriptorImageInfo, VkDescriptorBufferInfo
+        // or VkBufferView depending on the descriptor type
+        descriptor_update_template_t(
+            device_t& device,
+            VkDescriptorSetLayout layout,
+            std::vector<VkDescriptorUpdateTemplateEntryKHR> entries
+        );
+        descriptor_update_template_t(const descriptor_update_template_t&) = delete;
+        descriptor_update_template_t(descriptor_update_template_t&& other) noexcept;
+        descriptor_update_template_t& operator=(const descriptor_update_template_t&) = delete;
+        descriptor_update_template_t& operator=(descriptor_update_template_t&& other) noexcept;
+        ~descriptor_update_template_t();
+        void update(VkDescriptorSet set, const void* data) const;
+        // null when emulated
+        VkDescriptorUpdateTemplateKHR get();
+    private:
+        void cleanup();
+        void update_emulated(VkDescriptorSet set, const void* data) const;
+        VkDevice _device;
+        std::vector<VkDescriptorUpdateTemplateEntryKHR> _entries;
+        VkDescriptorUpdateTemplateKHR _template{VK_NULL_HANDLE};
+        PFN_vkUpdateDescriptorSetWithTemplateKHR _fpUpdate{nullptr};
+        PFN_vkDestroyDescriptorUpdateTemplateKHR _fpDestroy{nullptr};
+    };
+}
@@ -1,5 +1,9 @@
 #include "device.hpp"
 #include "utils.hpp"
+#include "memory_allocator.hpp"
+#include "pipeline_cache.hpp"
+#include "pipeline_registry.hpp"
+#include "staging_ring.hpp"
 
 #include <boost/range/algorithm/find.hpp>
 #include <iostream>
@@ -14,6 +18,28 @@ namespace my_vulkan
         std::vector<const char*> validation_layers,
         std::vector<const char*> device_extensions        
     );
+    static bool has_extension(
+        const std::vector<const char*>& extensions,
+        const char* name
+    )
+    {
+        for (auto extension : extensions)
+            if (std::string{extension} == name)
+                return true;
+        return false;
+    }
+    static bool supports_multi_draw_indirect(VkPhysicalDevice physical_device)
+    {
+        VkPhysicalDeviceFeatures supported;
+        vkGetPhysicalDeviceFeatures(physical_device, &supported);
+        return supported.multiDrawIndirect == VK_TRUE;
+    }
+    static bool supports_draw_indirect_first_instance(VkPhysicalDevice physical_device)
+    {
+        VkPhysicalDeviceFeatures supported;
+        vkGetPhysicalDeviceFeatures(physical_device, &supported);
+        return supported.drawIndirectFirstInstance == VK_TRUE;
+    }
     device_t::device_t(
         VkPhysicalDevice physical_device,
         const instance_t& instance,
@@ -46,6 +72,22 @@ namespace my_vulkan
         device_extensions
     )}
     , _queue_indices{queue_indices}
+    , _timeline_semaphores{has_extension(
+        device_extensions,
+        VK_KHR_TIMELINE_SEMAPHORE_EXTENSION_NAME
+    )}
+    , _descriptor_update_templates{has_extension(
+        device_extensions,
+        VK_KHR_DESCRIPTOR_UPDATE_TEMPLATE_EXTENSION_NAME
+    )}
+    , _multi_draw_indirect{supports_multi_draw_indirect(physical_device)}
+    , _draw_indirect_first_instance{
+        supports_draw_indirect_first_instance(physical_device)
+    }
+    , _memory_allocator{std::make_unique<memory_allocator_t>(
+        _device,
+        physical_device
+    )}
     {
         auto unique_queue_indices = _queue_indices.unique_indices();
         for (auto i : unique_queue_indices)
@@ -86,6 +128,62 @@ namespace my_vulkan
         return _queue_indices;
     }
 
+    bool device_t::timeline_semaphores() const
+    {
+        return _timeline_semaphores;
+    }
+
+    bool device_t::descriptor_update_templates() const
+    {
+        return _descriptor_update_templates;
+    }
+
+    bool device_t::multi_draw_indirect() const
+    {
+        return _multi_draw_indirect;
+    }
+
+    bool device_t::draw_indirect_first_instance() const
+    {
+        return _draw_indirect_first_instance;
+    }
+
+    memory_allocator_t& device_t::memory_allocator()
+    {
+        return *_memory_allocator;
+    }
+
+    staging_ring_t& device_t::staging_ring()
+    {
+        std::unique_lock<std::mutex> lock{_staging_ring_mutex};
+        if (!_staging_ring)
+            _staging_ring = std::make_unique<staging_ring_t>(*this);
+        return *_staging_ring;
+    }
+
+    pipeline_cache_t& device_t::pipeline_cache()
+    {
+        std::unique_lock<std::mutex> lock{_pipeline_cache_mutex};
+        if (!_pipeline_cache)
+            _pipeline_cache = std::make_unique<pipeline_cache_t>(*this);
+        return *_pipeline_cache;
+    }
+
+    pipeline_cache_t& device_t::load_pipeline_cache(const std::string& path)
+    {
+        std::unique_lock<std::mutex> lock{_pipeline_cache_mutex};
+        _pipeline_cache = std::make_unique<pipeline_cache_t>(*this, path);
+        return *_pipeline_cache;
+    }
+
+    pipeline_registry_t& device_t::pipeline_registry()
+    {
+        std::unique_lock<std::mutex> lock{_pipeline_registry_mutex};
+        if (!_pipeline_registry)
+            _pipeline_registry = std::make_unique<pipeline_registry_t>(*this);
+        return *_pipeline_registry;
+    }
+
     queue_reference_t& device_t::graphics_queue()
     {
         if (!_graphics_queue)
@@ -127,11 +225,23 @@ namespace my_vulkan
         }
         VkPhysicalDeviceFeatures deviceFeatures = {};
         deviceFeatures.samplerAnisotropy = VK_TRUE;
+        deviceFeatures.multiDrawIndirect =
+            supports_multi_draw_indirect(physical_device);
+        deviceFeatures.drawIndirectFirstInstance =
+            supports_draw_indirect_first_instance(physical_device);
         VkDeviceCreateInfo createInfo = {};
         createInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
         createInfo.queueCreateInfoCount = static_cast<uint32_t>(queueCreateInfos.size());
         createInfo.pQueueCreateInfos = queueCreateInfos.data();
         createInfo.pEnabledFeatures = &deviceFeatures;
+        VkPhysicalDeviceTimelineSemaphoreFeaturesKHR timeline_features = {};
+        if (has_extension(device_extensions, VK_KHR_TIMELINE_SEMAPHORE_EXTENSION_NAME))
+        {
+            timeline_features.sType =
+                VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_TIMELINE_SEMAPHORE_FEATURES_KHR;
+            timeline_features.timelineSemaphore = VK_TRUE;
+            createInfo.pNext = &timeline_features;
+        }
         createInfo.enabledExtensionCount = static_cast<uint32_t>(device_extensions.size());
         createInfo.ppEnabledExtensionNames = device_extensions.data();
         createInfo.enabledLayerCount = static_cast<uint32_t>(validation_layers.size());
@@ -147,6 +257,10 @@ namespace my_vulkan
     device_t::~device_t()
     {
         std::cerr << "~device_t()" << this << "\n";
+        _staging_ring.reset();
+        _pipeline_registry.reset();
+        _pipeline_cache.reset();
+        _memory_allocator.reset();
         if (auto device = get())
             vkDestroyDevice(device, 0);
     }
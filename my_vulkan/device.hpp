@@ -9,9 +9,15 @@
 #include "utils.hpp"
 #include "instance.hpp"
 #include <map>
+#include <memory>
+#include <mutex>
 
 namespace my_vulkan
 {
+    struct memory_allocator_t;
+    struct pipeline_cache_t;
+    struct pipeline_registry_t;
+    struct staging_ring_t;
     struct device_t
     {
         device_t(
@@ -35,6 +41,24 @@ namespace my_vulkan
         queue_reference_t& present_queue();
         queue_reference_t& transfer_queue();
         queue_family_indices_t queue_indices();
+        // created with VK_KHR_timeline_semaphore enabled
+        bool timeline_semaphores() const;
+        // created with VK_KHR_descriptor_update_template enabled
+        bool descriptor_update_templates() const;
+        // enabled whenever the physical device supports it
+        bool multi_draw_indirect() const;
+        // enabled whenever the physical device supports it, without it
+        // indirect draws have to start at instance 0
+        bool draw_indirect_first_instance() const;
+        memory_allocator_t& memory_allocator();
+        // created on first use
+        staging_ring_t& staging_ring();
+        // in memory only unless load_pipeline_cache was called first
+        pipeline_cache_t& pipeline_cache();
+        // replaces the cache with one read from and saved back to path
+        pipeline_cache_t& load_pipeline_cache(const std::string& path);
+        // created on first use, shares pipelines with identical state
+        pipeline_registry_t& pipeline_registry();
         VkDevice get() const;
         std::optional<VkPhysicalDeviceIDProperties> physcial_device_id_properties() const;
         std::optional<vk_uuid_t> physical_device_uuid() const;
@@ -73,11 +97,22 @@ namespace my_vulkan
         std::optional<VkPhysicalDeviceIDProperties> _maybe_vkPhysicalDeviceIDProperties{std::nullopt};
         VkDevice _device;
         queue_family_indices_t _queue_indices;
+        bool _timeline_semaphores;
+        bool _descriptor_update_templates;
+        bool _multi_draw_indirect;
+        bool _draw_indirect_first_instance;
         std::vector<queue_reference_t> _queues;
         queue_reference_t* _graphics_queue{0};
         queue_reference_t* _present_queue{0};
         queue_reference_t* _transfer_queue{0};
         void fetch_physical_device_ID();
         std::map<std::string, PFN_vkVoidFunction> _loaded_procs;
+        std::unique_ptr<memory_allocator_t> _memory_allocator;
+        std::unique_ptr<staging_ring_t> _staging_ring;
+        std::mutex _staging_ring_mutex;
+        std::unique_ptr<pipeline_cache_t> _pipeline_cache;
+        std::mutex _pipeline_cache_mutex;
+        std::unique_ptr<pipeline_registry_t> _pipeline_registry;
+        std::mutex _pipeline_registry_mutex;
     };
 }
@@ -2,6 +2,7 @@
 
 #include <utility>
 #include <cstring>
+#include <stdexcept>
 
 #include "utils.hpp"
 #include "device.hpp"
@@ -36,6 +37,7 @@ namespace my_vulkan
     : _device {device}
     , _fpGetMemoryFdKHR {config.pfn_vkGetMemoryFdKHR}
     , _size{config.size}
+    , _property_flags{config.property_flags}
     {
         VkMemoryAllocateInfo info{
             VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO,
@@ -70,12 +72,38 @@ namespace my_vulkan
             ),
             "allocating device memory"
         );
+        if (_property_flags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT)
+        {
+            auto result = vkMapMemory(_device, _memory, 0, VK_WHOLE_SIZE, 0, &_mapped);
+            if (result != VK_SUCCESS)
+            {
+                vkFreeMemory(_device, _memory, 0);
+                vk_require(result, "mapping device memory");
+            }
+        }
         for (auto const &type: vk_ext_mem_handle_types_from_vkflag(config.external_handle_types))
         {
             record_external_handle(type);
         }
     }
 
+    device_memory_t::device_memory_t(
+        VkDevice device,
+        memory_allocator_t& allocator,
+        const VkMemoryRequirements& requirements,
+        uint32_t type_index,
+        bool linear
+    )
+    : _device{device}
+    , _size{requirements.size}
+    , _allocator{&allocator}
+    , _allocation{allocator.allocate(requirements, type_index, linear)}
+    , _property_flags{allocator.property_flags(type_index)}
+    , _mapped{_allocation.mapped}
+    {
+        _memory = _allocation.memory;
+    }
+
     device_memory_t::device_memory_t(device_memory_t&& other) noexcept
     : _device{nullptr}
     {
@@ -92,6 +120,10 @@ namespace my_vulkan
             _memory = other._memory;
             _size = other._size;
             _fpGetMemoryFdKHR = other._fpGetMemoryFdKHR;
+            _allocator = other._allocator;
+            _allocation = other._allocation;
+            _property_flags = other._property_flags;
+            _mapped = other._mapped;
             std::swap(_device, other._device);
             std::swap(_external_handles, other._external_handles);
         }
@@ -103,10 +135,87 @@ namespace my_vulkan
         return _size;
     }
 
-    void device_memory_t::set_data(const void* data, size_t size)
+    VkDeviceSize device_memory_t::offset() const
+    {
+        return _allocation.offset;
+    }
+
+    VkMemoryPropertyFlags device_memory_t::get_property_flags() const
     {
-        auto mapping = map();
-        std::memcpy(mapping.data(), data, size);
+        return _property_flags;
+    }
+
+    bool device_memory_t::coherent() const
+    {
+        return _property_flags & VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+    }
+
+    void* device_memory_t::mapped_data()
+    {
+        return _mapped;
+    }
+
+    void device_memory_t::set_data(const void* data, size_t size, VkDeviceSize offset)
+    {
+        if (!_mapped)
+        {
+            auto mapping = map(region_t{offset, size});
+            std::memcpy(mapping.data(), data, size);
+            return;
+        }
+        std::memcpy(static_cast<char*>(_mapped) + offset, data, size);
+        flush(region_t{offset, size});
+    }
+
+    VkMappedMemoryRange device_memory_t::mapped_range(region_t region) const
+    {
+        // nonCoherentAtomSize is at most 256, sub-allocations are aligned
+        // to at least that
+        constexpr VkDeviceSize atom_size = 256;
+        auto limit = _allocator ?
+            _allocation.offset + _allocation.size :
+            VkDeviceSize(_size);
+        auto begin = (_allocation.offset + region.offset) / atom_size * atom_size;
+        VkDeviceSize size = VK_WHOLE_SIZE;
+        if (region.size != VK_WHOLE_SIZE)
+        {
+            auto end = _allocation.offset + region.offset + region.size;
+            end = (end + atom_size - 1) / atom_size * atom_size;
+            if (end < limit)
+                size = end - begin;
+        }
+        // VK_WHOLE_SIZE would run into the neighbours of a sub-allocation
+        if (size == VK_WHOLE_SIZE && _allocator && limit % atom_size == 0)
+            size = limit - begin;
+        return {
+            VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE,
+            nullptr,
+            _memory,
+            begin,
+            size
+        };
+    }
+
+    void device_memory_t::flush(std::optional<region_t> region)
+    {
+        if (coherent())
+            return;
+        auto range = mapped_range(region.value_or(region_t{0, VK_WHOLE_SIZE}));
+        vk_require(
+            vkFlushMappedMemoryRanges(_device, 1, &range),
+            "flushing mapped memory"
+        );
+    }
+
+    void device_memory_t::invalidate(std::optional<region_t> region)
+    {
+        if (coherent())
+            return;
+        auto range = mapped_range(region.value_or(region_t{0, VK_WHOLE_SIZE}));
+        vk_require(
+            vkInvalidateMappedMemoryRanges(_device, 1, &range),
+            "invalidating mapped memory"
+        );
     }
 
     device_memory_t::mapping_t device_memory_t::map(
@@ -138,7 +247,17 @@ namespace my_vulkan
             }
             _external_handles.clear();
 
-            vkFreeMemory(_device, _memory, 0);
+            if (_allocator)
+            {
+                _allocator->free(_allocation);
+            }
+            else
+            {
+                if (_mapped)
+                    vkUnmapMemory(_device, _memory);
+                vkFreeMemory(_device, _memory, 0);
+            }
+            _mapped = nullptr;
             _device = nullptr;
         }
     }
@@ -203,35 +322,44 @@ namespace my_vulkan
     )
     : _memory(memory._memory)
     , _device{memory._device}
-    , _region{optional_region.value_or(region_t{0, VK_WHOLE_SIZE})}
     {
+        auto region = optional_region.value_or(region_t{0, VK_WHOLE_SIZE});
+        _range = memory.mapped_range(region);
+        _coherent = memory.coherent();
+        if (memory._mapped)
+        {
+            // host visible memory stays mapped for its whole lifetime,
+            // mapping it a second time is not allowed
+            _persistent = true;
+            _data = static_cast<char*>(memory._mapped) + region.offset;
+            return;
+        }
+        if (memory._allocator)
+            throw std::runtime_error{"mapping memory that is not host visible"};
+        // map the rounded range so flushing it stays inside the mapping
         vk_require(
             vkMapMemory(
                 _device,
                 _memory,
-                _region.offset,
-                _region.size, 
+                _range.offset,
+                _range.size, 
                 flags, 
                 &_data
             ),
             "mapping memory"
         );
+        _data = static_cast<char*>(_data) + (region.offset - _range.offset);
     }
 
     void device_memory_t::mapping_t::flush()
     {
-        VkMappedMemoryRange range{
-            VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE,
-            nullptr,
-            _memory,
-            _region.offset,
-            _region.size
-        };
+        if (_coherent)
+            return;
         vk_require(
             vkFlushMappedMemoryRanges(
                 _device,
                 1,
-                &range
+                &_range
             ),
             "flushing mapped memory"
         );
@@ -239,20 +367,15 @@ namespace my_vulkan
 
     void device_memory_t::mapping_t::invalidate()
     {
-        VkMappedMemoryRange range{
-            VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE,
-            0,
-            _memory,
-            _region.offset,
-            _region.size
-        };
+        if (_coherent)
+            return;
         vk_require(
             vkInvalidateMappedMemoryRanges(
                 _device,
                 1,
-                &range
+                &_range
             ),
-            "flushing mapped memory"
+            "invalidating mapped memory"
         );
     }
 
@@ -274,7 +397,9 @@ namespace my_vulkan
         cleanup();
         _data = other._data;
         _device = other._device;
-        _region = other._region;
+        _range = other._range;
+        _persistent = other._persistent;
+        _coherent = other._coherent;
         std::swap(_memory, other._memory);
         return *this;
     }
@@ -293,7 +418,8 @@ namespace my_vulkan
     {
         if (_memory)
         {
-            vkUnmapMemory(_device, _memory);
+            if (!_persistent)
+                vkUnmapMemory(_device, _memory);
             _memory = 0;   
         }
     }
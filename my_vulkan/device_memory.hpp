@@ -6,6 +6,7 @@
 #include <mutex>
 #include <map>
 #include "device.hpp"
+#include "memory_allocator.hpp"
 namespace my_vulkan
 {
     struct device_memory_t
@@ -42,7 +43,10 @@ namespace my_vulkan
             void* _data;
             VkDeviceMemory _memory{0};
             VkDevice _device;
-            region_t _region;
+            // rounded to nonCoherentAtomSize
+            VkMappedMemoryRange _range;
+            bool _persistent{false};
+            bool _coherent{false};
         };
         struct config_t
         {
@@ -50,6 +54,8 @@ namespace my_vulkan
             uint32_t type_index;
             std::optional<VkExternalMemoryHandleTypeFlags> external_handle_types;
             PFN_vkGetMemoryFdKHR pfn_vkGetMemoryFdKHR {nullptr};
+            // host visible memory is mapped once for its whole lifetime
+            VkMemoryPropertyFlags property_flags {0};
         };
         device_memory_t(
             VkDevice device,
@@ -59,6 +65,14 @@ namespace my_vulkan
             device_t& device,
             config_t config
         );
+        // sub-allocated from one of the allocator's blocks, bind at offset()
+        device_memory_t(
+            VkDevice device,
+            memory_allocator_t& allocator,
+            const VkMemoryRequirements& requirements,
+            uint32_t type_index,
+            bool linear = true
+        );
         device_memory_t(const device_memory_t&) = delete;
         device_memory_t(device_memory_t&& other) noexcept;
         device_memory_t& operator=(const device_memory_t&&) = delete;
@@ -69,19 +83,31 @@ namespace my_vulkan
             VkMemoryMapFlags flags = 0
         );
         size_t size() const;
+        VkDeviceSize offset() const;
         template<typename T>
-        void set_data(const std::vector<T>& data);
-        void set_data(const void* data, size_t size);
-        VkMemoryPropertyFlags get_property_flags();
+        void set_data(const std::vector<T>& data, VkDeviceSize offset = 0);
+        void set_data(const void* data, size_t size, VkDeviceSize offset = 0);
+        // only touch the driver for memory that is not host coherent
+        void flush(std::optional<region_t> region = std::nullopt);
+        void invalidate(std::optional<region_t> region = std::nullopt);
+        // null unless host visible
+        void* mapped_data();
+        VkMemoryPropertyFlags get_property_flags() const;
         VkDeviceMemory get();
         void record_external_handle(VkExternalMemoryHandleTypeFlagBits externalHandleType);
         std::optional<external_memory_info_t> external_info(VkExternalMemoryHandleTypeFlagBits externalHandleType) const;
     private:
         void cleanup();
+        VkMappedMemoryRange mapped_range(region_t region) const;
+        bool coherent() const;
         VkDevice _device{0};
         PFN_vkGetMemoryFdKHR _fpGetMemoryFdKHR{nullptr};
         VkDeviceMemory _memory{0};
         size_t _size;
+        memory_allocator_t* _allocator{nullptr};
+        memory_allocator_t::allocation_t _allocation;
+        VkMemoryPropertyFlags _property_flags{0};
+        void* _mapped{nullptr};
         mutable std::mutex _mutex;
         std::map<VkExternalMemoryHandleTypeFlagBits, int> _external_handles;
         std::optional<int> create_ext_fd(VkExternalMemoryHandleTypeFlagBits externalHandleType);
@@ -89,8 +115,8 @@ namespace my_vulkan
     };
 
     template<typename T>
-    void device_memory_t::set_data(const std::vector<T>& data)
+    void device_memory_t::set_data(const std::vector<T>& data, VkDeviceSize offset)
     {
-        set_data(data.data(), data.size() * sizeof(T));
+        set_data(data.data(), data.size() * sizeof(T), offset);
     }
 }
@@ -0,0 +1,215 @@
+#include "gpu_profiler.hpp"
+
+#include <algorithm>
+#include <utility>
+
+#include "utils.hpp"
+
+namespace my_vulkan
+{
+    gpu_profiler_t::zone_t::zone_t(
+        command_buffer_t::scope_t& commands,
+        VkQueryPool pool,
+        uint32_t end_query
+    )
+    : _commands{&commands}
+    , _pool{pool}
+    , _end_query{end_query}
+    {
+    }
+
+    gpu_profiler_t::zone_t::zone_t(zone_t&& other) noexcept
+    {
+        *this = std::move(other);
+    }
+
+    gpu_profiler_t::zone_t& gpu_profiler_t::zone_t::operator=(
+        zone_t&& other
+    ) noexcept
+    {
+        end();
+        std::swap(_commands, other._commands);
+        _pool = other._pool;
+        _end_query = other._end_query;
+        return *this;
+    }
+
+    gpu_profiler_t::zone_t::~zone_t()
+    {
+        end();
+    }
+
+    void gpu_profiler_t::zone_t::end()
+    {
+        if (!_commands)
+            return;
+        _commands->write_timestamp(
+            VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+            _pool,
+            _end_query
+        );
+        _commands = nullptr;
+    }
+
+    static uint32_t timestamp_valid_bits(
+        VkPhysicalDevice physical_device,
+        uint32_t family_index
+    )
+    {
+        uint32_t count = 0;
+        vkGetPhysicalDeviceQueueFamilyProperties(physical_device, &count, nullptr);
+        std::vector<VkQueueFamilyProperties> families(count);
+        vkGetPhysicalDeviceQueueFamilyProperties(
+            physical_device,
+            &count,
+            families.data()
+        );
+        return family_index < count ?
+            families[family_index].timestampValidBits :
+            0;
+    }
+
+    gpu_profiler_t::gpu_profiler_t(
+        device_t& device,
+        queue_reference_t& queue,
+        size_t num_frames,
+        uint32_t max_zones_per_frame
+    )
+    : _device{device.get()}
+    , _max_zones{max_zones_per_frame}
+    , _frames(num_frames)
+    {
+        VkPhysicalDeviceProperties properties;
+        vkGetPhysicalDeviceProperties(device.physical_device(), &properties);
+        // nanoseconds per tick, software drivers report it as well
+        _period_ms = double(properties.limits.timestampPeriod) * 1e-6;
+        auto valid_bits = timestamp_valid_bits(
+            device.physical_device(),
+            queue.family_index()
+        );
+        _timestamp_mask = valid_bits >= 64 ?
+            ~uint64_t(0) :
+            (uint64_t(1) << valid_bits) - 1;
+        if (!supported())
+            return;
+        for (auto& frame : _frames)
+        {
+            VkQueryPoolCreateInfo info = {};
+            info.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+            info.queryType = VK_QUERY_TYPE_TIMESTAMP;
+            info.queryCount = 2 * _max_zones;
+            vk_require(
+                vkCreateQueryPool(_device, &info, nullptr, &frame.pool),
+                "creating timestamp query pool"
+            );
+            frame.zones.reserve(_max_zones);
+        }
+        _results.resize(4 * _max_zones);
+    }
+
+    gpu_profiler_t::~gpu_profiler_t()
+    {
+        for (auto& frame : _frames)
+            if (frame.pool)
+                vkDestroyQueryPool(_device, frame.pool, nullptr);
+    }
+
+    bool gpu_profiler_t::supported() const
+    {
+        return _timestamp_mask != 0 && _period_ms > 0;
+    }
+
+    void gpu_profiler_t::begin_frame(
+        size_t frame_index,
+        command_buffer_t::scope_t& commands
+    )
+    {
+        auto& frame = _frames.at(frame_index);
+        _current = &frame;
+        if (!supported())
+            return;
+        collect(frame);
+        commands.reset_query_pool(frame.pool, 0, 2 * _max_zones);
+    }
+
+    gpu_profiler_t::zone_t gpu_profiler_t::zone(
+        command_buffer_t::scope_t& commands,
+        const std::string& name
+    )
+    {
+        if (!supported() || !_current || _current->zones.size() == _max_zones)
+            return {};
+        auto inserted = _name_indices.emplace(name, _accumulators.size());
+        if (inserted.second)
+            _accumulators.push_back({name});
+        auto query = uint32_t(2 * _current->zones.size());
+        _current->zones.push_back(inserted.first->second);
+        commands.write_timestamp(
+            VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+            _current->pool,
+            query
+        );
+        return {commands, _current->pool, query + 1};
+    }
+
+    void gpu_profiler_t::collect(frame_t& frame)
+    {
+        if (frame.zones.empty())
+            return;
+        auto num_queries = uint32_t(2 * frame.zones.size());
+        // value and availability for each query
+        auto result = vkGetQueryPoolResults(
+            _device,
+            frame.pool,
+            0,
+            num_queries,
+            _results.size() * sizeof(uint64_t),
+            _results.data(),
+            2 * sizeof(uint64_t),
+            VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WITH_AVAILABILITY_BIT
+        );
+        if (result != VK_NOT_READY)
+            vk_require(result, "reading timestamp queries");
+        for (size_t i = 0; i < frame.zones.size(); ++i)
+        {
+            auto begin = &_results[4 * i];
+            auto end = begin + 2;
+            // a zone whose end was never recorded stays unavailable
+            if (!begin[1] || !end[1])
+                continue;
+            auto ms = double((end[0] - begin[0]) & _timestamp_mask) * _period_ms;
+            auto& accumulator = _accumulators[frame.zones[i]];
+            accumulator.min_ms = accumulator.samples ?
+                std::min(accumulator.min_ms, ms) :
+                ms;
+            accumulator.max_ms = std::max(accumulator.max_ms, ms);
+            accumulator.total_ms += ms;
+            ++accumulator.samples;
+        }
+        frame.zones.clear();
+    }
+
+    std::vector<gpu_profiler_t::statistics_t> gpu_profiler_t::statistics() const
+    {
+        std::vector<statistics_t> result;
+        for (auto& accumulator : _accumulators)
+        {
+            if (!accumulator.samples)
+                continue;
+            result.push_back({
+                accumulator.name,
+                accumulator.samples,
+                accumulator.min_ms,
+                accumulator.total_ms / accumulator.samples,
+                accumulator.max_ms
+            });
+        }
+        return result;
+    }
+
+    void gpu_profiler_t::reset_statistics()
+    {
+        for (auto& accumulator : _accumulators)
+            accumulator = {accumulator.name};
+    }
+}
@@ -0,0 +1,94 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "command_buffer.hpp"
+#include "device.hpp"
+
+namespace my_vulkan
+{
+    // measures gpu time of named zones with timestamp queries, every frame
+    // in flight has its own query pool whose results are picked up when the
+    // frame comes around again, so reading them never waits for the gpu
+    class gpu_profiler_t
+    {
+    public:
+        struct statistics_t
+        {
+            std::string name;
+            size_t samples;
+            double min_ms;
+            double avg_ms;
+            double max_ms;
+        };
+        // writes the end timestamp when it goes out of scope
+        class zone_t
+        {
+        public:
+            zone_t() = default;
+            zone_t(
+                command_buffer_t::scope_t& commands,
+                VkQueryPool pool,
+                uint32_t end_query
+            );
+            zone_t(const zone_t&) = delete;
+            zone_t& operator=(const zone_t&) = delete;
+            zone_t(zone_t&& other) noexcept;
+            zone_t& operator=(zone_t&& other) noexcept;
+            ~zone_t();
+            void end();
+        private:
+            command_buffer_t::scope_t* _commands{nullptr};
+            VkQueryPool _pool{VK_NULL_HANDLE};
+            uint32_t _end_query{0};
+        };
+        gpu_profiler_t(
+            device_t& device,
+            queue_reference_t& queue,
+            size_t num_frames,
+            uint32_t max_zones_per_frame = 128
+        );
+        gpu_profiler_t(const gpu_profiler_t&) = delete;
+        gpu_profiler_t& operator=(const gpu_profiler_t&) = delete;
+        ~gpu_profiler_t();
+        // collects what the previous submission of the frame measured, that
+        // submission should be complete, and resets its queries. commands
+        // must be outside a render pass.
+        void begin_frame(size_t frame, command_buffer_t::scope_t& commands);
+        // does nothing without timestamp support or when the frame ran out
+        // of queries
+        zone_t zone(command_buffer_t::scope_t& commands, const std::string& name);
+        std::vector<statistics_t> statistics() const;
+        void reset_statistics();
+        // false if the queue family cannot write timestamps
+        bool supported() const;
+    private:
+        struct frame_t
+        {
+            VkQueryPool pool{VK_NULL_HANDLE};
+            // name index of each zone, zone i uses queries 2i and 2i + 1
+            std::vector<size_t> zones;
+        };
+        struct accumulator_t
+        {
+            std::string name;
+            size_t samples{0};
+            double min_ms{0};
+            double max_ms{0};
+            double total_ms{0};
+        };
+        void collect(frame_t& frame);
+        VkDevice _device;
+        uint32_t _max_zones;
+        double _period_ms;
+        uint64_t _timestamp_mask;
+        std::vector<frame_t> _frames;
+        frame_t* _current{nullptr};
+        std::unordered_map<std::string, size_t> _name_indices;
+        std::vector<accumulator_t> _accumulators;
+        std::vector<uint64_t> _results;
+    };
+}
@@ -17,7 +17,9 @@ namespace my_vulkan
         const std::vector<uint8_t>& vertex_shader,
         const std::vector<uint8_t>& fragment_shader,
         render_settings_t settings,
-        bool dynamic_viewport
+        bool dynamic_viewport,
+        VkPipelineCache pipeline_cache,
+        const std::vector<VkPushConstantRange>& push_constant_ranges
     )
     : graphics_pipeline_t{
         device,
@@ -35,7 +37,9 @@ namespace my_vulkan
             fragment_shader
         },
         settings,
-        dynamic_viewport
+        dynamic_viewport,
+        pipeline_cache,
+        push_constant_ranges
     }
     {
     }
@@ -50,7 +54,9 @@ namespace my_vulkan
         const shader_module_t& vertex_shader,
         const shader_module_t& fragment_shader,
         render_settings_t settings,
-        bool dynamic_viewport
+        bool dynamic_viewport,
+        VkPipelineCache pipeline_cache,
+        const std::vector<VkPushConstantRange>& push_constant_ranges
     )
     : _device{device}
     , _uniform_layout{uniform_layout.empty() ? nullptr : new descriptor_set_layout_t{_device, uniform_layout}}
@@ -69,6 +75,8 @@ namespace my_vulkan
             pipelineLayoutInfo.setLayoutCount = 0;
             pipelineLayoutInfo.pSetLayouts = nullptr;
         }
+        pipelineLayoutInfo.pushConstantRangeCount = uint32_t(push_constant_ranges.size());
+        pipelineLayoutInfo.pPushConstantRanges = push_constant_ranges.data();
 
         vk_require(
             vkCreatePipelineLayout(device, &pipelineLayoutInfo, nullptr, &_layout),
@@ -187,12 +195,21 @@ namespace my_vulkan
         inputAssembly.topology = settings.topology;
         inputAssembly.primitiveRestartEnable = VK_FALSE;
 
+        std::vector<VkVertexInputBindingDescription> vertex_bindings{
+            vertex_layout.binding
+        };
+        vertex_bindings.insert(
+            vertex_bindings.end(),
+            vertex_layout.extra_bindings.begin(),
+            vertex_layout.extra_bindings.end()
+        );
         VkPipelineVertexInputStateCreateInfo vertexInputInfo = {};
         vertexInputInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
-        vertexInputInfo.vertexBindingDescriptionCount = 1;
+        vertexInputInfo.vertexBindingDescriptionCount =
+            static_cast<uint32_t>(vertex_bindings.size());
         vertexInputInfo.vertexAttributeDescriptionCount =
             static_cast<uint32_t>(vertex_layout.attributes.size());
-        vertexInputInfo.pVertexBindingDescriptions = &vertex_layout.binding;
+        vertexInputInfo.pVertexBindingDescriptions = vertex_bindings.data();
         vertexInputInfo.pVertexAttributeDescriptions =
             vertex_layout.attributes.data();
 
@@ -234,7 +251,7 @@ namespace my_vulkan
         vk_require(
             vkCreateGraphicsPipelines(
                 device,
-                VK_NULL_HANDLE,
+                pipeline_cache,
                 1,
                 &pipelineInfo,
                 nullptr,
@@ -14,6 +14,8 @@ namespace my_vulkan
     {
         VkVertexInputBindingDescription binding;
         std::vector<VkVertexInputAttributeDescription> attributes;
+        // e.g. per instance data, attributes refer to them by binding
+        std::vector<VkVertexInputBindingDescription> extra_bindings{};
     };
     enum class blending_t
     {
@@ -41,7 +43,9 @@ namespace my_vulkan
             const shader_module_t& vertex_shader,
             const shader_module_t& fragment_shader,
             render_settings_t settings = {},
-            bool dynamic_viewport = false
+            bool dynamic_viewport = false,
+            VkPipelineCache pipeline_cache = VK_NULL_HANDLE,
+            const std::vector<VkPushConstantRange>& push_constant_ranges = {}
         );
         graphics_pipeline_t(
             VkDevice device,
@@ -53,7 +57,9 @@ namespace my_vulkan
             const std::vector<uint8_t>& vertex_shader,
             const std::vector<uint8_t>& fragment_shader,
             render_settings_t settings = {},
-            bool dynamic_viewport = false
+            bool dynamic_viewport = false,
+            VkPipelineCache pipeline_cache = VK_NULL_HANDLE,
+            const std::vector<VkPushConstantRange>& push_constant_ranges = {}
         );
         graphics_pipeline_t(const graphics_pipeline_t&) = delete;
         graphics_pipeline_t(graphics_pipeline_t&& other) noexcept;
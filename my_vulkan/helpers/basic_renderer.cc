@@ -9,6 +9,8 @@
 
 #include <glm/glm.hpp>
 
+#include <cstddef>
+
 inline VkFormat vertex_format_with_components(float, size_t num_components)
 {
     switch(num_components)
@@ -20,7 +22,7 @@ inline VkFormat vertex_format_with_components(float, size_t num_components)
         case 3:
             return VK_FORMAT_R32G32B32_SFLOAT;
         case 4:
-            return VK_FORMAT_R32G32B32_SFLOAT;
+            return VK_FORMAT_R32G32B32A32_SFLOAT;
     }
     return VK_FORMAT_UNDEFINED;
 }
@@ -36,17 +38,21 @@ inline VkFormat vertex_format_for_attribute(attribute_t)
 
 template<typename vertex_t>
 inline std::vector<VkVertexInputAttributeDescription>
-make_vertex_attribute_descriptions(vertex_t prototype)
+make_vertex_attribute_descriptions(
+    vertex_t prototype,
+    uint32_t binding = 0,
+    uint32_t first_location = 0
+)
 {
     std::vector<VkVertexInputAttributeDescription> result;
-    uint32_t i = 0;
+    uint32_t i = first_location;
     boost::fusion::for_each(
         prototype,
         [&](const auto& attribute)
         {
             result.push_back(VkVertexInputAttributeDescription{
                 i++, // assign to locations, not bindings
-                0,
+                binding,
                 vertex_format_for_attribute(attribute),
                 uint32_t(
                     reinterpret_cast<const char*>(std::addressof(attribute)) -
@@ -62,10 +68,14 @@ namespace glm
 {
     template<typename component_t>
     static std::vector<VkVertexInputAttributeDescription>
-    make_vertex_attribute_descriptions(tvec1<component_t> attribute)
+    make_vertex_attribute_descriptions(
+        tvec1<component_t> attribute,
+        uint32_t binding = 0,
+        uint32_t first_location = 0
+    )
     {
         return {{
-            0, 0,
+            first_location, binding,
             vertex_format_for_attribute(attribute),
             0
         }};
@@ -73,10 +83,14 @@ namespace glm
 
     template<typename component_t>
     static std::vector<VkVertexInputAttributeDescription>
-    make_vertex_attribute_descriptions(tvec2<component_t> attribute)
+    make_vertex_attribute_descriptions(
+        tvec2<component_t> attribute,
+        uint32_t binding = 0,
+        uint32_t first_location = 0
+    )
     {
         return {{
-            0, 0,
+            first_location, binding,
             vertex_format_for_attribute(attribute),
             0
         }};
@@ -84,10 +98,14 @@ namespace glm
 
     template<typename component_t>
     static std::vector<VkVertexInputAttributeDescription>
-    make_vertex_attribute_descriptions(tvec3<component_t> attribute)
+    make_vertex_attribute_descriptions(
+        tvec3<component_t> attribute,
+        uint32_t binding = 0,
+        uint32_t first_location = 0
+    )
     {
         return {{
-            0, 0,
+            first_location, binding,
             vertex_format_for_attribute(attribute),
             0
         }};
@@ -95,57 +113,246 @@ namespace glm
 
     template<typename component_t>
     static std::vector<VkVertexInputAttributeDescription>
-    make_vertex_attribute_descriptions(tvec4<component_t> attribute)
+    make_vertex_attribute_descriptions(
+        tvec4<component_t> attribute,
+        uint32_t binding = 0,
+        uint32_t first_location = 0
+    )
     {
         return {{
-            0, 0,
+            first_location, binding,
             vertex_format_for_attribute(attribute),
             0
         }};
     }
 }
 
-inline size_t round_to_multiple_of_16(size_t n)
-{
-    return 16 * ((n + 15) / 16);
-}
-
 namespace my_vulkan
 {
+    inline VkMemoryPropertyFlags geometry_memory_properties(
+        VkPhysicalDevice physical_device,
+        geometry_usage_t usage
+    )
+    {
+        constexpr VkMemoryPropertyFlags host_visible =
+            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
+            VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+        switch (usage)
+        {
+        case geometry_usage_t::static_draw:
+            return VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+        case geometry_usage_t::stream_draw:
+        {
+            // device local memory the host can write to keeps the vertex
+            // fetch off the bus. only asked for explicitly, on discrete
+            // devices the heap is small and shared with everybody
+            VkPhysicalDeviceMemoryProperties properties;
+            vkGetPhysicalDeviceMemoryProperties(physical_device, &properties);
+            auto preferred = host_visible | VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+            for (uint32_t i = 0; i < properties.memoryTypeCount; ++i)
+                if ((properties.memoryTypes[i].propertyFlags & preferred) == preferred)
+                    return preferred;
+            return host_visible;
+        }
+        default:
+            return host_visible;
+        }
+    }
+
     template<
         typename vertex_uniforms_t,
         typename fragment_uniforms_t,
         typename vertex_t,
         size_t num_textures,
-        size_t num_input_attachments
+        size_t num_input_attachments,
+        typename push_constants_t,
+        typename instance_t
     > basic_renderer_t<
         vertex_uniforms_t,
         fragment_uniforms_t,
         vertex_t,
         num_textures,
-        num_input_attachments
+        num_input_attachments,
+        push_constants_t,
+        instance_t
     >::basic_renderer_t(
         output_config_t output_config,
         const basic_renderer_shader_modules_t& shaders,
         render_settings_t render_settings
     )
+    : basic_renderer_t{
+        output_config,
+        output_config.device->pipeline_registry().graphics_pipeline(
+            pipeline_description(output_config, render_settings),
+            shaders.vertex_shader,
+            shaders.fragment_shader
+        ),
+        render_settings
+    }
+    {
+    }
+
+    template<
+        typename vertex_uniforms_t,
+        typename fragment_uniforms_t,
+        typename vertex_t,
+        size_t num_textures,
+        size_t num_input_attachments,
+        typename push_constants_t,
+        typename instance_t
+    > basic_renderer_t<
+        vertex_uniforms_t,
+        fragment_uniforms_t,
+        vertex_t,
+        num_textures,
+        num_input_attachments,
+        push_constants_t,
+        instance_t
+    >::basic_renderer_t(
+        output_config_t output_config,
+        std::shared_ptr<graphics_pipeline_t> graphics_pipeline,
+        render_settings_t render_settings
+    )
     : _device{output_config.device}
-    , _uniform_layout{make_uniform_layout()}
     , _render_settings{render_settings}
     , _dynamic_viewport{output_config.dynamic_viewport}
-    , _graphics_pipeline{
-        output_config.device->get(),
-        output_config.extent,
-        output_config.render_pass,
-        output_config.subpass,
-        _uniform_layout,
-        make_vertex_layout(),
-        shaders.vertex_shader,
-        shaders.fragment_shader,
-        _render_settings,
-        _dynamic_viewport
+    , _graphics_pipeline{std::move(graphics_pipeline)}
+    , _descriptor_allocator{output_config.device->get()}
+    , _uniform_ring{std::make_unique<uniform_ring_t>(*output_config.device)}
+    , _indirect_ring{std::make_unique<uniform_ring_t>(
+        *output_config.device,
+        uniform_ring_t::default_block_size,
+        VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT
+    )}
+    {
+        if (_device->multi_draw_indirect())
+        {
+            VkPhysicalDeviceProperties properties;
+            vkGetPhysicalDeviceProperties(_device->physical_device(), &properties);
+            _max_draw_indirect_count = properties.limits.maxDrawIndirectCount;
+        }
+        if (auto layout = _graphics_pipeline->uniform_layout())
+            _update_template = std::make_unique<descriptor_update_template_t>(
+                *_device,
+                layout,
+                make_update_template_entries()
+            );
+    }
+
+    template<
+        typename vertex_uniforms_t,
+        typename fragment_uniforms_t,
+        typename vertex_t,
+        size_t num_textures,
+        size_t num_input_attachments,
+        typename push_constants_t,
+        typename instance_t
+    >
+    pipeline_registry_t::description_t
+    basic_renderer_t<
+        vertex_uniforms_t,
+        fragment_uniforms_t,
+        vertex_t,
+        num_textures,
+        num_input_attachments,
+        push_constants_t,
+        instance_t
+    >::pipeline_description(
+        const output_config_t& output_config,
+        render_settings_t render_settings
+    )
+    {
+        return {
+            output_config.extent,
+            output_config.render_pass,
+            output_config.subpass,
+            make_uniform_layout(),
+            make_vertex_layout(),
+            render_settings,
+            output_config.dynamic_viewport,
+            make_push_constant_ranges()
+        };
+    }
+
+    template<
+        typename vertex_uniforms_t,
+        typename fragment_uniforms_t,
+        typename vertex_t,
+        size_t num_textures,
+        size_t num_input_attachments,
+        typename push_constants_t,
+        typename instance_t
+    >
+    std::vector<VkPushConstantRange>
+    basic_renderer_t<
+        vertex_uniforms_t,
+        fragment_uniforms_t,
+        vertex_t,
+        num_textures,
+        num_input_attachments,
+        push_constants_t,
+        instance_t
+    >::make_push_constant_ranges()
+    {
+        if constexpr (has_push_constants)
+        {
+            static_assert(
+                sizeof(push_constants_t) % 4 == 0 &&
+                sizeof(push_constants_t) <= 128,
+                "push constants must be a multiple of 4 bytes and fit the guaranteed 128"
+            );
+            return {{
+                push_constant_stages,
+                0,
+                uint32_t(sizeof(push_constants_t))
+            }};
+        }
+        return {};
     }
+
+    template<
+        typename vertex_uniforms_t,
+        typename fragment_uniforms_t,
+        typename vertex_t,
+        size_t num_textures,
+        size_t num_input_attachments,
+        typename push_constants_t,
+        typename instance_t
+    >
+    std::vector<VkDescriptorUpdateTemplateEntryKHR>
+    basic_renderer_t<
+        vertex_uniforms_t,
+        fragment_uniforms_t,
+        vertex_t,
+        num_textures,
+        num_input_attachments,
+        push_constants_t,
+        instance_t
+    >::make_update_template_entries()
     {
+        std::vector<VkDescriptorUpdateTemplateEntryKHR> result;
+        size_t num_uniforms = 0;
+        size_t num_images = 0;
+        for (auto& binding : make_uniform_layout())
+        {
+            bool uniform = binding.descriptorType == VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+            auto offset = uniform ?
+                offsetof(descriptor_data_t, uniforms) +
+                    num_uniforms++ * sizeof(VkDescriptorBufferInfo) :
+                offsetof(descriptor_data_t, images) +
+                    num_images++ * sizeof(VkDescriptorImageInfo);
+            result.push_back({
+                binding.binding,
+                0,
+                binding.descriptorCount,
+                binding.descriptorType,
+                offset,
+                uniform ?
+                    sizeof(VkDescriptorBufferInfo) :
+                    sizeof(VkDescriptorImageInfo)
+            });
+        }
+        return result;
     }
 
     template<
@@ -153,7 +360,9 @@ namespace my_vulkan
         typename fragment_uniforms_t,
         typename vertex_t,
         size_t num_textures,
-        size_t num_input_attachments
+        size_t num_input_attachments,
+        typename push_constants_t,
+        typename instance_t
     >
     std::vector<VkDescriptorSetLayoutBinding>
     basic_renderer_t<
@@ -161,7 +370,9 @@ namespace my_vulkan
         fragment_uniforms_t,
         vertex_t,
         num_textures,
-        num_input_attachments
+        num_input_attachments,
+        push_constants_t,
+        instance_t
     >::make_uniform_layout()
     {
         std::vector<VkDescriptorSetLayoutBinding> result;
@@ -177,7 +388,7 @@ namespace my_vulkan
         {
             result.push_back({
                 texture_location++,
-                VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
+                VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC,
                 1,
                 VK_SHADER_STAGE_VERTEX_BIT,
                 0
@@ -187,7 +398,7 @@ namespace my_vulkan
         {
             result.push_back({
                 texture_location++,
-                VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
+                VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC,
                 1,
                 VK_SHADER_STAGE_FRAGMENT_BIT,
                 0
@@ -221,7 +432,9 @@ namespace my_vulkan
         typename fragment_uniforms_t,
         typename vertex_t,
         size_t num_textures,
-        size_t num_input_attachments
+        size_t num_input_attachments,
+        typename push_constants_t,
+        typename instance_t
     >
     vertex_layout_t
     basic_renderer_t<
@@ -229,13 +442,24 @@ namespace my_vulkan
         fragment_uniforms_t,
         vertex_t,
         num_textures,
-        num_input_attachments
+        num_input_attachments,
+        push_constants_t,
+        instance_t
     >::make_vertex_layout()
     {
-        return {
+        vertex_layout_t result{
             make_vertex_bindings_description(),
             make_attribute_descriptions()
         };
+        if constexpr (has_instances)
+        {
+            VkVertexInputBindingDescription instance_binding = {};
+            instance_binding.binding = 1;
+            instance_binding.stride = sizeof(instance_t);
+            instance_binding.inputRate = VK_VERTEX_INPUT_RATE_INSTANCE;
+            result.extra_bindings.push_back(instance_binding);
+        }
+        return result;
     }
 
     template<
@@ -243,7 +467,9 @@ namespace my_vulkan
         typename fragment_uniforms_t,
         typename vertex_t,
         size_t num_textures,
-        size_t num_input_attachments
+        size_t num_input_attachments,
+        typename push_constants_t,
+        typename instance_t
     >
     VkVertexInputBindingDescription
     basic_renderer_t<
@@ -251,7 +477,9 @@ namespace my_vulkan
         fragment_uniforms_t,
         vertex_t,
         num_textures,
-        num_input_attachments
+        num_input_attachments,
+        push_constants_t,
+        instance_t
     >::make_vertex_bindings_description()
     {
         VkVertexInputBindingDescription result = {};
@@ -266,7 +494,9 @@ namespace my_vulkan
         typename fragment_uniforms_t,
         typename vertex_t,
         size_t num_textures,
-        size_t num_input_attachments
+        size_t num_input_attachments,
+        typename push_constants_t,
+        typename instance_t
     >
     std::vector<VkVertexInputAttributeDescription>
     basic_renderer_t<
@@ -274,10 +504,26 @@ namespace my_vulkan
         fragment_uniforms_t,
         vertex_t,
         num_textures,
-        num_input_attachments
+        num_input_attachments,
+        push_constants_t,
+        instance_t
     >::make_attribute_descriptions()
     {
-        return make_vertex_attribute_descriptions(vertex_t{});
+        auto result = make_vertex_attribute_descriptions(vertex_t{});
+        if constexpr (has_instances)
+        {
+            auto instance_attributes = make_vertex_attribute_descriptions(
+                instance_t{},
+                1,
+                uint32_t(result.size())
+            );
+            result.insert(
+                result.end(),
+                instance_attributes.begin(),
+                instance_attributes.end()
+            );
+        }
+        return result;
     }
 
     template<
@@ -285,47 +531,28 @@ namespace my_vulkan
         typename fragment_uniforms_t,
         typename vertex_t,
         size_t num_textures,
-        size_t num_input_attachments
+        size_t num_input_attachments,
+        typename push_constants_t,
+        typename instance_t
     >
     basic_renderer_t<
         vertex_uniforms_t,
         fragment_uniforms_t,
         vertex_t,
         num_textures,
-        num_input_attachments
+        num_input_attachments,
+        push_constants_t,
+        instance_t
     >::pipeline_buffer_t::pipeline_buffer_t(
         device_t* device,
-        VkDescriptorSetLayout layout
+        descriptor_set_t descriptor_set,
+        const descriptor_update_template_t* update_template,
+        uniform_ring_t* uniform_ring
     )
     : _device{device}
-    , _vertex_uniforms{
-        *_device,
-        round_to_multiple_of_16(to_std140(vertex_uniforms_t{}).data.size()),
-        VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
-        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
-        VK_MEMORY_PROPERTY_HOST_COHERENT_BIT  
-    }
-    , _fragment_uniforms{
-        *_device,
-        round_to_multiple_of_16(to_std140(fragment_uniforms_t{}).data.size()),
-        VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
-        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
-        VK_MEMORY_PROPERTY_HOST_COHERENT_BIT  
-    }
-    , _descriptor_pool{
-        _device->get(),
-        std::vector<VkDescriptorPoolSize>{
-            {VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, uint32_t(2)},
-            {VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, uint32_t(num_textures)},
-            {VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT, uint32_t(num_input_attachments)},
-        },
-        1        
-    }
-    , _descriptor_set{
-        _device->get(),
-        _descriptor_pool.get(),
-        layout
-    }
+    , _descriptor_set{std::move(descriptor_set)}
+    , _update_template{update_template}
+    , _uniform_ring{uniform_ring}
     {   
     }
 
@@ -334,7 +561,9 @@ namespace my_vulkan
         typename fragment_uniforms_t,
         typename vertex_t,
         size_t num_textures,
-        size_t num_input_attachments
+        size_t num_input_attachments,
+        typename push_constants_t,
+        typename instance_t
     >
     void
     basic_renderer_t<
@@ -342,7 +571,9 @@ namespace my_vulkan
         fragment_uniforms_t,
         vertex_t,
         num_textures,
-        num_input_attachments
+        num_input_attachments,
+        push_constants_t,
+        instance_t
     >::pipeline_buffer_t::update_vertices(
         std::shared_ptr<buffer_t> vertices
     )
@@ -355,7 +586,9 @@ namespace my_vulkan
         typename fragment_uniforms_t,
         typename vertex_t,
         size_t num_textures,
-        size_t num_input_attachments
+        size_t num_input_attachments,
+        typename push_constants_t,
+        typename instance_t
     >
     void
     basic_renderer_t<
@@ -363,24 +596,18 @@ namespace my_vulkan
         fragment_uniforms_t,
         vertex_t,
         num_textures,
-        num_input_attachments
+        num_input_attachments,
+        push_constants_t,
+        instance_t
     >::pipeline_buffer_t::update_vertices(
         const std::vector<vertex_t>& vertices
     )
     {
-        size_t data_size = sizeof(vertex_t) * vertices.size();
-        if (!_vertices || _vertices->size() < data_size)
-        {
-            _vertices = std::make_shared<buffer_t>(
-                *_device,
-                data_size,
-                VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
-                VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT
-            );
-        }
-        _vertices->memory()->set_data(
+        _vertices = write_dynamic(
+            _dynamic_vertices,
             vertices.data(),
-            data_size
+            sizeof(vertex_t) * vertices.size(),
+            VK_BUFFER_USAGE_VERTEX_BUFFER_BIT
         );
     }
 
@@ -389,7 +616,9 @@ namespace my_vulkan
         typename fragment_uniforms_t,
         typename vertex_t,
         size_t num_textures,
-        size_t num_input_attachments
+        size_t num_input_attachments,
+        typename push_constants_t,
+        typename instance_t
     >
     std::shared_ptr<buffer_t>
     basic_renderer_t<
@@ -397,23 +626,20 @@ namespace my_vulkan
         fragment_uniforms_t,
         vertex_t,
         num_textures,
-        num_input_attachments
+        num_input_attachments,
+        push_constants_t,
+        instance_t
     >::upload_vertices(
-        const std::vector<vertex_t>& vertices
+        const std::vector<vertex_t>& vertices,
+        geometry_usage_t usage
     )
     {
-        size_t data_size = sizeof(vertex_t) * vertices.size();
-        auto vertex_buffer = std::make_shared<buffer_t>(
-            *_device,
-            data_size,
-            VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
-            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT
-        );
-        vertex_buffer->memory()->set_data(
+        return upload_geometry(
             vertices.data(),
-            data_size
+            sizeof(vertex_t) * vertices.size(),
+            VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
+            usage
         );
-        return vertex_buffer;
     }
 
     template<
@@ -421,7 +647,9 @@ namespace my_vulkan
         typename fragment_uniforms_t,
         typename vertex_t,
         size_t num_textures,
-        size_t num_input_attachments
+        size_t num_input_attachments,
+        typename push_constants_t,
+        typename instance_t
     >
     void
     basic_renderer_t<
@@ -429,24 +657,43 @@ namespace my_vulkan
         fragment_uniforms_t,
         vertex_t,
         num_textures,
-        num_input_attachments
-    >::pipeline_buffer_t::update_indices(
-        const std::vector<uint32_t> &indices
+        num_input_attachments,
+        push_constants_t,
+        instance_t
+    >::pipeline_buffer_t::update_instances(
+        std::shared_ptr<buffer_t> instances
     )
     {
-        size_t data_size = sizeof(uint32_t) * indices.size();
-        if (!_indices || _indices->size() < data_size)
-        {
-            _indices = buffer_t{
-                *_device,
-                data_size,
-                VK_BUFFER_USAGE_INDEX_BUFFER_BIT,
-                VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT
-            };
-        }
-        _indices->memory()->set_data(
-            indices.data(),
-            data_size
+        _instances = instances;
+    }
+
+    template<
+        typename vertex_uniforms_t,
+        typename fragment_uniforms_t,
+        typename vertex_t,
+        size_t num_textures,
+        size_t num_input_attachments,
+        typename push_constants_t,
+        typename instance_t
+    >
+    void
+    basic_renderer_t<
+        vertex_uniforms_t,
+        fragment_uniforms_t,
+        vertex_t,
+        num_textures,
+        num_input_attachments,
+        push_constants_t,
+        instance_t
+    >::pipeline_buffer_t::update_instances(
+        const std::vector<instance_t>& instances
+    )
+    {
+        _instances = write_dynamic(
+            _dynamic_instances,
+            instances.data(),
+            sizeof(instance_t) * instances.size(),
+            VK_BUFFER_USAGE_VERTEX_BUFFER_BIT
         );
     }
 
@@ -455,18 +702,30 @@ namespace my_vulkan
         typename fragment_uniforms_t,
         typename vertex_t,
         size_t num_textures,
-        size_t num_input_attachments
+        size_t num_input_attachments,
+        typename push_constants_t,
+        typename instance_t
     >
-    bool
+    std::shared_ptr<buffer_t>
     basic_renderer_t<
         vertex_uniforms_t,
         fragment_uniforms_t,
         vertex_t,
         num_textures,
-        num_input_attachments
-    >::pipeline_buffer_t::in_use() const
+        num_input_attachments,
+        push_constants_t,
+        instance_t
+    >::upload_instances(
+        const std::vector<instance_t>& instances,
+        geometry_usage_t usage
+    )
     {
-        return !!_phase || _pinned;
+        return upload_geometry(
+            instances.data(),
+            sizeof(instance_t) * instances.size(),
+            VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
+            usage
+        );
     }
 
     template<
@@ -474,47 +733,83 @@ namespace my_vulkan
         typename fragment_uniforms_t,
         typename vertex_t,
         size_t num_textures,
-        size_t num_input_attachments
+        size_t num_input_attachments,
+        typename push_constants_t,
+        typename instance_t
     >
-    void
+    std::shared_ptr<buffer_t>
     basic_renderer_t<
         vertex_uniforms_t,
         fragment_uniforms_t,
         vertex_t,
         num_textures,
-        num_input_attachments
-    >::pipeline_buffer_t::update_uniforms(
-        vertex_uniforms_t vertex_uniforms,
-        fragment_uniforms_t fragment_uniforms
+        num_input_attachments,
+        push_constants_t,
+        instance_t
+    >::upload_indices(
+        const std::vector<uint32_t>& indices,
+        geometry_usage_t usage
     )
     {
-        auto vertex_data = to_std140(vertex_uniforms).data;
-        uint32_t next_location = 0;
-        if (!vertex_data.empty())
+        return upload_geometry(
+            indices.data(),
+            sizeof(uint32_t) * indices.size(),
+            VK_BUFFER_USAGE_INDEX_BUFFER_BIT,
+            usage
+        );
+    }
+
+    template<
+        typename vertex_uniforms_t,
+        typename fragment_uniforms_t,
+        typename vertex_t,
+        size_t num_textures,
+        size_t num_input_attachments,
+        typename push_constants_t,
+        typename instance_t
+    >
+    std::shared_ptr<buffer_t>
+    basic_renderer_t<
+        vertex_uniforms_t,
+        fragment_uniforms_t,
+        vertex_t,
+        num_textures,
+        num_input_attachments,
+        push_constants_t,
+        instance_t
+    >::upload_geometry(
+        const void* data,
+        size_t size,
+        VkBufferUsageFlags buffer_usage,
+        geometry_usage_t usage
+    )
+    {
+        if (usage != geometry_usage_t::static_draw)
         {
-            _vertex_uniforms.memory()->set_data(
-                vertex_data.data(),
-                vertex_data.size()
+            auto result = std::make_shared<buffer_t>(
+                *_device,
+                size,
+                buffer_usage,
+                geometry_memory_properties(_device->physical_device(), usage)
             );
-            _descriptor_set.update_buffer_write(
-                next_location++,
-                VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
-                {{_vertex_uniforms.get(), 0, vertex_data.size()}}
-            );            
+            result->memory()->set_data(data, size);
+            return result;
         }
-        auto fragment_data = to_std140(fragment_uniforms).data;
-        if (!fragment_data.empty())
-        {
-            _fragment_uniforms.memory()->set_data(
-                fragment_data.data(),
-                fragment_data.size()
-            );
-            _descriptor_set.update_buffer_write(
-                next_location++,
-                VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
-                {{_fragment_uniforms.get(), 0, fragment_data.size()}}
+        auto result = std::make_shared<buffer_t>(
+            *_device,
+            size,
+            buffer_usage | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+            geometry_memory_properties(_device->physical_device(), usage)
+        );
+        // copied through the staging ring, done when this returns
+        std::unique_lock<std::mutex> lock{*_upload_mutex};
+        if (!_upload_pool)
+            _upload_pool = std::make_unique<command_pool_t>(
+                _device->get(),
+                _device->graphics_queue()
             );
-        }
+        result->load_data(*_upload_pool, data);
+        return result;
     }
 
     template<
@@ -522,26 +817,83 @@ namespace my_vulkan
         typename fragment_uniforms_t,
         typename vertex_t,
         size_t num_textures,
-        size_t num_input_attachments
+        size_t num_input_attachments,
+        typename push_constants_t,
+        typename instance_t
     >
-    void
     basic_renderer_t<
         vertex_uniforms_t,
         fragment_uniforms_t,
         vertex_t,
         num_textures,
-        num_input_attachments
-    >::pipeline_buffer_t::update_texture(
-        size_t index,
-        VkDescriptorImageInfo texture
+        num_input_attachments,
+        push_constants_t,
+        instance_t
+    >::mesh_buffer_t::mesh_buffer_t(
+        device_t& device,
+        size_t max_vertices,
+        size_t max_indices
     )
+    : _vertices{
+        device,
+        sizeof(vertex_t) * max_vertices,
+        VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
+        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT
+    }
+    , _indices{
+        device,
+        sizeof(uint32_t) * max_indices,
+        VK_BUFFER_USAGE_INDEX_BUFFER_BIT,
+        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT
+    }
     {
-        if (index >= num_textures)
-            throw std::runtime_error{"invalid texture index"};
-        _descriptor_set.update_combined_image_sampler_write(
-            uint32_t(texture_location_offset() + index),
-            {texture}
+    }
+
+    template<
+        typename vertex_uniforms_t,
+        typename fragment_uniforms_t,
+        typename vertex_t,
+        size_t num_textures,
+        size_t num_input_attachments,
+        typename push_constants_t,
+        typename instance_t
+    >
+    auto
+    basic_renderer_t<
+        vertex_uniforms_t,
+        fragment_uniforms_t,
+        vertex_t,
+        num_textures,
+        num_input_attachments,
+        push_constants_t,
+        instance_t
+    >::mesh_buffer_t::add(
+        const std::vector<vertex_t>& vertices,
+        const std::vector<uint32_t>& indices
+    ) -> mesh_t
+    {
+        if (
+            sizeof(vertex_t) * (_num_vertices + vertices.size()) > _vertices.size() ||
+            sizeof(uint32_t) * (_num_indices + indices.size()) > _indices.size()
+        )
+            throw std::runtime_error{"mesh buffer is full"};
+        _vertices.memory()->set_data(
+            vertices.data(),
+            sizeof(vertex_t) * vertices.size(),
+            sizeof(vertex_t) * _num_vertices
+        );
+        _indices.memory()->set_data(
+            indices.data(),
+            sizeof(uint32_t) * indices.size(),
+            sizeof(uint32_t) * _num_indices
         );
+        mesh_t result{
+            {uint32_t(_num_indices), uint32_t(indices.size())},
+            int32_t(_num_vertices)
+        };
+        _num_vertices += vertices.size();
+        _num_indices += indices.size();
+        return result;
     }
 
     template<
@@ -549,7 +901,9 @@ namespace my_vulkan
         typename fragment_uniforms_t,
         typename vertex_t,
         size_t num_textures,
-        size_t num_input_attachments
+        size_t num_input_attachments,
+        typename push_constants_t,
+        typename instance_t
     >
     void
     basic_renderer_t<
@@ -557,19 +911,13 @@ namespace my_vulkan
         fragment_uniforms_t,
         vertex_t,
         num_textures,
-        num_input_attachments
-    >::pipeline_buffer_t::update_input_attachment(
-        size_t index,
-        descriptor_set_t::image_info_t image
-    )
+        num_input_attachments,
+        push_constants_t,
+        instance_t
+    >::mesh_buffer_t::clear()
     {
-        if (index >= num_input_attachments)
-            throw std::runtime_error{"invalid input attachment index"};
-        _descriptor_set.update_image_write(
-            uint32_t(texture_location_offset() + num_textures + index),
-            VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT,
-            {image}
-        );
+        _num_vertices = 0;
+        _num_indices = 0;
     }
 
     template<
@@ -577,23 +925,22 @@ namespace my_vulkan
         typename fragment_uniforms_t,
         typename vertex_t,
         size_t num_textures,
-        size_t num_input_attachments
+        size_t num_input_attachments,
+        typename push_constants_t,
+        typename instance_t
     >
-    size_t
+    VkBuffer
     basic_renderer_t<
         vertex_uniforms_t,
         fragment_uniforms_t,
         vertex_t,
         num_textures,
-        num_input_attachments
-    >::pipeline_buffer_t::texture_location_offset()
+        num_input_attachments,
+        push_constants_t,
+        instance_t
+    >::mesh_buffer_t::vertices()
     {
-        size_t offset = 0;
-        if (!boost::fusion::result_of::empty<vertex_uniforms_t>::value)
-            ++offset;
-        if (!boost::fusion::result_of::empty<fragment_uniforms_t>::value)
-            ++offset;
-        return offset;        
+        return _vertices.get();
     }
 
     template<
@@ -601,35 +948,22 @@ namespace my_vulkan
         typename fragment_uniforms_t,
         typename vertex_t,
         size_t num_textures,
-        size_t num_input_attachments
+        size_t num_input_attachments,
+        typename push_constants_t,
+        typename instance_t
     >
-    void
+    VkBuffer
     basic_renderer_t<
         vertex_uniforms_t,
         fragment_uniforms_t,
         vertex_t,
         num_textures,
-        num_input_attachments
-    >::pipeline_buffer_t::bind(
-        command_buffer_t::scope_t& command_scope,
-        VkPipelineLayout layout,
-        phase_t phase
-    )
+        num_input_attachments,
+        push_constants_t,
+        instance_t
+    >::mesh_buffer_t::indices()
     {
-        _phase = phase;
-        command_scope.bind_vertex_buffers(
-            {{_vertices->get(), 0}}
-        );
-        if (_indices)
-            command_scope.bind_index_buffer(
-                _indices->get(),
-                VK_INDEX_TYPE_UINT32
-            );
-        command_scope.bind_descriptor_set(
-            VK_PIPELINE_BIND_POINT_GRAPHICS, 
-            layout,
-            {_descriptor_set.get()}
-        );        
+        return _indices.get();
     }
 
     template<
@@ -637,7 +971,9 @@ namespace my_vulkan
         typename fragment_uniforms_t,
         typename vertex_t,
         size_t num_textures,
-        size_t num_input_attachments
+        size_t num_input_attachments,
+        typename push_constants_t,
+        typename instance_t
     >
     void
     basic_renderer_t<
@@ -645,16 +981,19 @@ namespace my_vulkan
         fragment_uniforms_t,
         vertex_t,
         num_textures,
-        num_input_attachments
-    >::execute_draw(
-        pipeline_buffer_t& buffer,
-        command_buffer_t::scope_t& command_scope,
-        index_range_t range,
-        std::optional<VkRect2D> target_rect
+        num_input_attachments,
+        push_constants_t,
+        instance_t
+    >::pipeline_buffer_t::update_indices(
+        const std::vector<uint32_t> &indices
     )
     {
-        bind(buffer, command_scope, target_rect);
-        command_scope.draw(range);
+        _indices = write_dynamic(
+            _dynamic_indices,
+            indices.data(),
+            sizeof(uint32_t) * indices.size(),
+            VK_BUFFER_USAGE_INDEX_BUFFER_BIT
+        );
     }
 
     template<
@@ -662,7 +1001,9 @@ namespace my_vulkan
         typename fragment_uniforms_t,
         typename vertex_t,
         size_t num_textures,
-        size_t num_input_attachments
+        size_t num_input_attachments,
+        typename push_constants_t,
+        typename instance_t
     >
     void
     basic_renderer_t<
@@ -670,16 +1011,815 @@ namespace my_vulkan
         fragment_uniforms_t,
         vertex_t,
         num_textures,
-        num_input_attachments
-    >::execute_indexed_draw(
-        pipeline_buffer_t& buffer,
-        command_buffer_t::scope_t& command_scope,
-        index_range_t range,
-        std::optional<VkRect2D> target_rect
+        num_input_attachments,
+        push_constants_t,
+        instance_t
+    >::pipeline_buffer_t::update_indices(
+        std::shared_ptr<buffer_t> indices
     )
     {
-        bind(buffer, command_scope, target_rect);
-        command_scope.draw_indexed(range);
+        _indices = indices;
+    }
+
+    template<
+        typename vertex_uniforms_t,
+        typename fragment_uniforms_t,
+        typename vertex_t,
+        size_t num_textures,
+        size_t num_input_attachments,
+        typename push_constants_t,
+        typename instance_t
+    >
+    std::shared_ptr<buffer_t>
+    basic_renderer_t<
+        vertex_uniforms_t,
+        fragment_uniforms_t,
+        vertex_t,
+        num_textures,
+        num_input_attachments,
+        push_constants_t,
+        instance_t
+    >::pipeline_buffer_t::write_dynamic(
+        dynamic_copies_t& target,
+        const void* data,
+        size_t size,
+        VkBufferUsageFlags usage
+    )
+    {
+        // copies drawn from in a phase that did not come around again may
+        // still be read, including earlier draws of the current phase
+        auto copy = std::find_if(
+            target.begin(),
+            target.end(),
+            [](auto& copy){return !copy.phase;}
+        );
+        if (copy == target.end())
+            copy = target.insert(copy, dynamic_copy_t{});
+        if (!copy->buffer || copy->buffer->size() < size)
+            copy->buffer = std::make_shared<buffer_t>(
+                *_device,
+                size,
+                usage,
+                VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT
+            );
+        copy->buffer->memory()->set_data(data, size);
+        return copy->buffer;
+    }
+
+    template<
+        typename vertex_uniforms_t,
+        typename fragment_uniforms_t,
+        typename vertex_t,
+        size_t num_textures,
+        size_t num_input_attachments,
+        typename push_constants_t,
+        typename instance_t
+    >
+    void
+    basic_renderer_t<
+        vertex_uniforms_t,
+        fragment_uniforms_t,
+        vertex_t,
+        num_textures,
+        num_input_attachments,
+        push_constants_t,
+        instance_t
+    >::pipeline_buffer_t::claim_dynamic(phase_t phase)
+    {
+        auto claim = [phase](dynamic_copies_t& target, const std::shared_ptr<buffer_t>& bound)
+        {
+            for (auto& copy : target)
+                if (bound && copy.buffer == bound)
+                    copy.phase = phase;
+        };
+        claim(_dynamic_vertices, _vertices);
+        claim(_dynamic_instances, _instances);
+        claim(_dynamic_indices, _indices);
+    }
+
+    template<
+        typename vertex_uniforms_t,
+        typename fragment_uniforms_t,
+        typename vertex_t,
+        size_t num_textures,
+        size_t num_input_attachments,
+        typename push_constants_t,
+        typename instance_t
+    >
+    bool
+    basic_renderer_t<
+        vertex_uniforms_t,
+        fragment_uniforms_t,
+        vertex_t,
+        num_textures,
+        num_input_attachments,
+        push_constants_t,
+        instance_t
+    >::pipeline_buffer_t::in_use() const
+    {
+        return !!_phase || _pinned;
+    }
+
+    template<
+        typename vertex_uniforms_t,
+        typename fragment_uniforms_t,
+        typename vertex_t,
+        size_t num_textures,
+        size_t num_input_attachments,
+        typename push_constants_t,
+        typename instance_t
+    >
+    void
+    basic_renderer_t<
+        vertex_uniforms_t,
+        fragment_uniforms_t,
+        vertex_t,
+        num_textures,
+        num_input_attachments,
+        push_constants_t,
+        instance_t
+    >::pipeline_buffer_t::update_uniforms(
+        vertex_uniforms_t vertex_uniforms,
+        fragment_uniforms_t fragment_uniforms
+    )
+    {
+        uint32_t next_location = 0;
+        if (!boost::fusion::result_of::empty<vertex_uniforms_t>::value)
+        {
+            auto& data = _uniform_data[next_location];
+            data.resize(std140_size<vertex_uniforms_t>);
+            write_std140(vertex_uniforms, data.data());
+            push_uniforms(next_location++);
+        }
+        if (!boost::fusion::result_of::empty<fragment_uniforms_t>::value)
+        {
+            auto& data = _uniform_data[next_location];
+            data.resize(std140_size<fragment_uniforms_t>);
+            write_std140(fragment_uniforms, data.data());
+            push_uniforms(next_location);
+        }
+    }
+
+    template<
+        typename vertex_uniforms_t,
+        typename fragment_uniforms_t,
+        typename vertex_t,
+        size_t num_textures,
+        size_t num_input_attachments,
+        typename push_constants_t,
+        typename instance_t
+    >
+    void
+    basic_renderer_t<
+        vertex_uniforms_t,
+        fragment_uniforms_t,
+        vertex_t,
+        num_textures,
+        num_input_attachments,
+        push_constants_t,
+        instance_t
+    >::pipeline_buffer_t::push_uniforms(uint32_t location)
+    {
+        auto& data = _uniform_data[location];
+        _uniform_frame = _uniform_ring->frame_serial();
+        auto allocation = _uniform_ring->push(data.data(), data.size());
+        _dynamic_offsets[location] = allocation.offset;
+        // the ring hands out one buffer and the offset is dynamic, so the
+        // descriptor is written once. the set may be bound by now and must
+        // not be updated again
+        auto& info = _descriptor_data.uniforms[location];
+        if (_written[location])
+            return;
+        info = {allocation.buffer, 0, data.size()};
+        if (!defer_write(location))
+            _descriptor_set.update_buffer_write(
+                location,
+                VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC,
+                {info}
+            );
+    }
+
+    template<
+        typename vertex_uniforms_t,
+        typename fragment_uniforms_t,
+        typename vertex_t,
+        size_t num_textures,
+        size_t num_input_attachments,
+        typename push_constants_t,
+        typename instance_t
+    >
+    void
+    basic_renderer_t<
+        vertex_uniforms_t,
+        fragment_uniforms_t,
+        vertex_t,
+        num_textures,
+        num_input_attachments,
+        push_constants_t,
+        instance_t
+    >::pipeline_buffer_t::refresh_uniforms()
+    {
+        if (_uniform_frame == _uniform_ring->frame_serial())
+            return;
+        for (uint32_t location = 0; location < _uniform_data.size(); ++location)
+            if (!_uniform_data[location].empty())
+                push_uniforms(location);
+    }
+
+    template<
+        typename vertex_uniforms_t,
+        typename fragment_uniforms_t,
+        typename vertex_t,
+        size_t num_textures,
+        size_t num_input_attachments,
+        typename push_constants_t,
+        typename instance_t
+    >
+    void
+    basic_renderer_t<
+        vertex_uniforms_t,
+        fragment_uniforms_t,
+        vertex_t,
+        num_textures,
+        num_input_attachments,
+        push_constants_t,
+        instance_t
+    >::pipeline_buffer_t::update_texture(
+        size_t index,
+        VkDescriptorImageInfo texture
+    )
+    {
+        if (index >= num_textures)
+            throw std::runtime_error{"invalid texture index"};
+        _descriptor_data.images[index] = texture;
+        auto location = texture_location_offset() + index;
+        if (!defer_write(location))
+            _descriptor_set.update_combined_image_sampler_write(
+                uint32_t(location),
+                {texture}
+            );
+    }
+
+    template<
+        typename vertex_uniforms_t,
+        typename fragment_uniforms_t,
+        typename vertex_t,
+        size_t num_textures,
+        size_t num_input_attachments,
+        typename push_constants_t,
+        typename instance_t
+    >
+    void
+    basic_renderer_t<
+        vertex_uniforms_t,
+        fragment_uniforms_t,
+        vertex_t,
+        num_textures,
+        num_input_attachments,
+        push_constants_t,
+        instance_t
+    >::pipeline_buffer_t::update_input_attachment(
+        size_t index,
+        descriptor_set_t::image_info_t image
+    )
+    {
+        if (index >= num_input_attachments)
+            throw std::runtime_error{"invalid input attachment index"};
+        _descriptor_data.images[num_textures + index] = {
+            VK_NULL_HANDLE,
+            image.view,
+            image.layout
+        };
+        auto location = texture_location_offset() + num_textures + index;
+        if (!defer_write(location))
+            _descriptor_set.update_image_write(
+                uint32_t(location),
+                VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT,
+                {image}
+            );
+    }
+
+    template<
+        typename vertex_uniforms_t,
+        typename fragment_uniforms_t,
+        typename vertex_t,
+        size_t num_textures,
+        size_t num_input_attachments,
+        typename push_constants_t,
+        typename instance_t
+    >
+    bool
+    basic_renderer_t<
+        vertex_uniforms_t,
+        fragment_uniforms_t,
+        vertex_t,
+        num_textures,
+        num_input_attachments,
+        push_constants_t,
+        instance_t
+    >::pipeline_buffer_t::defer_write(size_t location)
+    {
+        _written[location] = true;
+        if (!_update_template)
+            return false;
+        auto num_bindings = texture_location_offset() + num_textures + num_input_attachments;
+        for (size_t i = 0; i < num_bindings; ++i)
+            if (!_written[i])
+                return false;
+        _dirty = true;
+        return true;
+    }
+
+    template<
+        typename vertex_uniforms_t,
+        typename fragment_uniforms_t,
+        typename vertex_t,
+        size_t num_textures,
+        size_t num_input_attachments,
+        typename push_constants_t,
+        typename instance_t
+    >
+    size_t
+    basic_renderer_t<
+        vertex_uniforms_t,
+        fragment_uniforms_t,
+        vertex_t,
+        num_textures,
+        num_input_attachments,
+        push_constants_t,
+        instance_t
+    >::pipeline_buffer_t::texture_location_offset()
+    {
+        size_t offset = 0;
+        if (!boost::fusion::result_of::empty<vertex_uniforms_t>::value)
+            ++offset;
+        if (!boost::fusion::result_of::empty<fragment_uniforms_t>::value)
+            ++offset;
+        return offset;        
+    }
+
+    template<
+        typename vertex_uniforms_t,
+        typename fragment_uniforms_t,
+        typename vertex_t,
+        size_t num_textures,
+        size_t num_input_attachments,
+        typename push_constants_t,
+        typename instance_t
+    >
+    void
+    basic_renderer_t<
+        vertex_uniforms_t,
+        fragment_uniforms_t,
+        vertex_t,
+        num_textures,
+        num_input_attachments,
+        push_constants_t,
+        instance_t
+    >::pipeline_buffer_t::bind(
+        command_buffer_t::scope_t& command_scope,
+        VkPipelineLayout layout,
+        phase_t phase
+    )
+    {
+        // claimed buffers already carry the phase, don't write it again
+        // while other threads look for free buffers
+        if (!_phase || !(*_phase == phase))
+            _phase = phase;
+        claim_dynamic(phase);
+        refresh_uniforms();
+        if (_dirty)
+        {
+            _descriptor_set.update_with_template(*_update_template, &_descriptor_data);
+            _dirty = false;
+        }
+        // indirect draws bind their mesh buffer instead
+        if (_vertices)
+            command_scope.bind_vertex_buffers(
+                {{_vertices->get(), 0}}
+            );
+        if constexpr (has_instances)
+        {
+            if (!_instances)
+                throw std::runtime_error{"pipeline buffer has no instance data"};
+            command_scope.bind_vertex_buffers(
+                {{_instances->get(), 0}},
+                1
+            );
+        }
+        if (_indices)
+            command_scope.bind_index_buffer(
+                _indices->get(),
+                VK_INDEX_TYPE_UINT32
+            );
+        command_scope.bind_descriptor_set(
+            VK_PIPELINE_BIND_POINT_GRAPHICS, 
+            layout,
+            {_descriptor_set.get()},
+            0,
+            {_dynamic_offsets.data(), texture_location_offset()}
+        );        
+    }
+
+    template<
+        typename vertex_uniforms_t,
+        typename fragment_uniforms_t,
+        typename vertex_t,
+        size_t num_textures,
+        size_t num_input_attachments,
+        typename push_constants_t,
+        typename instance_t
+    >
+    void
+    basic_renderer_t<
+        vertex_uniforms_t,
+        fragment_uniforms_t,
+        vertex_t,
+        num_textures,
+        num_input_attachments,
+        push_constants_t,
+        instance_t
+    >::pipeline_buffer_t::enqueue(
+        helpers::render_queue_t& queue,
+        helpers::render_packet_t packet,
+        bool indexed,
+        phase_t phase,
+        float depth
+    )
+    {
+        if (!_phase || !(*_phase == phase))
+            _phase = phase;
+        claim_dynamic(phase);
+        refresh_uniforms();
+        if (_dirty)
+        {
+            _descriptor_set.update_with_template(*_update_template, &_descriptor_data);
+            _dirty = false;
+        }
+        packet.descriptor_set = _descriptor_set.get();
+        packet.dynamic_offsets = _dynamic_offsets;
+        packet.num_dynamic_offsets = uint32_t(texture_location_offset());
+        if (_vertices)
+            packet.vertices = _vertices->get();
+        if constexpr (has_instances)
+        {
+            if (!_instances)
+                throw std::runtime_error{"pipeline buffer has no instance data"};
+            packet.instances = _instances->get();
+        }
+        if (indexed)
+        {
+            if (!_indices)
+                throw std::runtime_error{"pipeline buffer has no indices"};
+            packet.indices = _indices->get();
+        }
+        // the first texture is what the sort key groups by
+        VkImageView texture = VK_NULL_HANDLE;
+        if constexpr (num_textures > 0)
+            texture = _descriptor_data.images[0].imageView;
+        queue.push(packet, texture, depth);
+    }
+
+    template<
+        typename vertex_uniforms_t,
+        typename fragment_uniforms_t,
+        typename vertex_t,
+        size_t num_textures,
+        size_t num_input_attachments,
+        typename push_constants_t,
+        typename instance_t
+    >
+    void
+    basic_renderer_t<
+        vertex_uniforms_t,
+        fragment_uniforms_t,
+        vertex_t,
+        num_textures,
+        num_input_attachments,
+        push_constants_t,
+        instance_t
+    >::execute_draw(
+        pipeline_buffer_t& buffer,
+        command_buffer_t::scope_t& command_scope,
+        index_range_t range,
+        std::optional<VkRect2D> target_rect,
+        index_range_t instance_range
+    )
+    {
+        bind(buffer, command_scope, target_rect);
+        command_scope.draw(range, instance_range);
+    }
+
+    template<
+        typename vertex_uniforms_t,
+        typename fragment_uniforms_t,
+        typename vertex_t,
+        size_t num_textures,
+        size_t num_input_attachments,
+        typename push_constants_t,
+        typename instance_t
+    >
+    void
+    basic_renderer_t<
+        vertex_uniforms_t,
+        fragment_uniforms_t,
+        vertex_t,
+        num_textures,
+        num_input_attachments,
+        push_constants_t,
+        instance_t
+    >::execute_indexed_draw(
+        pipeline_buffer_t& buffer,
+        command_buffer_t::scope_t& command_scope,
+        index_range_t range,
+        std::optional<VkRect2D> target_rect,
+        index_range_t instance_range
+    )
+    {
+        bind(buffer, command_scope, target_rect);
+        command_scope.draw_indexed(range, 0, instance_range);
+    }
+
+    template<
+        typename vertex_uniforms_t,
+        typename fragment_uniforms_t,
+        typename vertex_t,
+        size_t num_textures,
+        size_t num_input_attachments,
+        typename push_constants_t,
+        typename instance_t
+    >
+    void
+    basic_renderer_t<
+        vertex_uniforms_t,
+        fragment_uniforms_t,
+        vertex_t,
+        num_textures,
+        num_input_attachments,
+        push_constants_t,
+        instance_t
+    >::execute_draw(
+        pipeline_buffer_t& buffer,
+        command_buffer_t::scope_t& command_scope,
+        index_range_t range,
+        const push_constants_t& push_constants,
+        std::optional<VkRect2D> target_rect,
+        index_range_t instance_range
+    )
+    {
+        bind(buffer, command_scope, target_rect);
+        push(command_scope, push_constants);
+        command_scope.draw(range, instance_range);
+    }
+
+    template<
+        typename vertex_uniforms_t,
+        typename fragment_uniforms_t,
+        typename vertex_t,
+        size_t num_textures,
+        size_t num_input_attachments,
+        typename push_constants_t,
+        typename instance_t
+    >
+    void
+    basic_renderer_t<
+        vertex_uniforms_t,
+        fragment_uniforms_t,
+        vertex_t,
+        num_textures,
+        num_input_attachments,
+        push_constants_t,
+        instance_t
+    >::execute_indexed_draw(
+        pipeline_buffer_t& buffer,
+        command_buffer_t::scope_t& command_scope,
+        index_range_t range,
+        const push_constants_t& push_constants,
+        std::optional<VkRect2D> target_rect,
+        index_range_t instance_range
+    )
+    {
+        bind(buffer, command_scope, target_rect);
+        push(command_scope, push_constants);
+        command_scope.draw_indexed(range, 0, instance_range);
+    }
+
+    template<
+        typename vertex_uniforms_t,
+        typename fragment_uniforms_t,
+        typename vertex_t,
+        size_t num_textures,
+        size_t num_input_attachments,
+        typename push_constants_t,
+        typename instance_t
+    >
+    void
+    basic_renderer_t<
+        vertex_uniforms_t,
+        fragment_uniforms_t,
+        vertex_t,
+        num_textures,
+        num_input_attachments,
+        push_constants_t,
+        instance_t
+    >::push(
+        command_buffer_t::scope_t& command_scope,
+        const push_constants_t& push_constants
+    )
+    {
+        // nothing to push for no_push_constants_t
+        if constexpr (has_push_constants)
+            command_scope.push_constants(
+                _graphics_pipeline->layout(),
+                push_constant_stages,
+                push_constants
+            );
+    }
+
+    template<
+        typename vertex_uniforms_t,
+        typename fragment_uniforms_t,
+        typename vertex_t,
+        size_t num_textures,
+        size_t num_input_attachments,
+        typename push_constants_t,
+        typename instance_t
+    >
+    void
+    basic_renderer_t<
+        vertex_uniforms_t,
+        fragment_uniforms_t,
+        vertex_t,
+        num_textures,
+        num_input_attachments,
+        push_constants_t,
+        instance_t
+    >::execute_indirect_draw(
+        pipeline_buffer_t& buffer,
+        command_buffer_t::scope_t& command_scope,
+        mesh_buffer_t& meshes,
+        const draw_list_t& draw_list,
+        std::optional<VkRect2D> target_rect
+    )
+    {
+        if (draw_list.empty())
+            return;
+        bind(buffer, command_scope, target_rect);
+        draw_indirect(command_scope, meshes, draw_list);
+    }
+
+    template<
+        typename vertex_uniforms_t,
+        typename fragment_uniforms_t,
+        typename vertex_t,
+        size_t num_textures,
+        size_t num_input_attachments,
+        typename push_constants_t,
+        typename instance_t
+    >
+    void
+    basic_renderer_t<
+        vertex_uniforms_t,
+        fragment_uniforms_t,
+        vertex_t,
+        num_textures,
+        num_input_attachments,
+        push_constants_t,
+        instance_t
+    >::execute_indirect_draw(
+        pipeline_buffer_t& buffer,
+        command_buffer_t::scope_t& command_scope,
+        mesh_buffer_t& meshes,
+        const draw_list_t& draw_list,
+        const push_constants_t& push_constants,
+        std::optional<VkRect2D> target_rect
+    )
+    {
+        if (draw_list.empty())
+            return;
+        bind(buffer, command_scope, target_rect);
+        push(command_scope, push_constants);
+        draw_indirect(command_scope, meshes, draw_list);
+    }
+
+    template<
+        typename vertex_uniforms_t,
+        typename fragment_uniforms_t,
+        typename vertex_t,
+        size_t num_textures,
+        size_t num_input_attachments,
+        typename push_constants_t,
+        typename instance_t
+    >
+    void
+    basic_renderer_t<
+        vertex_uniforms_t,
+        fragment_uniforms_t,
+        vertex_t,
+        num_textures,
+        num_input_attachments,
+        push_constants_t,
+        instance_t
+    >::draw_indirect(
+        command_buffer_t::scope_t& command_scope,
+        mesh_buffer_t& meshes,
+        const draw_list_t& draw_list
+    )
+    {
+        command_scope.bind_vertex_buffers(
+            {{meshes.vertices(), 0}}
+        );
+        command_scope.bind_index_buffer(
+            meshes.indices(),
+            VK_INDEX_TYPE_UINT32
+        );
+        auto& commands = draw_list.commands();
+        if (!_device->draw_indirect_first_instance())
+            for (auto& command : commands)
+                if (command.firstInstance != 0)
+                    throw std::runtime_error{
+                        "instance offsets in draw lists need drawIndirectFirstInstance"
+                    };
+        auto stride = uint32_t(sizeof(VkDrawIndexedIndirectCommand));
+        auto allocation = _indirect_ring->push(
+            commands.data(),
+            stride * commands.size()
+        );
+        for (size_t first = 0; first < commands.size(); first += _max_draw_indirect_count)
+            command_scope.draw_indexed_indirect(
+                allocation.buffer,
+                allocation.offset + first * stride,
+                uint32_t(std::min<size_t>(_max_draw_indirect_count, commands.size() - first)),
+                stride
+            );
+    }
+
+    template<
+        typename vertex_uniforms_t,
+        typename fragment_uniforms_t,
+        typename vertex_t,
+        size_t num_textures,
+        size_t num_input_attachments,
+        typename push_constants_t,
+        typename instance_t
+    >
+    void
+    basic_renderer_t<
+        vertex_uniforms_t,
+        fragment_uniforms_t,
+        vertex_t,
+        num_textures,
+        num_input_attachments,
+        push_constants_t,
+        instance_t
+    >::enqueue_draw(
+        helpers::render_queue_t& queue,
+        pipeline_buffer_t& buffer,
+        index_range_t range,
+        float depth,
+        index_range_t instance_range
+    )
+    {
+        helpers::render_packet_t packet;
+        packet.pipeline = _graphics_pipeline->get();
+        packet.layout = _graphics_pipeline->layout();
+        packet.range = range;
+        packet.instance_range = instance_range;
+        buffer.enqueue(queue, packet, false, _current_phase, depth);
+    }
+
+    template<
+        typename vertex_uniforms_t,
+        typename fragment_uniforms_t,
+        typename vertex_t,
+        size_t num_textures,
+        size_t num_input_attachments,
+        typename push_constants_t,
+        typename instance_t
+    >
+    void
+    basic_renderer_t<
+        vertex_uniforms_t,
+        fragment_uniforms_t,
+        vertex_t,
+        num_textures,
+        num_input_attachments,
+        push_constants_t,
+        instance_t
+    >::enqueue_indexed_draw(
+        helpers::render_queue_t& queue,
+        pipeline_buffer_t& buffer,
+        index_range_t range,
+        float depth,
+        index_range_t instance_range
+    )
+    {
+        helpers::render_packet_t packet;
+        packet.pipeline = _graphics_pipeline->get();
+        packet.layout = _graphics_pipeline->layout();
+        packet.range = range;
+        packet.instance_range = instance_range;
+        buffer.enqueue(queue, packet, true, _current_phase, depth);
     }
 
     template<
@@ -687,7 +1827,9 @@ namespace my_vulkan
         typename fragment_uniforms_t,
         typename vertex_t,
         size_t num_textures,
-        size_t num_input_attachments
+        size_t num_input_attachments,
+        typename push_constants_t,
+        typename instance_t
     >
     void
     basic_renderer_t<
@@ -695,7 +1837,9 @@ namespace my_vulkan
         fragment_uniforms_t,
         vertex_t,
         num_textures,
-        num_input_attachments
+        num_input_attachments,
+        push_constants_t,
+        instance_t
     >::bind(
         pipeline_buffer_t& buffer,
         command_buffer_t::scope_t& command_scope,
@@ -704,12 +1848,12 @@ namespace my_vulkan
     {
         command_scope.bind_pipeline(
             VK_PIPELINE_BIND_POINT_GRAPHICS,
-            _graphics_pipeline.get(),
+            _graphics_pipeline->get(),
             target_rect
         );
         buffer.bind(
             command_scope,
-            _graphics_pipeline.layout(),
+            _graphics_pipeline->layout(),
             _current_phase
         );
     }
@@ -724,7 +1868,9 @@ namespace my_vulkan
         typename fragment_uniforms_t,
         typename vertex_t,
         size_t num_textures,
-        size_t num_input_attachments
+        size_t num_input_attachments,
+        typename push_constants_t,
+        typename instance_t
     >
     auto 
     basic_renderer_t<
@@ -732,18 +1878,30 @@ namespace my_vulkan
         fragment_uniforms_t,
         vertex_t,
         num_textures,
-        num_input_attachments
+        num_input_attachments,
+        push_constants_t,
+        instance_t
     >::buffer() -> pipeline_buffer_t&
     {
+        std::unique_lock<std::mutex> lock{*_pipeline_buffers_mutex};
         for (auto& buffer_ptr : _pipeline_buffers)
             if (!buffer_ptr->in_use())
+            {
+                buffer_ptr->claim(_current_phase);
                 return *buffer_ptr;
+            }
         _pipeline_buffers.push_back(
             std::make_unique<pipeline_buffer_t>(
                 _device,
-                _graphics_pipeline.uniform_layout()
+                _descriptor_allocator.allocate(
+                    _graphics_pipeline->uniform_layout(),
+                    make_uniform_layout()
+                ),
+                _update_template.get(),
+                _uniform_ring.get()
             )
         );
+        _pipeline_buffers.back()->claim(_current_phase);
         return *_pipeline_buffers.back();
     }
 }
@@ -1,9 +1,14 @@
 #pragma once
 
 #include "../my_vulkan.hpp"
+#include "render_queue.hpp"
 
+#include <algorithm>
+#include <array>
 #include <memory>
+#include <mutex>
 #include <stdexcept>
+#include <type_traits>
 
 namespace my_vulkan
 {
@@ -42,6 +47,68 @@ namespace my_vulkan
         }
     };
 
+    // where a mesh sits in a mesh buffer
+    struct basic_renderer_mesh_t
+    {
+        index_range_t indices;
+        int32_t vertex_offset;
+    };
+
+    // indexed draws recorded together as indirect draws
+    class basic_renderer_draw_list_t
+    {
+    public:
+        // a non zero instance offset needs drawIndirectFirstInstance
+        void add(
+            basic_renderer_mesh_t mesh,
+            index_range_t instance_range = {0, 1}
+        )
+        {
+            _commands.push_back({
+                mesh.indices.count,
+                instance_range.count,
+                mesh.indices.offset,
+                mesh.vertex_offset,
+                instance_range.offset
+            });
+        }
+        void clear()
+        {
+            _commands.clear();
+        }
+        bool empty() const
+        {
+            return _commands.empty();
+        }
+        const std::vector<VkDrawIndexedIndirectCommand>& commands() const
+        {
+            return _commands;
+        }
+    private:
+        std::vector<VkDrawIndexedIndirectCommand> _commands;
+    };
+
+    // default for renderers without push constants
+    struct no_push_constants_t {};
+
+    // selects the memory uploaded geometry lives in
+    enum class geometry_usage_t
+    {
+        // written once, copied through staging memory into device local
+        // memory
+        static_draw,
+        // rewritten now and then, drawn many times. plain host visible
+        // memory
+        dynamic_draw,
+        // rewritten for about every draw. host visible, and device local
+        // too where the device has such memory. on discrete devices that
+        // is a small heap, so only meant for little data
+        stream_draw
+    };
+
+    // default for renderers without per instance attributes
+    struct no_instance_t {};
+
     template<
         typename in_vertex_uniforms_t,
         typename in_fragment_uniforms_t,
@@ -51,14 +118,30 @@ namespace my_vulkan
         // std::tuple should also work
         typename in_vertex_t,
         size_t num_textures,
-        size_t num_input_attachments = 0
+        size_t num_input_attachments = 0,
+        // per draw data pushed to both stages as one push_constant block,
+        // at most 128 bytes
+        typename in_push_constants_t = no_push_constants_t,
+        // attributes advancing per instance, same rules as the vertex,
+        // locations follow the vertex attributes
+        typename in_instance_t = no_instance_t
     > class basic_renderer_t
     {
     public:
         using vertex_uniforms_t = in_vertex_uniforms_t;
         using fragment_uniforms_t = in_fragment_uniforms_t;
         using vertex_t = in_vertex_t;
+        using push_constants_t = in_push_constants_t;
+        using instance_t = in_instance_t;
         using phase_t = basic_renderer_phase_t;
+        using mesh_t = basic_renderer_mesh_t;
+        using draw_list_t = basic_renderer_draw_list_t;
+        static constexpr bool has_push_constants =
+            !std::is_empty<push_constants_t>::value;
+        static constexpr bool has_instances =
+            !std::is_empty<instance_t>::value;
+        static constexpr VkShaderStageFlags push_constant_stages =
+            VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT;
 
         typedef rendering_output_config_t output_config_t;
         basic_renderer_t(
@@ -69,10 +152,11 @@ namespace my_vulkan
         )
         : basic_renderer_t{
             output_config,
-            {
-                shader_module_t{output_config.device->get(), vertex_shader},
-                shader_module_t{output_config.device->get(), fragment_shader},
-            },
+            output_config.device->pipeline_registry().graphics_pipeline(
+                pipeline_description(output_config, render_settings),
+                vertex_shader,
+                fragment_shader
+            ),
             render_settings
         }
         {}
@@ -81,6 +165,15 @@ namespace my_vulkan
             const basic_renderer_shader_modules_t& shaders,
             render_settings_t render_settings = {}
         );
+        // what the descriptors of a pipeline buffer point to, packed for
+        // the update template
+        struct descriptor_data_t
+        {
+            // vertex, then fragment uniforms, as far as they are not empty
+            std::array<VkDescriptorBufferInfo, 2> uniforms;
+            // textures, then input attachments
+            std::array<VkDescriptorImageInfo, num_textures + num_input_attachments> images;
+        };
         class pipeline_buffer_t
         {
         public:
@@ -125,14 +218,30 @@ namespace my_vulkan
             };
             pipeline_buffer_t(
                 device_t* device,
-                VkDescriptorSetLayout layout
+                descriptor_set_t descriptor_set,
+                const descriptor_update_template_t* update_template,
+                uniform_ring_t* uniform_ring
             );
+            // buffers from the renderer's upload functions, shared by
+            // pipeline buffers and never written by them
             void update_vertices(
                 std::shared_ptr<buffer_t> vertices
             );
+            // the vector overloads write into host visible memory owned by
+            // the pipeline buffer, alternating between two copies
             void update_vertices(
                 const std::vector<vertex_t>& vertices
             );
+            // required before binding when the renderer has instances
+            void update_instances(
+                std::shared_ptr<buffer_t> instances
+            );
+            void update_instances(
+                const std::vector<instance_t>& instances
+            );
+            void update_indices(
+                std::shared_ptr<buffer_t> indices
+            );
             void update_indices(
                 const std::vector<uint32_t>& indices
             );
@@ -152,32 +261,132 @@ namespace my_vulkan
             {
                 if (_phase == i)
                     _phase.reset();
+                for (auto* target : {&_dynamic_vertices, &_dynamic_instances, &_dynamic_indices})
+                    for (auto& copy : *target)
+                        if (copy.phase == i)
+                            copy.phase.reset();
             }
             void bind(
                 command_buffer_t::scope_t& command_scope,
                 VkPipelineLayout layout,
                 phase_t phase
             );
+            // what bind would record, filled into packet and queued.
+            // the buffer must not change until the queue was flushed
+            void enqueue(
+                helpers::render_queue_t& queue,
+                helpers::render_packet_t packet,
+                bool indexed,
+                phase_t phase,
+                float depth
+            );
             bool in_use() const;
+            // marks the buffer as used in phase, bind does the same
+            void claim(phase_t phase)
+            {
+                _phase = phase;
+            }
             pinned_t pin() {return pinned_t{*this};}
         private:
             static size_t texture_location_offset();
+            static constexpr size_t max_num_bindings =
+                2 + num_textures + num_input_attachments;
+            // once every binding was written, later writes are collected
+            // and flushed with the template on bind
+            bool defer_write(size_t location);
+            // copies the std140 data of that binding into the ring
+            void push_uniforms(uint32_t location);
+            // offsets from an earlier ring frame can point at recycled
+            // memory, e.g. for pinned buffers not updated every phase.
+            // those are pushed again before binding
+            void refresh_uniforms();
             device_t* _device;
-            buffer_t _vertex_uniforms;
-            buffer_t _fragment_uniforms;
-            descriptor_pool_t _descriptor_pool;
             descriptor_set_t _descriptor_set;
+            const descriptor_update_template_t* _update_template;
+            uniform_ring_t* _uniform_ring;
+            std::array<uint32_t, 2> _dynamic_offsets{};
+            // last values written, by binding
+            std::array<std::vector<char>, 2> _uniform_data;
+            // ring frame the dynamic offsets were allocated in
+            uint64_t _uniform_frame{0};
+            descriptor_data_t _descriptor_data{};
+            std::array<bool, max_num_bindings> _written{};
+            bool _dirty{false};
+            // host visible copies for data written every phase. like the
+            // pipeline buffers themselves each one is marked with the last
+            // phase that drew from it and only rewritten once that phase
+            // comes around again
+            struct dynamic_copy_t
+            {
+                std::shared_ptr<buffer_t> buffer;
+                std::optional<phase_t> phase;
+            };
+            using dynamic_copies_t = std::vector<dynamic_copy_t>;
+            std::shared_ptr<buffer_t> write_dynamic(
+                dynamic_copies_t& target,
+                const void* data,
+                size_t size,
+                VkBufferUsageFlags usage
+            );
+            // marks the copies currently bound as used in phase
+            void claim_dynamic(phase_t phase);
             std::shared_ptr<buffer_t> _vertices;
-            std::optional<buffer_t> _indices;
+            std::shared_ptr<buffer_t> _instances;
+            std::shared_ptr<buffer_t> _indices;
+            dynamic_copies_t _dynamic_vertices;
+            dynamic_copies_t _dynamic_instances;
+            dynamic_copies_t _dynamic_indices;
             std::optional<phase_t> _phase;
             bool _pinned = false;
         };
+        // vertices and indices of many meshes in one pair of buffers, so a
+        // single bind covers a whole draw list
+        class mesh_buffer_t
+        {
+        public:
+            mesh_buffer_t(
+                device_t& device,
+                size_t max_vertices,
+                size_t max_indices
+            );
+            // indices count from the first of the mesh's vertices,
+            // throws when there is no room left
+            mesh_t add(
+                const std::vector<vertex_t>& vertices,
+                const std::vector<uint32_t>& indices
+            );
+            // invalidates all meshes, the buffers must not be in use
+            void clear();
+            VkBuffer vertices();
+            VkBuffer indices();
+        private:
+            buffer_t _vertices;
+            buffer_t _indices;
+            size_t _num_vertices{0};
+            size_t _num_indices{0};
+        };
+        // static_draw waits for the staging copy on the graphics queue
         std::shared_ptr<buffer_t> upload_vertices(
-            const std::vector<vertex_t>& vertices
+            const std::vector<vertex_t>& vertices,
+            geometry_usage_t usage = geometry_usage_t::dynamic_draw
+        );
+        std::shared_ptr<buffer_t> upload_instances(
+            const std::vector<instance_t>& instances,
+            geometry_usage_t usage = geometry_usage_t::dynamic_draw
+        );
+        std::shared_ptr<buffer_t> upload_indices(
+            const std::vector<uint32_t>& indices,
+            geometry_usage_t usage = geometry_usage_t::dynamic_draw
         );
         void begin_phase(phase_t phase)
         {
             _current_phase = phase;
+            // each phase gets its own ring frame, recycled when it comes back
+            auto frame = std::find(_ring_frames.begin(), _ring_frames.end(), phase);
+            if (frame == _ring_frames.end())
+                frame = _ring_frames.insert(frame, phase);
+            _uniform_ring->begin_frame(size_t(frame - _ring_frames.begin()));
+            _indirect_ring->begin_frame(size_t(frame - _ring_frames.begin()));
             for (auto& buffer_ptr : _pipeline_buffers)
                 buffer_ptr->begin_phase(phase);
         }
@@ -185,35 +394,132 @@ namespace my_vulkan
             pipeline_buffer_t& buffer,
             command_buffer_t::scope_t& command_scope,
             index_range_t range,
-            std::optional<VkRect2D> target_rect = std::nullopt
+            std::optional<VkRect2D> target_rect = std::nullopt,
+            index_range_t instance_range = {0, 1}
         );
         void execute_indexed_draw(
             pipeline_buffer_t& buffer,
             command_buffer_t::scope_t& command_scope,
             index_range_t range,
+            std::optional<VkRect2D> target_rect = std::nullopt,
+            index_range_t instance_range = {0, 1}
+        );
+        // same with per draw data, no uniform write involved
+        void execute_draw(
+            pipeline_buffer_t& buffer,
+            command_buffer_t::scope_t& command_scope,
+            index_range_t range,
+            const push_constants_t& push_constants,
+            std::optional<VkRect2D> target_rect = std::nullopt,
+            index_range_t instance_range = {0, 1}
+        );
+        void execute_indexed_draw(
+            pipeline_buffer_t& buffer,
+            command_buffer_t::scope_t& command_scope,
+            index_range_t range,
+            const push_constants_t& push_constants,
+            std::optional<VkRect2D> target_rect = std::nullopt,
+            index_range_t instance_range = {0, 1}
+        );
+        // all draws of the list with one bind, vertices and indices come
+        // from meshes. per draw data can be reached through the instances
+        void execute_indirect_draw(
+            pipeline_buffer_t& buffer,
+            command_buffer_t::scope_t& command_scope,
+            mesh_buffer_t& meshes,
+            const draw_list_t& draw_list,
             std::optional<VkRect2D> target_rect = std::nullopt
         );
+        void execute_indirect_draw(
+            pipeline_buffer_t& buffer,
+            command_buffer_t::scope_t& command_scope,
+            mesh_buffer_t& meshes,
+            const draw_list_t& draw_list,
+            const push_constants_t& push_constants,
+            std::optional<VkRect2D> target_rect = std::nullopt
+        );
+        // queued for sorting instead of recorded, without push constants.
+        // depth in [0, 1] orders draws sharing state
+        void enqueue_draw(
+            helpers::render_queue_t& queue,
+            pipeline_buffer_t& buffer,
+            index_range_t range,
+            float depth = 0,
+            index_range_t instance_range = {0, 1}
+        );
+        void enqueue_indexed_draw(
+            helpers::render_queue_t& queue,
+            pipeline_buffer_t& buffer,
+            index_range_t range,
+            float depth = 0,
+            index_range_t instance_range = {0, 1}
+        );
+        // claims a buffer for the current phase, safe to call from the
+        // threads recording draws in parallel
         pipeline_buffer_t& buffer();
         basic_renderer_t(const basic_renderer_t&) = delete;
         basic_renderer_t(basic_renderer_t&&) noexcept = default;
         basic_renderer_t& operator=(const basic_renderer_t&) = delete;
         basic_renderer_t& operator=(basic_renderer_t&&) noexcept = default;
     private:
+        // renderers with the same configuration share the pipeline
+        basic_renderer_t(
+            output_config_t output_config,
+            std::shared_ptr<graphics_pipeline_t> graphics_pipeline,
+            render_settings_t render_settings
+        );
+        static pipeline_registry_t::description_t pipeline_description(
+            const output_config_t& output_config,
+            render_settings_t render_settings
+        );
         void bind(
             pipeline_buffer_t& buffer,
             command_buffer_t::scope_t& command_scope,
             std::optional<VkRect2D> target_rect
         );
+        void push(
+            command_buffer_t::scope_t& command_scope,
+            const push_constants_t& push_constants
+        );
+        std::shared_ptr<buffer_t> upload_geometry(
+            const void* data,
+            size_t size,
+            VkBufferUsageFlags buffer_usage,
+            geometry_usage_t usage
+        );
+        // binds meshes and records the list in chunks the device allows
+        void draw_indirect(
+            command_buffer_t::scope_t& command_scope,
+            mesh_buffer_t& meshes,
+            const draw_list_t& draw_list
+        );
         static VkVertexInputBindingDescription make_vertex_bindings_description();
         static std::vector<VkVertexInputAttributeDescription> make_attribute_descriptions();
         static vertex_layout_t make_vertex_layout();
         static std::vector<VkDescriptorSetLayoutBinding> make_uniform_layout();
+        static std::vector<VkPushConstantRange> make_push_constant_ranges();
+        static std::vector<VkDescriptorUpdateTemplateEntryKHR> make_update_template_entries();
         device_t* _device{nullptr};
-        std::vector<VkDescriptorSetLayoutBinding> _uniform_layout;
         render_settings_t _render_settings;
         bool _dynamic_viewport{false};
-        graphics_pipeline_t _graphics_pipeline;
+        std::shared_ptr<graphics_pipeline_t> _graphics_pipeline;
+        // the sets of all pipeline buffers, allocated under the mutex
+        descriptor_allocator_t _descriptor_allocator;
+        // null without bindings, behind a pointer as the buffers keep it
+        std::unique_ptr<descriptor_update_template_t> _update_template;
+        // uniform data of all pipeline buffers, bound with dynamic offsets
+        std::unique_ptr<uniform_ring_t> _uniform_ring;
+        // draw commands of indirect draws, same frames as the uniforms
+        std::unique_ptr<uniform_ring_t> _indirect_ring;
+        std::vector<phase_t> _ring_frames;
+        // 1 without multiDrawIndirect
+        uint32_t _max_draw_indirect_count{1};
+        // for static geometry, created on first use
+        std::unique_ptr<command_pool_t> _upload_pool;
+        std::unique_ptr<std::mutex> _upload_mutex{new std::mutex};
         std::vector<std::unique_ptr<pipeline_buffer_t>> _pipeline_buffers;
+        // behind a pointer to keep the renderer movable
+        std::unique_ptr<std::mutex> _pipeline_buffers_mutex{new std::mutex};
         phase_t _current_phase{0, 0};
         size_t _next_buffer_index{0};
     };
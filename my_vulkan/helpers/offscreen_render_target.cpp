@@ -41,92 +41,56 @@ namespace my_vulkan
                         command_buffer_t::scope_t &commands
                     )
                     {
-                        commands.pipeline_barrier(
-                            VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
-                            VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
-                            {VkImageMemoryBarrier{
-                                VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER, nullptr,
-                                0,
-                                VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT,
-                                VK_IMAGE_LAYOUT_UNDEFINED,
-                                VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
-                                VK_QUEUE_FAMILY_IGNORED,
-                                VK_QUEUE_FAMILY_IGNORED,
-                                image.get(),
-                                VkImageSubresourceRange{VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1}
-                            }}
+                        resource_tracker_t tracker;
+                        tracker.use(
+                            image,
+                            image_usage(VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL),
+                            true
                         );
+                        tracker.flush(commands);
                     };
                     end_callback = [
                         &image = _color_buffers[i].image
-                        //size = size
                     ](
                         command_buffer_t::scope_t &commands,
                         buffer_t* readback_buffer
                     )
                     {
-                        commands.pipeline_barrier(
-                            VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
-                            VK_PIPELINE_STAGE_TRANSFER_BIT | VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
-                            {VkImageMemoryBarrier{
-                                .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
-                                .srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT,
-                                .dstAccessMask = (VK_ACCESS_TRANSFER_READ_BIT |
-                                                  VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT |
-                                                  VK_ACCESS_COLOR_ATTACHMENT_READ_BIT),
-                                .oldLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR,
-                                .newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
-                                .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
-                                .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
-                                .image = image.get(),
-                                .subresourceRange = {
-                                        .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
-                                        .baseMipLevel = 0,
-                                        .levelCount = 1,
-                                        .baseArrayLayer = 0,
-                                        .layerCount = 1
-                                }
-                            }}
+                        resource_tracker_t tracker;
+                        // the render pass leaves the image ready to present
+                        tracker.assume(
+                            image.get(),
+                            {
+                                VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+                                VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT,
+                                VK_IMAGE_LAYOUT_PRESENT_SRC_KHR
+                            }
+                        );
+                        tracker.use(
+                            image,
+                            image_usage(VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL)
                         );
+                        tracker.flush(commands);
                         image.copy_to(
                             readback_buffer->get(),
                             commands
                         );
-                        commands.pipeline_barrier(
-                            VK_PIPELINE_STAGE_TRANSFER_BIT,
-                            VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
-                            {VkImageMemoryBarrier{
-                                .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
-                                .srcAccessMask = 0,
-                                .dstAccessMask = 0,
-                                .oldLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
-                                .newLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
-                                .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
-                                .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
-                                .image = image.get(),
-                                .subresourceRange = {
-                                        .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
-                                        .baseMipLevel = 0,
-                                        .levelCount = 1,
-                                        .baseArrayLayer = 0,
-                                        .layerCount = 1
-                                }
-                            }}
+                        tracker.use(
+                            readback_buffer->get(),
+                            {VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT}
+                        );
+                        tracker.flush(commands);
+                        // the image transition and the host read share
+                        // one barrier
+                        tracker.use(
+                            readback_buffer->get(),
+                            {VK_PIPELINE_STAGE_HOST_BIT, VK_ACCESS_HOST_READ_BIT}
                         );
-                        commands.pipeline_barrier(
-                            VK_PIPELINE_STAGE_TRANSFER_BIT,
-                            VK_PIPELINE_STAGE_HOST_BIT,
-                            {VkBufferMemoryBarrier{
-                                    .sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER,
-                                    .srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
-                                    .dstAccessMask = VK_ACCESS_HOST_READ_BIT,
-                                    .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
-                                    .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
-                                    .buffer = readback_buffer->get(),
-                                    .offset = 0,
-                                    .size = VK_WHOLE_SIZE
-                            }}
+                        tracker.use(
+                            image,
+                            image_usage(VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL)
                         );
+                        tracker.flush(commands);
                     };
                 }
                 else
@@ -260,16 +224,30 @@ namespace my_vulkan
 
         void offscreen_render_target_t::end_phase(
             std::vector<queue_reference_t::wait_semaphore_info_t> waits,
-            std::vector<VkSemaphore> signals
+            std::vector<VkSemaphore> signals,
+            std::vector<queue_reference_t::timeline_signal_info_t> timeline_signals
         )
         {
-            _slots[_write_slot].finish(std::move(waits), std::move(signals));
+            _slots[_write_slot].finish(
+                std::move(waits),
+                std::move(signals),
+                std::move(timeline_signals)
+            );
             ++_write_slot;
             _num_slots_filled = std::min(depth(), _num_slots_filled + 1);
             if (_write_slot == _slots.size())
                 _write_slot = 0;
         }
 
+        void offscreen_render_target_t::end_phase(sync_point_refs_t sync_points)
+        {
+            end_phase(
+                std::move(sync_points.waits),
+                std::move(sync_points.signals),
+                std::move(sync_points.timeline_signals)
+            );
+        }
+
         std::optional<cv::Mat4b> offscreen_render_target_t::read_bgra(bool flush)
         {
             if (auto read_slot = consume_read_slot(flush))
@@ -330,7 +308,6 @@ namespace my_vulkan
             } :
             nullptr
         }
-        , _fence{device.get(), VK_FENCE_CREATE_SIGNALED_BIT}
         , _command_pool{device.get(), queue}
         , _command_buffer{_command_pool.make_buffer()}
         , _begin_callback{std::move(begin_callback)}
@@ -338,13 +315,25 @@ namespace my_vulkan
         , _sync_points{std::move(sync_points)}
         , _color_view{color_view}
         {
+            if (device.timeline_semaphores())
+                _timeline.emplace(device);
+            else
+                _fence.emplace(device.get(), VK_FENCE_CREATE_SIGNALED_BIT);
+        }
+
+        void offscreen_render_target_t::slot_t::wait()
+        {
+            if (_timeline)
+                _timeline->wait(_submitted);
+            else
+                _fence->wait();
         }
 
         cv::Mat4b offscreen_render_target_t::slot_t::read_bgra()
         {
             if (!_readback_buffer)
                 throw std::runtime_error{"no readback enabled"};
-            _fence.wait();
+            wait();
             if (_need_invalidate)
                 _mapping->invalidate();
             auto data = ((const unsigned char*)_mapping->data());
@@ -368,8 +357,9 @@ namespace my_vulkan
                 throw std::runtime_error{
                     "double begin in vulkan::offscreen_render_target_t"
                 };
-            _fence.wait();
-            _fence.reset();
+            wait();
+            if (_fence)
+                _fence->reset();
             _commands = _command_buffer.begin(flags);
             if (_begin_callback)
                 _begin_callback(*_commands);
@@ -382,7 +372,8 @@ namespace my_vulkan
 
         void offscreen_render_target_t::slot_t::finish(
             std::vector<queue_reference_t::wait_semaphore_info_t> waits,
-            std::vector<VkSemaphore> signals
+            std::vector<VkSemaphore> signals,
+            std::vector<queue_reference_t::timeline_signal_info_t> timeline_signals
         )
         {
             if (!_commands)
@@ -394,13 +385,27 @@ namespace my_vulkan
             _commands.reset();
             auto in_waits = std::move(waits);
             auto in_signals = std::move(signals);
+            auto in_timeline_signals = std::move(timeline_signals);
             extend_vector(in_waits, _sync_points.waits);
             extend_vector(in_signals, _sync_points.signals);
+            extend_vector(in_timeline_signals, _sync_points.timeline_signals);
+            if (_timeline)
+            {
+                in_timeline_signals.push_back(_timeline->at(++_submitted));
+                _queue->submit(
+                    _command_buffer.get(),
+                    std::move(in_waits),
+                    std::move(in_signals),
+                    std::move(in_timeline_signals)
+                );
+                return;
+            }
             _queue->submit(
                 _command_buffer.get(),
                 std::move(in_waits),
                 std::move(in_signals),
-                _fence.get()
+                std::move(in_timeline_signals),
+                _fence->get()
             );
         }
     }
@@ -2,6 +2,7 @@
 
 #include "../my_vulkan.hpp"
 #include "render_target.hpp"
+#include "sync_points.hpp"
 
 #include <opencv2/core/core.hpp>
 
@@ -25,6 +26,7 @@ namespace my_vulkan
             {
                 std::vector<queue_reference_t::wait_semaphore_info_t> waits;
                 std::vector<VkSemaphore> signals;
+                std::vector<queue_reference_t::timeline_signal_info_t> timeline_signals;
 //                std::vector<fence_t> fences;
             };
             offscreen_render_target_t(
@@ -51,8 +53,10 @@ namespace my_vulkan
             );
             void end_phase(
                 std::vector<queue_reference_t::wait_semaphore_info_t> waits = {},
-                std::vector<VkSemaphore> signals = {}
+                std::vector<VkSemaphore> signals = {},
+                std::vector<queue_reference_t::timeline_signal_info_t> timeline_signals = {}
             );
+            void end_phase(sync_point_refs_t sync_points);
             std::optional<size_t> consume_read_slot(bool flush = false);
             std::optional<cv::Mat4b> read_bgra(bool flush = false);
             void set_texture(size_t phase, VkImageView texture);
@@ -82,17 +86,24 @@ namespace my_vulkan
                 phase_context_t begin(size_t index, VkRect2D rect, VkCommandBufferUsageFlags flags);
                 void finish(
                     std::vector<queue_reference_t::wait_semaphore_info_t> waits,
-                    std::vector<VkSemaphore> signals
+                    std::vector<VkSemaphore> signals,
+                    std::vector<queue_reference_t::timeline_signal_info_t> timeline_signals
                 );
                 cv::Mat4b read_bgra();
                 void set_color_view(VkImageView view);
             private:
+                // until the last submission of this slot is done
+                void wait();
                 queue_reference_t* _queue;
                 VkExtent2D _extent;
                 std::unique_ptr<buffer_t> _readback_buffer;
                 bool _need_invalidate;
                 std::unique_ptr<device_memory_t::mapping_t> _mapping;
-                fence_t _fence;
+                // timeline semaphore if the device supports it, it counts
+                // the submissions of the slot
+                std::optional<timeline_semaphore_t> _timeline;
+                uint64_t _submitted{0};
+                std::optional<fence_t> _fence;
                 command_pool_t _command_pool;
                 command_buffer_t _command_buffer;
                 std::optional<command_buffer_t::scope_t> _commands;
@@ -0,0 +1,54 @@
+#include "parallel_recorder.hpp"
+
+namespace my_vulkan::helpers
+{
+    parallel_recorder_t::parallel_recorder_t(
+        device_t& device,
+        queue_reference_t& queue,
+        size_t num_frames,
+        size_t num_threads
+    )
+    : _pools{device.get(), queue, num_frames, num_threads}
+    , _workers{num_threads}
+    {
+    }
+
+    void parallel_recorder_t::begin_frame(size_t frame)
+    {
+        _pools.begin_frame(frame);
+    }
+
+    size_t parallel_recorder_t::num_threads() const
+    {
+        return _workers.num_workers();
+    }
+
+    void parallel_recorder_t::record(
+        command_buffer_t::scope_t& commands,
+        VkRenderPass render_pass,
+        uint32_t subpass,
+        VkFramebuffer framebuffer,
+        size_t count,
+        const record_item_t& record_item
+    )
+    {
+        if (!count)
+            return;
+        // at most one item per worker, the spare workers record nothing
+        auto num_workers = std::min(num_threads(), count);
+        std::vector<VkCommandBuffer> secondaries(num_workers, VK_NULL_HANDLE);
+        _workers.run([&](size_t worker){
+            if (worker >= num_workers)
+                return;
+            auto begin = count * worker / num_workers;
+            auto end = count * (worker + 1) / num_workers;
+            auto& buffer = _pools.secondary(worker);
+            auto scope = buffer.begin_secondary(render_pass, subpass, framebuffer);
+            for (auto i = begin; i < end; ++i)
+                record_item(scope, i);
+            scope.end();
+            secondaries[worker] = buffer.get();
+        });
+        commands.execute_commands(secondaries);
+    }
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+#include "../command_buffer.hpp"
+#include "../command_pool_set.hpp"
+#include "../device.hpp"
+#include "thread_pool.hpp"
+
+#include <functional>
+
+namespace my_vulkan::helpers
+{
+    // spreads the recording of a subpass over worker threads, each worker
+    // records a contiguous range of items into its own secondary command
+    // buffer so the draw order stays the same as on one thread
+    class parallel_recorder_t
+    {
+    public:
+        using record_item_t = std::function<void(
+            command_buffer_t::scope_t& commands,
+            size_t index
+        )>;
+        parallel_recorder_t(
+            device_t& device,
+            queue_reference_t& queue,
+            size_t num_frames,
+            size_t num_threads = std::max(1u, std::thread::hardware_concurrency())
+        );
+        // recycles the command buffers of the frame, its previous
+        // submission has to be complete
+        void begin_frame(size_t frame);
+        // commands has to be inside a render pass begun with
+        // VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS, record_item is
+        // called concurrently and must only touch per item state
+        void record(
+            command_buffer_t::scope_t& commands,
+            VkRenderPass render_pass,
+            uint32_t subpass,
+            VkFramebuffer framebuffer,
+            size_t count,
+            const record_item_t& record_item
+        );
+        size_t num_threads() const;
+    private:
+        command_pool_set_t _pools;
+        thread_pool_t _workers;
+    };
+}
@@ -0,0 +1,126 @@
+#include "pipeline_compiler.hpp"
+
+namespace my_vulkan::helpers
+{
+    pipeline_compiler_t::pipeline_compiler_t(
+        device_t& device,
+        size_t num_threads
+    )
+    : _device{&device}
+    {
+        for (size_t i = 0; i < std::max<size_t>(1, num_threads); ++i)
+            _threads.emplace_back([this]{ work(); });
+    }
+
+    pipeline_compiler_t::~pipeline_compiler_t()
+    {
+        {
+            std::unique_lock<std::mutex> lock{_mutex};
+            _stop = true;
+            _queue.clear();
+        }
+        _wake.notify_all();
+        for (auto& thread : _threads)
+            thread.join();
+    }
+
+    size_t pipeline_compiler_t::num_queued() const
+    {
+        std::unique_lock<std::mutex> lock{_mutex};
+        return _queue.size();
+    }
+
+    template<typename T>
+    pending_t<T> pipeline_compiler_t::submit(
+        std::function<std::shared_ptr<T>()> compile
+    )
+    {
+        // std::function wants something copyable
+        auto task = std::make_shared<std::packaged_task<std::shared_ptr<T>()>>(
+            std::move(compile)
+        );
+        pending_t<T> result{task->get_future().share()};
+        {
+            std::unique_lock<std::mutex> lock{_mutex};
+            _queue.push_back([task]{ (*task)(); });
+        }
+        _wake.notify_one();
+        return result;
+    }
+
+    pending_t<shader_module_t> pipeline_compiler_t::shader_module(
+        std::vector<uint8_t> code
+    )
+    {
+        auto device = _device->get();
+        return submit<shader_module_t>(
+            [device, code = std::move(code)]{
+                return std::make_shared<shader_module_t>(device, code);
+            }
+        );
+    }
+
+    pending_t<graphics_pipeline_t> pipeline_compiler_t::graphics_pipeline(
+        pipeline_registry_t::description_t description,
+        std::vector<uint8_t> vertex_shader,
+        std::vector<uint8_t> fragment_shader
+    )
+    {
+        auto registry = &_device->pipeline_registry();
+        return submit<graphics_pipeline_t>(
+            [
+                registry,
+                description = std::move(description),
+                vertex_shader = std::move(vertex_shader),
+                fragment_shader = std::move(fragment_shader)
+            ]{
+                return registry->graphics_pipeline(
+                    description,
+                    vertex_shader,
+                    fragment_shader
+                );
+            }
+        );
+    }
+
+    pending_t<graphics_pipeline_t> pipeline_compiler_t::graphics_pipeline(
+        pipeline_registry_t::description_t description,
+        std::shared_ptr<const shader_module_t> vertex_shader,
+        std::shared_ptr<const shader_module_t> fragment_shader
+    )
+    {
+        auto registry = &_device->pipeline_registry();
+        return submit<graphics_pipeline_t>(
+            [
+                registry,
+                description = std::move(description),
+                vertex_shader = std::move(vertex_shader),
+                fragment_shader = std::move(fragment_shader)
+            ]{
+                return registry->graphics_pipeline(
+                    description,
+                    *vertex_shader,
+                    *fragment_shader
+                );
+            }
+        );
+    }
+
+    void pipeline_compiler_t::work()
+    {
+        while (true)
+        {
+            std::function<void()> job;
+            {
+                std::unique_lock<std::mutex> lock{_mutex};
+                _wake.wait(lock, [&]{ return _stop || !_queue.empty(); });
+                if (_stop)
+                    return;
+                job = std::move(_queue.front());
+                _queue.pop_front();
+            }
+            // exceptions end up in the future
+            job();
+        }
+    }
+}
@@ -0,0 +1,95 @@
+#pragma once
+
+#include "../device.hpp"
+#include "../graphics_pipeline.hpp"
+#include "../pipeline_registry.hpp"
+#include "../shader_module.hpp"
+
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace my_vulkan::helpers
+{
+    // result of a compile running in the background
+    template<typename T>
+    class pending_t
+    {
+    public:
+        pending_t() = default;
+        explicit pending_t(std::shared_future<std::shared_ptr<T>> future)
+        : _future{std::move(future)}
+        {
+        }
+        bool valid() const
+        {
+            return _future.valid();
+        }
+        // never blocks
+        bool ready() const
+        {
+            return
+                valid() &&
+                _future.wait_for(std::chrono::seconds{0}) ==
+                    std::future_status::ready;
+        }
+        // blocks until done, rethrows what the compile threw
+        const std::shared_ptr<T>& get() const
+        {
+            return _future.get();
+        }
+        // null while still compiling, so a frame can skip the draw
+        std::shared_ptr<T> try_get() const
+        {
+            return ready() ? _future.get() : nullptr;
+        }
+    private:
+        std::shared_future<std::shared_ptr<T>> _future;
+    };
+
+    // compiles shader modules and graphics pipelines on worker threads.
+    // pipelines go through the device pipeline registry, so a variant
+    // requested twice is compiled once and shared with synchronous users.
+    class pipeline_compiler_t
+    {
+    public:
+        explicit pipeline_compiler_t(
+            device_t& device,
+            size_t num_threads = std::max(1u, std::thread::hardware_concurrency() / 2)
+        );
+        pipeline_compiler_t(const pipeline_compiler_t&) = delete;
+        pipeline_compiler_t& operator=(const pipeline_compiler_t&) = delete;
+        // waits for running compiles, queued ones are dropped and their
+        // pending_t::get() throws std::future_error
+        ~pipeline_compiler_t();
+        pending_t<shader_module_t> shader_module(std::vector<uint8_t> code);
+        pending_t<graphics_pipeline_t> graphics_pipeline(
+            pipeline_registry_t::description_t description,
+            std::vector<uint8_t> vertex_shader,
+            std::vector<uint8_t> fragment_shader
+        );
+        // the modules are kept alive until the compile is done
+        pending_t<graphics_pipeline_t> graphics_pipeline(
+            pipeline_registry_t::description_t description,
+            std::shared_ptr<const shader_module_t> vertex_shader,
+            std::shared_ptr<const shader_module_t> fragment_shader
+        );
+        size_t num_queued() const;
+    private:
+        template<typename T>
+        pending_t<T> submit(std::function<std::shared_ptr<T>()> compile);
+        void work();
+        device_t* _device;
+        std::vector<std::thread> _threads;
+        mutable std::mutex _mutex;
+        std::condition_variable _wake;
+        std::deque<std::function<void()>> _queue;
+        bool _stop{false};
+    };
+}
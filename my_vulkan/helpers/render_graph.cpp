@@ -0,0 +1,468 @@
+#include "render_graph.hpp"
+
+#include "../utils.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace my_vulkan::helpers
+{
+    render_graph_t::render_graph_t(device_t& device)
+    : _device{&device}
+    {
+    }
+
+    render_graph_t::resource_id_t render_graph_t::create_image(
+        image_description_t description
+    )
+    {
+        resource_t resource;
+        resource.transient = description;
+        _resources.push_back(resource);
+        _compiled = false;
+        return _resources.size() - 1;
+    }
+
+    render_graph_t::resource_id_t render_graph_t::import_image(
+        image_t& image,
+        resource_usage_t initial,
+        std::optional<resource_usage_t> final
+    )
+    {
+        resource_t resource;
+        resource.image = &image;
+        resource.initial = initial;
+        resource.final = final;
+        _resources.push_back(resource);
+        _compiled = false;
+        return _resources.size() - 1;
+    }
+
+    render_graph_t::resource_id_t render_graph_t::import_buffer(
+        VkBuffer buffer,
+        VkDeviceSize offset,
+        VkDeviceSize size
+    )
+    {
+        resource_t resource;
+        resource.buffer = buffer;
+        resource.offset = offset;
+        resource.size = size;
+        _resources.push_back(resource);
+        _compiled = false;
+        return _resources.size() - 1;
+    }
+
+    void render_graph_t::add_pass(
+        std::string name,
+        std::vector<access_t> reads,
+        std::vector<access_t> writes,
+        record_t record
+    )
+    {
+        for (auto& access : reads)
+            _resources.at(access.resource);
+        for (auto& access : writes)
+            _resources.at(access.resource);
+        _passes.push_back({
+            std::move(name),
+            std::move(reads),
+            std::move(writes),
+            std::move(record)
+        });
+        _compiled = false;
+    }
+
+    void render_graph_t::compile()
+    {
+        _steps.clear();
+        _transients.clear();
+        _memory_blocks.clear();
+        _final_layouts.clear();
+        for (auto pass : order_passes(live_passes()))
+            _steps.push_back({pass, {}});
+        allocate_transients();
+        plan_barriers();
+        _compiled = true;
+    }
+
+    void render_graph_t::execute(command_buffer_t::scope_t& commands)
+    {
+        if (!_compiled)
+            throw std::runtime_error{"render graph executed before compile"};
+        for (auto& step : _steps)
+        {
+            step.barriers.record(commands);
+            if (auto& record = _passes[step.pass].record)
+                record(commands);
+        }
+        _final_barriers.record(commands);
+        for (auto& [image, layout] : _final_layouts)
+            image->set_layout(layout);
+    }
+
+    image_t& render_graph_t::image(resource_id_t id)
+    {
+        auto& resource = _resources.at(id);
+        if (resource.image)
+            return *resource.image;
+        if (!resource.transient)
+            throw std::runtime_error{"render graph resource is not an image"};
+        if (!_compiled)
+            throw std::runtime_error{"render graph images exist after compile"};
+        auto& transient = _transients[resource.transient_index];
+        if (!transient.image)
+            throw std::runtime_error{"render graph image is not used by any pass"};
+        return *transient.image;
+    }
+
+    std::vector<std::string> render_graph_t::schedule() const
+    {
+        std::vector<std::string> result;
+        for (auto& step : _steps)
+            result.push_back(_passes[step.pass].name);
+        return result;
+    }
+
+    size_t render_graph_t::aliased_memory_blocks() const
+    {
+        return _memory_blocks.size();
+    }
+
+    std::vector<render_graph_t::access_t> render_graph_t::pass_accesses(
+        const pass_t& pass
+    ) const
+    {
+        // one usage per resource, a resource read and written by the same
+        // pass needs a single barrier covering both
+        std::vector<access_t> result;
+        auto add = [&](const access_t& access){
+            auto same = std::find_if(
+                result.begin(),
+                result.end(),
+                [&](auto& x){return x.resource == access.resource;}
+            );
+            if (same == result.end())
+            {
+                result.push_back(access);
+                return;
+            }
+            if (same->usage.layout != access.usage.layout)
+                throw std::runtime_error{
+                    "render graph pass " + pass.name +
+                    " uses an image in two layouts"
+                };
+            same->usage.stages |= access.usage.stages;
+            same->usage.access |= access.usage.access;
+        };
+        for (auto& access : pass.reads)
+            add(access);
+        for (auto& access : pass.writes)
+            add(access);
+        return result;
+    }
+
+    std::vector<bool> render_graph_t::live_passes() const
+    {
+        // walk backwards from the passes writing imported resources
+        std::vector<bool> live(_passes.size(), false);
+        std::vector<bool> needed(_resources.size(), false);
+        for (size_t i = _passes.size(); i-- > 0;)
+        {
+            auto& pass = _passes[i];
+            // nothing to judge a pass without writes by
+            live[i] = pass.writes.empty();
+            for (auto& access : pass.writes)
+                if (!_resources[access.resource].transient || needed[access.resource])
+                    live[i] = true;
+            if (!live[i])
+                continue;
+            for (auto& access : pass.reads)
+                needed[access.resource] = true;
+        }
+        return live;
+    }
+
+    std::vector<size_t> render_graph_t::order_passes(
+        const std::vector<bool>& live
+    ) const
+    {
+        auto num_passes = _passes.size();
+        std::vector<std::vector<size_t>> successors(num_passes);
+        std::vector<size_t> num_dependencies(num_passes, 0);
+        auto depend = [&](size_t from, size_t to){
+            if (from == to)
+                return;
+            successors[from].push_back(to);
+            ++num_dependencies[to];
+        };
+        // read after write, write after write and write after read
+        std::vector<std::optional<size_t>> last_writer(_resources.size());
+        std::vector<std::vector<size_t>> readers(_resources.size());
+        for (size_t i = 0; i < num_passes; ++i)
+        {
+            if (!live[i])
+                continue;
+            for (auto& access : _passes[i].reads)
+            {
+                if (auto writer = last_writer[access.resource])
+                    depend(*writer, i);
+                readers[access.resource].push_back(i);
+            }
+            for (auto& access : _passes[i].writes)
+            {
+                if (auto writer = last_writer[access.resource])
+                    depend(*writer, i);
+                for (auto reader : readers[access.resource])
+                    depend(reader, i);
+                readers[access.resource].clear();
+                last_writer[access.resource] = i;
+            }
+        }
+        std::vector<size_t> ready;
+        for (size_t i = 0; i < num_passes; ++i)
+            if (live[i] && !num_dependencies[i])
+                ready.push_back(i);
+        std::vector<size_t> result;
+        while (!ready.empty())
+        {
+            // prefer a pass that doesn't wait for the previous one, work in
+            // between keeps the barrier from stalling the pipeline
+            auto next = ready.begin();
+            if (!result.empty())
+            {
+                auto& after_previous = successors[result.back()];
+                auto independent = std::find_if(
+                    ready.begin(),
+                    ready.end(),
+                    [&](size_t pass){
+                        return std::find(
+                            after_previous.begin(),
+                            after_previous.end(),
+                            pass
+                        ) == after_previous.end();
+                    }
+                );
+                if (independent != ready.end())
+                    next = independent;
+            }
+            auto pass = *next;
+            ready.erase(next);
+            result.push_back(pass);
+            for (auto successor : successors[pass])
+                if (!--num_dependencies[successor])
+                    ready.insert(
+                        std::lower_bound(ready.begin(), ready.end(), successor),
+                        successor
+                    );
+        }
+        return result;
+    }
+
+    void render_graph_t::allocate_transients()
+    {
+        for (resource_id_t id = 0; id < _resources.size(); ++id)
+        {
+            auto& resource = _resources[id];
+            if (!resource.transient)
+                continue;
+            resource.transient_index = _transients.size();
+            _transients.push_back({id});
+        }
+        for (size_t step = 0; step < _steps.size(); ++step)
+        {
+            for (auto& access : pass_accesses(_passes[_steps[step].pass]))
+            {
+                auto& resource = _resources[access.resource];
+                if (!resource.transient)
+                    continue;
+                auto& transient = _transients[resource.transient_index];
+                if (!transient.image)
+                {
+                    auto& description = *resource.transient;
+                    transient.image = std::make_unique<image_t>(
+                        *_device,
+                        description.extent,
+                        description.format,
+                        description.usage,
+                        image_t::dont_bind_memory_t{}
+                    );
+                    vkGetImageMemoryRequirements(
+                        _device->get(),
+                        transient.image->get(),
+                        &transient.requirements
+                    );
+                    transient.first_step = step;
+                }
+                transient.last_step = step;
+                transient.accumulated_usage.stages |= access.usage.stages;
+                transient.accumulated_usage.access |= access.usage.access;
+            }
+        }
+        // largest first so small images fill in behind big ones
+        std::vector<size_t> by_size;
+        for (size_t i = 0; i < _transients.size(); ++i)
+            if (_transients[i].image)
+                by_size.push_back(i);
+        std::stable_sort(
+            by_size.begin(),
+            by_size.end(),
+            [&](size_t x, size_t y){
+                return
+                    _transients[x].requirements.size >
+                    _transients[y].requirements.size;
+            }
+        );
+        struct block_t
+        {
+            VkDeviceSize size;
+            uint32_t memory_type_bits;
+            std::vector<size_t> members;
+        };
+        std::vector<block_t> blocks;
+        for (auto i : by_size)
+        {
+            auto& transient = _transients[i];
+            auto fits = [&](const block_t& block){
+                if (!(block.memory_type_bits & transient.requirements.memoryTypeBits))
+                    return false;
+                return std::none_of(
+                    block.members.begin(),
+                    block.members.end(),
+                    [&](size_t member){
+                        auto& other = _transients[member];
+                        return
+                            other.first_step <= transient.last_step &&
+                            transient.first_step <= other.last_step;
+                    }
+                );
+            };
+            auto block = std::find_if(blocks.begin(), blocks.end(), fits);
+            if (block == blocks.end())
+            {
+                blocks.push_back({0, ~0u, {}});
+                block = blocks.end() - 1;
+            }
+            // every member sits at offset zero, alignment always holds
+            block->size = std::max(block->size, transient.requirements.size);
+            block->memory_type_bits &= transient.requirements.memoryTypeBits;
+            block->members.push_back(i);
+            transient.block = block - blocks.begin();
+        }
+        _memory_blocks.reserve(blocks.size());
+        for (auto& block : blocks)
+        {
+            auto type = findMemoryType(
+                _device->physical_device(),
+                block.memory_type_bits,
+                VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT
+            );
+            _memory_blocks.emplace_back(
+                *_device,
+                device_memory_t::config_t{block.size, type.index}
+            );
+            std::sort(
+                block.members.begin(),
+                block.members.end(),
+                [&](size_t x, size_t y){
+                    return _transients[x].first_step < _transients[y].first_step;
+                }
+            );
+            for (size_t j = 0; j < block.members.size(); ++j)
+            {
+                auto& transient = _transients[block.members[j]];
+                vk_require(
+                    vkBindImageMemory(
+                        _device->get(),
+                        transient.image->get(),
+                        _memory_blocks.back().get(),
+                        0
+                    ),
+                    "binding render graph image memory"
+                );
+                transient.predecessor = block.members[
+                    (j + block.members.size() - 1) % block.members.size()
+                ];
+            }
+        }
+    }
+
+    void render_graph_t::plan_barriers()
+    {
+        resource_tracker_t tracker;
+        for (auto& resource : _resources)
+            if (resource.image && resource.initial)
+                tracker.assume(resource.image->get(), *resource.initial);
+        std::vector<std::optional<VkImageLayout>> layouts(_resources.size());
+        std::vector<bool> touched(_transients.size(), false);
+        for (size_t step = 0; step < _steps.size(); ++step)
+        {
+            for (auto& access : pass_accesses(_passes[_steps[step].pass]))
+            {
+                auto& resource = _resources[access.resource];
+                if (resource.buffer)
+                {
+                    tracker.use(
+                        resource.buffer,
+                        access.usage,
+                        resource.offset,
+                        resource.size
+                    );
+                    continue;
+                }
+                layouts[access.resource] = access.usage.layout;
+                if (resource.image)
+                {
+                    tracker.use(
+                        resource.image->get(),
+                        image_aspects(resource.image->format()),
+                        access.usage
+                    );
+                    continue;
+                }
+                auto index = resource.transient_index;
+                auto& transient = _transients[index];
+                auto aspects = image_aspects(resource.transient->format);
+                if (touched[index])
+                {
+                    tracker.use(transient.image->get(), aspects, access.usage);
+                    continue;
+                }
+                // wait for every use of the image that had the memory
+                // before, in this frame or at the end of the previous one.
+                // its last use alone can leave earlier reads in other
+                // stages unordered against our writes
+                touched[index] = true;
+                auto& previous = _transients[*transient.predecessor];
+                tracker.assume(
+                    transient.image->get(),
+                    {
+                        previous.accumulated_usage.stages,
+                        previous.accumulated_usage.access,
+                        VK_IMAGE_LAYOUT_UNDEFINED
+                    }
+                );
+                tracker.use(transient.image->get(), aspects, access.usage, true);
+            }
+            _steps[step].barriers = tracker.take_barriers();
+        }
+        for (resource_id_t id = 0; id < _resources.size(); ++id)
+        {
+            auto& resource = _resources[id];
+            if (!resource.image)
+                continue;
+            if (resource.final)
+            {
+                tracker.use(
+                    resource.image->get(),
+                    image_aspects(resource.image->format()),
+                    *resource.final
+                );
+                layouts[id] = resource.final->layout;
+            }
+            if (layouts[id])
+                _final_layouts.push_back({resource.image, *layouts[id]});
+        }
+        _final_barriers = tracker.take_barriers();
+    }
+}
@@ -0,0 +1,123 @@
+#pragma once
+
+#include "../command_buffer.hpp"
+#include "../device.hpp"
+#include "../device_memory.hpp"
+#include "../image.hpp"
+#include "../resource_tracker.hpp"
+
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace my_vulkan::helpers
+{
+    // passes declare what they read and write, compile orders them,
+    // works out the barriers between them and lets transient images whose
+    // lifetimes don't overlap share memory, execute then only replays
+    // the precomputed barriers and the pass callbacks
+    class render_graph_t
+    {
+    public:
+        using resource_id_t = size_t;
+        using record_t = std::function<void(command_buffer_t::scope_t& commands)>;
+        struct image_description_t
+        {
+            VkExtent3D extent;
+            VkFormat format;
+            VkImageUsageFlags usage;
+        };
+        struct access_t
+        {
+            resource_id_t resource;
+            resource_usage_t usage;
+        };
+        explicit render_graph_t(device_t& device);
+        // only exists during the frame, contents are undefined when a pass
+        // first touches it
+        resource_id_t create_image(image_description_t description);
+        // initial is the state every frame finds the image in, final the
+        // state the graph leaves it in
+        resource_id_t import_image(
+            image_t& image,
+            resource_usage_t initial,
+            std::optional<resource_usage_t> final = std::nullopt
+        );
+        resource_id_t import_buffer(
+            VkBuffer buffer,
+            VkDeviceSize offset = 0,
+            VkDeviceSize size = VK_WHOLE_SIZE
+        );
+        // passes are declared in submission order, compile may move a pass
+        // as long as it stays behind the passes whose results it needs
+        void add_pass(
+            std::string name,
+            std::vector<access_t> reads,
+            std::vector<access_t> writes,
+            record_t record
+        );
+        // passes whose writes never reach an imported resource are dropped
+        void compile();
+        void execute(command_buffer_t::scope_t& commands);
+        // valid after compile
+        image_t& image(resource_id_t resource);
+        // names of the passes in execution order
+        std::vector<std::string> schedule() const;
+        size_t aliased_memory_blocks() const;
+    private:
+        struct resource_t
+        {
+            image_t* image{nullptr};
+            std::optional<image_description_t> transient;
+            size_t transient_index{0};
+            VkBuffer buffer{VK_NULL_HANDLE};
+            VkDeviceSize offset{0};
+            VkDeviceSize size{VK_WHOLE_SIZE};
+            std::optional<resource_usage_t> initial;
+            std::optional<resource_usage_t> final;
+        };
+        struct pass_t
+        {
+            std::string name;
+            std::vector<access_t> reads;
+            std::vector<access_t> writes;
+            record_t record;
+        };
+        struct step_t
+        {
+            size_t pass;
+            barrier_batch_t barriers;
+        };
+        struct transient_image_t
+        {
+            resource_id_t resource;
+            std::unique_ptr<image_t> image;
+            VkMemoryRequirements requirements;
+            size_t first_step;
+            size_t last_step;
+            size_t block;
+            // previous image in the same memory, wraps around to the last
+            // one because the next frame reuses the memory
+            std::optional<size_t> predecessor;
+            // every stage and access of the frame, the next user of the
+            // memory waits for all of them
+            resource_usage_t accumulated_usage{0, 0};
+        };
+        std::vector<access_t> pass_accesses(const pass_t& pass) const;
+        std::vector<bool> live_passes() const;
+        std::vector<size_t> order_passes(const std::vector<bool>& live) const;
+        void allocate_transients();
+        void plan_barriers();
+        device_t* _device;
+        std::vector<resource_t> _resources;
+        std::vector<pass_t> _passes;
+        std::vector<step_t> _steps;
+        // declared after the memory so the images are destroyed first
+        std::vector<device_memory_t> _memory_blocks;
+        std::vector<transient_image_t> _transients;
+        barrier_batch_t _final_barriers;
+        std::vector<std::pair<image_t*, VkImageLayout>> _final_layouts;
+        bool _compiled{false};
+    };
+}
@@ -0,0 +1,195 @@
+#include "render_queue.hpp"
+
+#include <algorithm>
+#include <type_traits>
+#include <utility>
+
+namespace my_vulkan::helpers
+{
+    // non dispatchable handles are pointers or integers depending on the
+    // platform
+    template<typename handle_t>
+    static uint64_t handle_bits(handle_t handle)
+    {
+        if constexpr (std::is_pointer<handle_t>::value)
+            return uint64_t(reinterpret_cast<uintptr_t>(handle));
+        else
+            return uint64_t(handle);
+    }
+
+    static uint16_t texture_bits(uint64_t key)
+    {
+        return uint16_t(key >> 16);
+    }
+
+    uint64_t make_sort_key(
+        uint16_t pipeline,
+        uint16_t descriptor_set,
+        uint16_t texture,
+        float depth
+    )
+    {
+        auto quantized_depth = uint16_t(std::clamp(depth, 0.f, 1.f) * 0xffff);
+        return
+            uint64_t(pipeline) << 48 |
+            uint64_t(descriptor_set) << 32 |
+            uint64_t(texture) << 16 |
+            quantized_depth;
+    }
+
+    void render_queue_t::begin_frame()
+    {
+        _pipeline_ids.clear();
+        _descriptor_set_ids.clear();
+        _texture_ids.clear();
+        _unsorted = {};
+        _sorted = {};
+    }
+
+    uint16_t render_queue_t::id_of(
+        std::unordered_map<uint64_t, uint16_t>& ids,
+        uint64_t handle
+    )
+    {
+        // past the last id everything shares it, sorting still groups
+        // the earlier ones
+        auto id = uint16_t(std::min<size_t>(ids.size(), 0xffff));
+        return ids.emplace(handle, id).first->second;
+    }
+
+    uint16_t render_queue_t::pipeline_id(VkPipeline pipeline)
+    {
+        return id_of(_pipeline_ids, handle_bits(pipeline));
+    }
+
+    uint16_t render_queue_t::descriptor_set_id(VkDescriptorSet descriptor_set)
+    {
+        return id_of(_descriptor_set_ids, handle_bits(descriptor_set));
+    }
+
+    uint16_t render_queue_t::texture_id(VkImageView texture)
+    {
+        return id_of(_texture_ids, handle_bits(texture));
+    }
+
+    void render_queue_t::push(uint64_t key, const render_packet_t& packet)
+    {
+        _entries.push_back({key, uint32_t(_packets.size())});
+        _packets.push_back(packet);
+    }
+
+    void render_queue_t::push(
+        const render_packet_t& packet,
+        VkImageView texture,
+        float depth
+    )
+    {
+        push(
+            make_sort_key(
+                pipeline_id(packet.pipeline),
+                descriptor_set_id(packet.descriptor_set),
+                texture_id(texture),
+                depth
+            ),
+            packet
+        );
+    }
+
+    size_t render_queue_t::size() const
+    {
+        return _packets.size();
+    }
+
+    auto render_queue_t::unsorted_state_changes() const -> state_changes_t
+    {
+        return _unsorted;
+    }
+
+    auto render_queue_t::sorted_state_changes() const -> state_changes_t
+    {
+        return _sorted;
+    }
+
+    void render_queue_t::count(
+        const entry_t& entry,
+        const entry_t* previous,
+        state_changes_t& changes
+    ) const
+    {
+        auto& packet = _packets[entry.index];
+        auto* before = previous ? &_packets[previous->index] : nullptr;
+        if (!before || before->pipeline != packet.pipeline)
+            ++changes.pipelines;
+        if (!before || before->descriptor_set != packet.descriptor_set)
+            ++changes.descriptor_sets;
+        if (!previous || texture_bits(previous->key) != texture_bits(entry.key))
+            ++changes.textures;
+    }
+
+    void render_queue_t::sort()
+    {
+        // lsd radix sort on bytes, stable so equal keys keep their push
+        // order. bytes all keys share are skipped
+        constexpr size_t num_buckets = 256;
+        _scratch.resize(_entries.size());
+        for (size_t shift = 0; shift < 64; shift += 8)
+        {
+            std::array<size_t, num_buckets> offsets{};
+            for (auto& entry : _entries)
+                ++offsets[(entry.key >> shift) & 0xff];
+            if (std::find(offsets.begin(), offsets.end(), _entries.size()) != offsets.end())
+                continue;
+            size_t total = 0;
+            for (auto& offset : offsets)
+                total += std::exchange(offset, total);
+            for (auto& entry : _entries)
+                _scratch[offsets[(entry.key >> shift) & 0xff]++] = entry;
+            _entries.swap(_scratch);
+        }
+    }
+
+    void render_queue_t::flush(
+        command_buffer_t::scope_t& commands,
+        std::optional<VkRect2D> target_rect
+    )
+    {
+        const render_packet_t* bound = nullptr;
+        drain([&](const render_packet_t& packet){
+            bool new_pipeline = !bound || bound->pipeline != packet.pipeline;
+            if (new_pipeline)
+                commands.bind_pipeline(
+                    VK_PIPELINE_BIND_POINT_GRAPHICS,
+                    packet.pipeline,
+                    target_rect
+                );
+            bool new_descriptor_set =
+                new_pipeline ||
+                bound->descriptor_set != packet.descriptor_set ||
+                bound->num_dynamic_offsets != packet.num_dynamic_offsets ||
+                bound->dynamic_offsets != packet.dynamic_offsets;
+            if (new_descriptor_set && packet.descriptor_set)
+                commands.bind_descriptor_set(
+                    VK_PIPELINE_BIND_POINT_GRAPHICS,
+                    packet.layout,
+                    {packet.descriptor_set},
+                    0,
+                    {packet.dynamic_offsets.data(), packet.num_dynamic_offsets}
+                );
+            if (packet.vertices && (!bound || bound->vertices != packet.vertices))
+                commands.bind_vertex_buffers({{packet.vertices, 0}});
+            if (packet.instances && (!bound || bound->instances != packet.instances))
+                commands.bind_vertex_buffers({{packet.instances, 0}}, 1);
+            if (packet.indices && (!bound || bound->indices != packet.indices))
+                commands.bind_index_buffer(packet.indices, VK_INDEX_TYPE_UINT32);
+            if (packet.indices)
+                commands.draw_indexed(
+                    packet.range,
+                    uint32_t(packet.vertex_offset),
+                    packet.instance_range
+                );
+            else
+                commands.draw(packet.range, packet.instance_range);
+            bound = &packet;
+        });
+    }
+}
@@ -0,0 +1,116 @@
+#pragma once
+
+#include "../command_buffer.hpp"
+
+#include <array>
+#include <cstdint>
+#include <optional>
+#include <unordered_map>
+#include <vector>
+
+namespace my_vulkan::helpers
+{
+    // all state one graphics draw binds
+    struct render_packet_t
+    {
+        VkPipeline pipeline{VK_NULL_HANDLE};
+        VkPipelineLayout layout{VK_NULL_HANDLE};
+        VkDescriptorSet descriptor_set{VK_NULL_HANDLE};
+        std::array<uint32_t, 2> dynamic_offsets{};
+        uint32_t num_dynamic_offsets{0};
+        VkBuffer vertices{VK_NULL_HANDLE};
+        // bound to binding 1 when set
+        VkBuffer instances{VK_NULL_HANDLE};
+        // draws indexed when set
+        VkBuffer indices{VK_NULL_HANDLE};
+        index_range_t range{0, 0};
+        int32_t vertex_offset{0};
+        index_range_t instance_range{0, 1};
+    };
+
+    // pipeline, descriptor set and texture ids from the high bits down,
+    // so draws sharing state sort next to each other. depth in [0, 1]
+    // takes the low 16 bits and orders draws inside a group front to back
+    uint64_t make_sort_key(
+        uint16_t pipeline,
+        uint16_t descriptor_set,
+        uint16_t texture,
+        float depth
+    );
+
+    // collects draws in any order and records them sorted by key, each
+    // bind is only recorded when the state differs from the draw before
+    class render_queue_t
+    {
+    public:
+        // how often the bound state changes between consecutive draws
+        struct state_changes_t
+        {
+            size_t pipelines{0};
+            size_t descriptor_sets{0};
+            size_t textures{0};
+        };
+        // resets the ids and the counters
+        void begin_frame();
+        // small ids for make_sort_key, stable within a frame
+        uint16_t pipeline_id(VkPipeline pipeline);
+        uint16_t descriptor_set_id(VkDescriptorSet descriptor_set);
+        uint16_t texture_id(VkImageView texture);
+        void push(uint64_t key, const render_packet_t& packet);
+        // keyed by the packet's pipeline and descriptor set, texture and depth
+        void push(
+            const render_packet_t& packet,
+            VkImageView texture,
+            float depth
+        );
+        // radix sorts and records the queued packets, then empties the
+        // queue. commands has to be inside a render pass
+        void flush(
+            command_buffer_t::scope_t& commands,
+            std::optional<VkRect2D> target_rect = std::nullopt
+        );
+        // like flush, but hands the sorted packets to record instead
+        template<typename record_t>
+        void drain(record_t&& record);
+        size_t size() const;
+        // counted over all flushes since begin_frame, in the order the
+        // packets were pushed and in the order they were recorded
+        state_changes_t unsorted_state_changes() const;
+        state_changes_t sorted_state_changes() const;
+    private:
+        struct entry_t
+        {
+            uint64_t key;
+            uint32_t index;
+        };
+        static uint16_t id_of(
+            std::unordered_map<uint64_t, uint16_t>& ids,
+            uint64_t handle
+        );
+        void sort();
+        void count(const entry_t& entry, const entry_t* previous, state_changes_t& changes) const;
+        std::vector<render_packet_t> _packets;
+        std::vector<entry_t> _entries;
+        std::vector<entry_t> _scratch;
+        std::unordered_map<uint64_t, uint16_t> _pipeline_ids;
+        std::unordered_map<uint64_t, uint16_t> _descriptor_set_ids;
+        std::unordered_map<uint64_t, uint16_t> _texture_ids;
+        state_changes_t _unsorted;
+        state_changes_t _sorted;
+    };
+
+    template<typename record_t>
+    void render_queue_t::drain(record_t&& record)
+    {
+        for (size_t i = 0; i < _entries.size(); ++i)
+            count(_entries[i], i ? &_entries[i - 1] : nullptr, _unsorted);
+        sort();
+        for (size_t i = 0; i < _entries.size(); ++i)
+        {
+            count(_entries[i], i ? &_entries[i - 1] : nullptr, _sorted);
+            record(_packets[_entries[i].index]);
+        }
+        _packets.clear();
+        _entries.clear();
+    }
+}
@@ -36,13 +36,18 @@ namespace my_vulkan
                     frame_sync_points_t{
                         semaphore_t{device},
                         semaphore_t{device},
-                        fence_t{
-                            device.get(),
-                            VK_FENCE_CREATE_SIGNALED_BIT
-                        }
+                        std::nullopt,
+                        0
                     }
                 );
+                if (!device.timeline_semaphores())
+                    _frame_sync_points.back().in_flight.emplace(
+                        device.get(),
+                        VK_FENCE_CREATE_SIGNALED_BIT
+                    );
             }
+            if (device.timeline_semaphores())
+                _timeline.emplace(device);
         }
 
         void standard_swap_chain_t::update(VkExtent2D new_extent)
@@ -81,8 +86,15 @@ namespace my_vulkan
             outcome.failure = parent_outcome.failure;
             if (parent_outcome.image_index && !parent_outcome.failure)
             {
-                sync_points.in_flight.wait();
-                sync_points.in_flight.reset();
+                if (_timeline)
+                {
+                    _timeline->wait(sync_points.in_flight_value);
+                }
+                else
+                {
+                    sync_points.in_flight->wait();
+                    sync_points.in_flight->reset();
+                }
                 _pipeline_resources[*parent_outcome.image_index].command_buffer.reset();
                 outcome.working_set = working_set_t{
                     *this,
@@ -120,7 +132,8 @@ namespace my_vulkan
 
         std::optional<acquisition_failure_t> standard_swap_chain_t::working_set_t::finish(
             std::vector<queue_reference_t::wait_semaphore_info_t> wait_semaphores,
-            std::vector<VkSemaphore> signal_semaphores
+            std::vector<VkSemaphore> signal_semaphores,
+            std::vector<queue_reference_t::timeline_signal_info_t> timeline_signals
         )
         {
             auto command_buffer = commands().end();
@@ -129,12 +142,27 @@ namespace my_vulkan
                 VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT
             });
             signal_semaphores.push_back(_sync->render_finished.get());
-            _parent->_graphics_queue->submit(
-                command_buffer,
-                std::move(wait_semaphores),
-                std::move(signal_semaphores),
-                _sync->in_flight.get()
-            );
+            if (auto& timeline = _parent->_timeline)
+            {
+                _sync->in_flight_value = ++_parent->_frames_submitted;
+                timeline_signals.push_back(timeline->at(_sync->in_flight_value));
+                _parent->_graphics_queue->submit(
+                    command_buffer,
+                    std::move(wait_semaphores),
+                    std::move(signal_semaphores),
+                    std::move(timeline_signals)
+                );
+            }
+            else
+            {
+                _parent->_graphics_queue->submit(
+                    command_buffer,
+                    std::move(wait_semaphores),
+                    std::move(signal_semaphores),
+                    std::move(timeline_signals),
+                    _sync->in_flight->get()
+                );
+            }
             if (auto presentation_failure = _parent->_present_queue->present(
                 {_parent->_swap_chain->get(), phase()},
                 {_sync->render_finished.get()}
@@ -143,6 +171,17 @@ namespace my_vulkan
             return std::nullopt;
         }
 
+        std::optional<acquisition_failure_t> standard_swap_chain_t::working_set_t::finish(
+            sync_point_refs_t sync_points
+        )
+        {
+            return finish(
+                std::move(sync_points.waits),
+                std::move(sync_points.signals),
+                std::move(sync_points.timeline_signals)
+            );
+        }
+
         size_t standard_swap_chain_t::depth() const
         {
             return _pipeline_resources.size();
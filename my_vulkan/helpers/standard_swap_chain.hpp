@@ -14,8 +14,10 @@
 #include "../image_view.hpp"
 #include "../fence.hpp"
 #include "../semaphore.hpp"
+#include "../timeline_semaphore.hpp"
 #include "../queue.hpp"
 #include "render_target.hpp"
+#include "sync_points.hpp"
 
 namespace my_vulkan
 {
@@ -27,7 +29,9 @@ namespace my_vulkan
             {
                 semaphore_t image_available;
                 semaphore_t render_finished;
-                fence_t in_flight;
+                // without timeline semaphores
+                std::optional<fence_t> in_flight;
+                uint64_t in_flight_value;
             };
         public:
             struct pipeline_resources_t
@@ -47,8 +51,10 @@ namespace my_vulkan
                 command_buffer_t::scope_t& commands();
                 std::optional<acquisition_failure_t> finish(
                     std::vector<queue_reference_t::wait_semaphore_info_t> wait_semaphores = {},
-                    std::vector<VkSemaphore> signal_semaphores = {}
+                    std::vector<VkSemaphore> signal_semaphores = {},
+                    std::vector<queue_reference_t::timeline_signal_info_t> timeline_signals = {}
                 );
+                std::optional<acquisition_failure_t> finish(sync_point_refs_t sync_points);
             private:
                 standard_swap_chain_t* _parent;
                 frame_sync_points_t* _sync;
@@ -86,6 +92,9 @@ namespace my_vulkan
             command_pool_t _command_pool;
             std::vector<pipeline_resources_t> _pipeline_resources;
             std::vector<frame_sync_points_t> _frame_sync_points;
+            // counts submitted frames if the device supports it
+            std::optional<timeline_semaphore_t> _timeline;
+            uint64_t _frames_submitted{0};
             size_t _current_frame{0};
             bool _updated = false;
         };
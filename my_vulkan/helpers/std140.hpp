@@ -1,5 +1,8 @@
 #pragma once
 #include <array>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
  
  
 //! Round up \p value to next multiple of \p roundedto.
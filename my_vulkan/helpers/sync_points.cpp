@@ -10,6 +10,8 @@ namespace my_vulkan
             extend_waits(std::move(other.waits));
         if (!other.signals.empty())
             extend_signals(std::move(other.signals));
+        if (!other.timeline_signals.empty())
+            extend_timeline_signals(std::move(other.timeline_signals));
     }
 
     void sync_point_refs_t::extend_waits(sync_point_refs_t::waits_t o)
@@ -22,13 +24,21 @@ namespace my_vulkan
         extend_vector(signals, std::move(o));
     }
 
+    void sync_point_refs_t::extend_timeline_signals(sync_point_refs_t::timeline_signals_t o)
+    {
+        extend_vector(timeline_signals, std::move(o));
+    }
+
     std::string sync_point_refs_t::to_string()
     {
         std::ostringstream ss;
         ss << "waits=[";
         for (auto &wait: waits)
         {
-            ss << wait.semaphore << ", ";
+            ss << wait.semaphore;
+            if (wait.value)
+                ss << "@" << wait.value;
+            ss << ", ";
         }
         ss << "]";
         ss << "signals=[";
@@ -36,6 +46,10 @@ namespace my_vulkan
         {
             ss << signal << ", ";
         }
+        for (auto &signal: timeline_signals)
+        {
+            ss << signal.semaphore << "@" << signal.value << ", ";
+        }
         ss << "]";
         return ss.str();
     }
@@ -8,13 +8,17 @@ namespace my_vulkan
     {
         using waits_t = std::vector <my_vulkan::queue_reference_t::wait_semaphore_info_t>;
         using signals_t = std::vector <VkSemaphore>;
+        using timeline_signals_t = std::vector <my_vulkan::queue_reference_t::timeline_signal_info_t>;
         using fences_t = std::vector<fence_t>;
+        // timeline waits carry their value in waits
         waits_t waits;
         signals_t signals;
+        timeline_signals_t timeline_signals;
 //        fences_t fences;
         void extend(sync_point_refs_t o);
         void extend_waits(waits_t o);
         void extend_signals(signals_t o);
+        void extend_timeline_signals(timeline_signals_t o);
         std::string to_string();
     };
 }
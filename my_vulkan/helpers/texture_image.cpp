@@ -1,4 +1,7 @@
 #include "texture_image.hpp"
+#include "../staging_ring.hpp"
+
+#include <cstring>
 
 namespace my_vulkan::helpers
 {
@@ -64,9 +67,26 @@ namespace my_vulkan::helpers
         std::optional<uint32_t> pitch
     )
     {
+        // we know when this submission completes, so the data can go
+        // through the shared staging ring instead of our own buffer
+        auto& staging_ring = _device->staging_ring();
+        auto staging = staging_ring.allocate(
+            _transfer_byte_size,
+            _num_components % 4 ? _num_components * 4 : _num_components
+        );
+        std::memcpy(staging.data, pixels, _transfer_byte_size);
         auto oneshot_scope = command_pool.begin_oneshot();
-        upload(oneshot_scope.commands(), pixels, pitch);
-        oneshot_scope.execute_and_wait();
+        record_upload(oneshot_scope.commands(), staging.buffer, staging.offset, pitch);
+        auto submission = staging_ring.retire({staging});
+        try
+        {
+            oneshot_scope.execute_and_wait(submission.fence);
+        }
+        catch (...)
+        {
+            staging_ring.abandon(submission);
+            throw;
+        }
         if (!keep_buffers)
             _staging_buffer.reset();
     }
@@ -77,15 +97,42 @@ namespace my_vulkan::helpers
         std::optional<uint32_t> pitch
     )
     {
+        // the caller submits, so the data has to stay in a buffer we own
         staging_buffer().memory()->set_data(pixels, _transfer_byte_size);
+        record_upload(commands, staging_buffer().get(), 0, pitch);
+    }
+
+    void texture_image_t::upload(
+        upload_batch_t& batch,
+        const void* pixels,
+        std::optional<uint32_t> pitch
+    )
+    {
+        auto staging = batch.stage(
+            pixels,
+            _transfer_byte_size,
+            _num_components % 4 ? _num_components * 4 : _num_components
+        );
+        record_upload(batch.commands(), staging.buffer, staging.offset, pitch);
+    }
+
+    void texture_image_t::record_upload(
+        command_buffer_t::scope_t& commands,
+        VkBuffer buffer,
+        VkDeviceSize offset,
+        std::optional<uint32_t> pitch
+    )
+    {
         prepare_for_transfer(commands);
         auto out_pitch = _pitch;
         if (pitch)
             out_pitch = *pitch / _num_components;
         _image.copy_from(
-            staging_buffer().get(),
+            buffer,
             commands,
-            out_pitch
+            out_pitch,
+            std::nullopt,
+            offset
         );
         prepare_for_shader(commands);
     }
@@ -4,6 +4,7 @@
 #include "../device.hpp"
 #include "../buffer.hpp"
 #include "../texture_sampler.hpp"
+#include "../upload_batch.hpp"
 
 namespace my_vulkan::helpers
 {
@@ -29,6 +30,11 @@ namespace my_vulkan::helpers
             const void* pixels,
             std::optional<uint32_t> pitch = std::nullopt
         );
+        void upload(
+            upload_batch_t& batch,
+            const void* pixels,
+            std::optional<uint32_t> pitch = std::nullopt
+        );
         void prepare_for_transfer(my_vulkan::command_pool_t& command_pool);
         void prepare_for_shader(my_vulkan::command_pool_t& command_pool);
         void prepare_for_transfer(command_buffer_t::scope_t& commands);
@@ -37,6 +43,12 @@ namespace my_vulkan::helpers
         VkFormat format() const;
         std::optional<device_memory_t::external_memory_info_t> external_memory_info(VkExternalMemoryHandleTypeFlagBits externalHandleType);
     private:
+        void record_upload(
+            command_buffer_t::scope_t& commands,
+            VkBuffer buffer,
+            VkDeviceSize offset,
+            std::optional<uint32_t> pitch
+        );
         buffer_t& staging_buffer();
         device_t* _device;
         uint32_t _num_components;
@@ -0,0 +1,85 @@
+#include "thread_pool.hpp"
+
+namespace my_vulkan::helpers
+{
+    thread_pool_t::thread_pool_t(size_t num_workers)
+    {
+        for (size_t i = 1; i < num_workers; ++i)
+            _threads.emplace_back([this, i]{ work(i); });
+    }
+
+    thread_pool_t::~thread_pool_t()
+    {
+        {
+            std::unique_lock<std::mutex> lock{_mutex};
+            _stop = true;
+        }
+        _start.notify_all();
+        for (auto& thread : _threads)
+            thread.join();
+    }
+
+    size_t thread_pool_t::num_workers() const
+    {
+        return _threads.size() + 1;
+    }
+
+    void thread_pool_t::run(const job_t& job)
+    {
+        {
+            std::unique_lock<std::mutex> lock{_mutex};
+            _job = &job;
+            _running = _threads.size();
+            _error = nullptr;
+            ++_generation;
+        }
+        _start.notify_all();
+        std::exception_ptr error;
+        try
+        {
+            job(0);
+        }
+        catch (...)
+        {
+            error = std::current_exception();
+        }
+        std::unique_lock<std::mutex> lock{_mutex};
+        _done.wait(lock, [&]{ return _running == 0; });
+        _job = nullptr;
+        if (!error)
+            error = _error;
+        if (error)
+            std::rethrow_exception(error);
+    }
+
+    void thread_pool_t::work(size_t worker)
+    {
+        size_t generation = 0;
+        while (true)
+        {
+            const job_t* job;
+            {
+                std::unique_lock<std::mutex> lock{_mutex};
+                _start.wait(lock, [&]{ return _stop || _generation != generation; });
+                if (_stop)
+                    return;
+                generation = _generation;
+                job = _job;
+            }
+            std::exception_ptr error;
+            try
+            {
+                (*job)(worker);
+            }
+            catch (...)
+            {
+                error = std::current_exception();
+            }
+            std::unique_lock<std::mutex> lock{_mutex};
+            if (error && !_error)
+                _error = error;
+            if (--_running == 0)
+                _done.notify_one();
+        }
+    }
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <algorithm>
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace my_vulkan::helpers
+{
+    // fixed set of worker threads that all run the same job, the calling
+    // thread takes part as worker 0
+    class thread_pool_t
+    {
+    public:
+        using job_t = std::function<void(size_t worker)>;
+        explicit thread_pool_t(
+            size_t num_workers = std::max(1u, std::thread::hardware_concurrency())
+        );
+        thread_pool_t(const thread_pool_t&) = delete;
+        thread_pool_t& operator=(const thread_pool_t&) = delete;
+        ~thread_pool_t();
+        // runs job once on every worker and returns when all are done,
+        // the first exception thrown by a worker is rethrown
+        void run(const job_t& job);
+        size_t num_workers() const;
+    private:
+        void work(size_t worker);
+        std::vector<std::thread> _threads;
+        std::mutex _mutex;
+        std::condition_variable _start;
+        std::condition_variable _done;
+        const job_t* _job{nullptr};
+        size_t _generation{0};
+        size_t _running{0};
+        std::exception_ptr _error;
+        bool _stop{false};
+    };
+}
@@ -3,9 +3,18 @@
 
 #include <glm/glm.hpp>
 
+#include <boost/fusion/include/at_c.hpp>
 #include <boost/fusion/include/for_each.hpp>
+#include <boost/fusion/include/is_sequence.hpp>
+#include <boost/fusion/include/size.hpp>
+#include <boost/fusion/include/value_at.hpp>
 #include <boost/range/counting_range.hpp>
 
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <utility>
 #include <vector>
 
 struct std140_data
@@ -97,19 +106,219 @@ namespace std
     }
 }
 
+// layouts known at compile time, writing is a plain store per member
+// into the destination, e.g. a persistently mapped buffer. padding is
+// left untouched.
+enum class block_layout_t
+{
+    std140,
+    std430
+};
+
+template<typename T, block_layout_t layout, typename enable_t = void>
+struct block_layout_traits;
+
+template<typename T, typename stored_t>
+struct block_layout_scalar_traits
+{
+    static constexpr size_t align = sizeof(stored_t);
+    static constexpr size_t size = sizeof(stored_t);
+    static void write(const T& value, char* dst)
+    {
+        stored_t stored = value;
+        std::memcpy(dst, &stored, sizeof(stored));
+    }
+};
+
+template<block_layout_t layout>
+struct block_layout_traits<bool, layout>
+: block_layout_scalar_traits<bool, std140_bool>
+{};
+
+template<block_layout_t layout>
+struct block_layout_traits<int, layout>
+: block_layout_scalar_traits<int, std140_int>
+{};
+
+template<block_layout_t layout>
+struct block_layout_traits<uint32_t, layout>
+: block_layout_scalar_traits<uint32_t, std140_uint>
+{};
+
+template<block_layout_t layout>
+struct block_layout_traits<float, layout>
+: block_layout_scalar_traits<float, std140_float>
+{};
+
+template<typename vec_t, size_t n>
+struct block_layout_vector_traits
+{
+    static constexpr size_t align = std140_vector<float, n>::align;
+    static constexpr size_t size = sizeof(float) * n;
+    static void write(const vec_t& v, char* dst)
+    {
+        std::memcpy(dst, &v[0], size);
+    }
+};
+
+template<block_layout_t layout>
+struct block_layout_traits<glm::vec2, layout>
+: block_layout_vector_traits<glm::vec2, 2>
+{};
+
+template<block_layout_t layout>
+struct block_layout_traits<glm::vec3, layout>
+: block_layout_vector_traits<glm::vec3, 3>
+{};
+
+template<block_layout_t layout>
+struct block_layout_traits<glm::vec4, layout>
+: block_layout_vector_traits<glm::vec4, 4>
+{};
+
+// column major, columns are padded to vec4 in both layouts
+template<typename mat_t, size_t n>
+struct block_layout_matrix_traits
+{
+    static constexpr size_t stride = 16;
+    static constexpr size_t align = 16;
+    static constexpr size_t size = stride * n;
+    static void write(const mat_t& m, char* dst)
+    {
+        for (size_t i = 0; i < n; ++i)
+            std::memcpy(dst + i * stride, &m[i][0], sizeof(float) * n);
+    }
+};
+
+template<block_layout_t layout>
+struct block_layout_traits<glm::mat3, layout>
+: block_layout_matrix_traits<glm::mat3, 3>
+{};
+
+template<block_layout_t layout>
+struct block_layout_traits<glm::mat4, layout>
+: block_layout_matrix_traits<glm::mat4, 4>
+{};
+
+// std140 rounds array strides and alignment up to 16, std430 does not
+template<typename value_t, size_t n, block_layout_t layout>
+struct block_layout_traits<std::array<value_t, n>, layout>
+{
+    typedef block_layout_traits<value_t, layout> value_traits;
+    static constexpr size_t align = layout == block_layout_t::std140 ?
+        roundedup(value_traits::align, 16) :
+        value_traits::align;
+    static constexpr size_t stride = roundedup(value_traits::size, align);
+    static constexpr size_t size = stride * n;
+    static void write(const std::array<value_t, n>& values, char* dst)
+    {
+        for (size_t i = 0; i < n; ++i)
+            value_traits::write(values[i], dst + i * stride);
+    }
+};
+
+// offsets of members placed one after the other, the last entry is the
+// end of the last member
+template<size_t n>
+constexpr std::array<size_t, n + 1> block_layout_offsets(
+    const std::array<size_t, n>& aligns,
+    const std::array<size_t, n>& sizes
+)
+{
+    std::array<size_t, n + 1> result{};
+    size_t offset = 0;
+    for (size_t i = 0; i < n; ++i)
+    {
+        offset = roundedup(offset, aligns[i]);
+        result[i] = offset;
+        offset += sizes[i];
+    }
+    result[n] = offset;
+    return result;
+}
+
+template<
+    typename struct_t,
+    block_layout_t layout,
+    typename indices_t = std::make_index_sequence<
+        boost::fusion::result_of::size<struct_t>::value
+    >
+>
+struct block_layout_struct_traits;
+
+template<typename struct_t, block_layout_t layout, size_t... i>
+struct block_layout_struct_traits<struct_t, layout, std::index_sequence<i...>>
+{
+    template<size_t k>
+    using member_traits = block_layout_traits<
+        typename boost::fusion::result_of::value_at_c<struct_t, k>::type,
+        layout
+    >;
+    static constexpr size_t max_member_align =
+        std::max({size_t{1}, member_traits<i>::align...});
+    // std140 rounds struct alignment up to 16, std430 does not
+    static constexpr size_t align = layout == block_layout_t::std140 ?
+        roundedup(max_member_align, 16) :
+        max_member_align;
+    static constexpr std::array<size_t, sizeof...(i) + 1> offsets =
+        block_layout_offsets<sizeof...(i)>(
+            {member_traits<i>::align...},
+            {member_traits<i>::size...}
+        );
+    static constexpr size_t size = roundedup(offsets[sizeof...(i)], align);
+    static void write(const struct_t& value, char* dst)
+    {
+        (
+            member_traits<i>::write(
+                boost::fusion::at_c<i>(value),
+                dst + offsets[i]
+            ),
+            ...
+        );
+    }
+};
+
+template<typename struct_t, block_layout_t layout>
+struct block_layout_traits<
+    struct_t,
+    layout,
+    typename std::enable_if<
+        boost::fusion::traits::is_sequence<struct_t>::value
+    >::type
+>
+: block_layout_struct_traits<struct_t, layout>
+{};
+
+template<typename T>
+constexpr size_t std140_size = block_layout_traits<T, block_layout_t::std140>::size;
+
+template<typename T>
+constexpr size_t std430_size = block_layout_traits<T, block_layout_t::std430>::size;
+
+// dst needs std140_size<T> bytes, aligned to 16
+template<typename T>
+inline void write_std140(const T& value, void* dst)
+{
+    block_layout_traits<T, block_layout_t::std140>::write(
+        value,
+        static_cast<char*>(dst)
+    );
+}
+
+// dst needs std430_size<T> bytes
+template<typename T>
+inline void write_std430(const T& value, void* dst)
+{
+    block_layout_traits<T, block_layout_t::std430>::write(
+        value,
+        static_cast<char*>(dst)
+    );
+}
+
 template<typename struct_t>
 inline std140_data to_std140(struct_t the_struct)
 {
-    std::vector<char> result;
-    boost::fusion::for_each(
-        the_struct,
-        [&](auto v){
-            auto data = to_std140(v);
-            size_t aligned_size = roundedup(result.size(), data.align);
-            if (aligned_size > result.size())
-                result.resize(aligned_size);
-            result.insert(result.end(), data.data.begin(), data.data.end());
-        }
-    );
+    std::vector<char> result(std140_size<struct_t>);
+    write_std140(the_struct, result.data());
     return {result, 16};
 }
@@ -2,17 +2,22 @@
 
 #include "buffer.hpp"
 #include "fence.hpp"
+#include "resource_tracker.hpp"
+#include "staging_ring.hpp"
 #include "utils.hpp"
 
+#include <cstring>
 #include <stdexcept>
 #include <iostream>
 
 namespace my_vulkan
 {
-    static device_memory_t::config_t find_image_memory_config(
+    static std::unique_ptr<device_memory_t> make_image_memory(
         VkPhysicalDevice physical_device,
         VkDevice logical_device,
+        memory_allocator_t* allocator,
         VkImage image,
+        VkImageTiling tiling,
         VkMemoryPropertyFlags properties,
         PFN_vkGetMemoryFdKHR pfn_vkGetMemoryFdKHR,
         std::optional<VkExternalMemoryHandleTypeFlags> external_handle_types = std::nullopt
@@ -25,12 +30,26 @@ namespace my_vulkan
             requirements.memoryTypeBits,
             properties
         );
-        return {
-            requirements.size,
-            type.index,
-            external_handle_types,
-            pfn_vkGetMemoryFdKHR
-        };
+        if (allocator)
+        {
+            return std::make_unique<device_memory_t>(
+                logical_device,
+                *allocator,
+                requirements,
+                type.index,
+                tiling == VK_IMAGE_TILING_LINEAR
+            );
+        }
+        return std::make_unique<device_memory_t>(
+            logical_device,
+            device_memory_t::config_t{
+                requirements.size,
+                type.index,
+                external_handle_types,
+                pfn_vkGetMemoryFdKHR,
+                type.properties
+            }
+        );
     }
 
     static VkImage make_image(
@@ -87,6 +106,7 @@ namespace my_vulkan
     : image_t{
         device.get(),
         device.physical_device(),
+        &device,
         extent,
         format,
         usage,
@@ -113,6 +133,7 @@ namespace my_vulkan
     : image_t{
         device.get(),
         device.physical_device(),
+        &device,
         extent,
         format,
         usage,
@@ -128,6 +149,7 @@ namespace my_vulkan
     image_t::image_t(
         VkDevice device,
         VkPhysicalDevice physical_device,
+        device_t* owner,
         VkExtent3D extent,
         VkFormat format,
         VkImageUsageFlags usage,
@@ -140,6 +162,7 @@ namespace my_vulkan
     )
     : _device{device}
     , _physical_device{physical_device}
+    , _owner{owner}
     , _external_handle_types{external_handle_types}
     , _image{make_image(
         _device,
@@ -155,22 +178,22 @@ namespace my_vulkan
     , _layout{initial_layout}
     , _borrowed{false}
     , _memory{bind_memory ?
-        new device_memory_t{
+        make_image_memory(
+            physical_device,
             _device,
-            find_image_memory_config(
-                physical_device,
-                _device,
-                _image,
-                properties,
-                pfn_vkGetMemoryFdKHR,
-                external_handle_types
-            )
-        } :
+            // exported memory keeps its dedicated allocation
+            owner && !external_handle_types ? &owner->memory_allocator() : nullptr,
+            _image,
+            tiling,
+            properties,
+            pfn_vkGetMemoryFdKHR,
+            external_handle_types
+        ) :
         nullptr
     }
     {
         if (_memory)
-            vkBindImageMemory(_device, _image, _memory->get(), 0);
+            vkBindImageMemory(_device, _image, _memory->get(), _memory->offset());
     }
 
     image_t::image_t(
@@ -201,6 +224,7 @@ namespace my_vulkan
     )
     : _device{device}
     , _physical_device{physical_device}
+    , _owner{nullptr}
     , _image{image}
     , _format{format}
     , _extent{extent}
@@ -225,6 +249,8 @@ namespace my_vulkan
         _extent = other._extent;
         _borrowed = other._borrowed;
         _physical_device = other._physical_device;
+        _owner = other._owner;
+        _external_handle_types = other._external_handle_types;
         _layout = other._layout;
         std::swap(_device, other._device);
         return *this;
@@ -300,6 +326,11 @@ namespace my_vulkan
         return _layout;
     }
 
+    void image_t::set_layout(VkImageLayout layout)
+    {
+        _layout = layout;
+    }
+
     VkSubresourceLayout image_t::memory_layout(
         int aspect_flags,
         uint32_t mipLevel,
@@ -342,11 +373,12 @@ namespace my_vulkan
         VkBuffer buffer,
         command_buffer_t::scope_t& command_scope,
         uint32_t pitch,
-        std::optional<VkExtent3D> in_extent
+        std::optional<VkExtent3D> in_extent,
+        VkDeviceSize buffer_offset
     )
     {
         VkBufferImageCopy region = {};
-        region.bufferOffset = 0;
+        region.bufferOffset = buffer_offset;
         region.bufferRowLength = pitch;
         region.bufferImageHeight = 0;
         region.imageSubresource = {
@@ -459,6 +491,10 @@ namespace my_vulkan
         {
             std::cerr << "WARNING: old layout is the same as new layout.";
         }
+        // any pair of layouts works, each side gets the stages and accesses
+        // its layout is typically used with
+        auto source = image_usage(oldLayout);
+        auto destination = image_usage(newLayout);
         VkImageMemoryBarrier barrier = {};
         barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
         barrier.oldLayout = oldLayout;
@@ -466,99 +502,19 @@ namespace my_vulkan
         barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
         barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
         barrier.image = get();
-
-        if (newLayout == VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL)
-        {
-            barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_DEPTH_BIT;
-            if (has_stencil_component(format()))
-                barrier.subresourceRange.aspectMask |= VK_IMAGE_ASPECT_STENCIL_BIT;
-        }
-        else
-        {
-            barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-        }
-
+        barrier.subresourceRange.aspectMask = image_aspects(format());
         barrier.subresourceRange.baseMipLevel = 0;
         barrier.subresourceRange.levelCount = 1;
         barrier.subresourceRange.baseArrayLayer = 0;
         barrier.subresourceRange.layerCount = 1;
-
-        VkPipelineStageFlags sourceStage;
-        VkPipelineStageFlags destinationStage;
-
-        if (
-            oldLayout == VK_IMAGE_LAYOUT_UNDEFINED &&
-            newLayout == VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL
-        )
-        {
-            barrier.srcAccessMask = 0;
-            barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
-
-            sourceStage = VK_PIPELINE_STAGE_TRANSFER_BIT;
-            destinationStage = VK_PIPELINE_STAGE_TRANSFER_BIT;
-        }
-        else if (
-            oldLayout == VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL &&
-            newLayout == VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL
-        ) 
-        {
-            barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
-            barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
-            sourceStage = VK_PIPELINE_STAGE_TRANSFER_BIT;
-            destinationStage = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
-        }
-        else if (
-            oldLayout == VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL &&
-            newLayout == VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL
-        ) 
-        {
-            barrier.srcAccessMask = VK_ACCESS_SHADER_READ_BIT;
-            barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
-            sourceStage = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
-            destinationStage = VK_PIPELINE_STAGE_TRANSFER_BIT;
-        }
-        else if (
-            oldLayout == VK_IMAGE_LAYOUT_UNDEFINED &&
-            newLayout == VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL
-        ) 
-        {
-            barrier.srcAccessMask = 0;
-            barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
-            sourceStage = VK_PIPELINE_STAGE_TRANSFER_BIT;
-            destinationStage = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
-        }
-        else if (
-            oldLayout == VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL &&
-            newLayout == VK_IMAGE_LAYOUT_GENERAL
-        ) 
-        {
-            barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
-            barrier.dstAccessMask = VK_ACCESS_MEMORY_READ_BIT;
-            sourceStage = VK_PIPELINE_STAGE_TRANSFER_BIT;
-            destinationStage = VK_PIPELINE_STAGE_TRANSFER_BIT;
-        }
-        else if (
-            oldLayout == VK_IMAGE_LAYOUT_UNDEFINED &&
-            newLayout == VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL
-        )
-        {
-            barrier.srcAccessMask = 0;
-            barrier.dstAccessMask =
-                VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT |
-                VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
-            sourceStage = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
-            destinationStage = VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT;
-        }
-        else
-        {
-            throw std::invalid_argument("unsupported layout transition!");
-        }
+        barrier.srcAccessMask = source.access;
+        barrier.dstAccessMask = destination.access;
 
         _layout = newLayout;
 
         command_scope.pipeline_barrier(
-            sourceStage,
-            destinationStage,
+            source.stages,
+            destination.stages,
             {barrier}
         );        
     }
@@ -573,30 +529,63 @@ namespace my_vulkan
         size_t image_size =
             _extent.width *
             pitch.value_or(_extent.height * bytes_per_pixel(format()));
-        buffer_t staging_buffer{
-            _device,
-            _physical_device,
-            image_size,
-            VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-            nullptr
-        };
-        staging_buffer.memory()->set_data(pixels, image_size);
+        std::optional<buffer_t> staging_buffer;
+        std::optional<staging_ring_t::region_t> staging;
+        if (_owner)
+        {
+            // copy offsets must be a multiple of 4 and of the texel size
+            auto texel_size = VkDeviceSize(bytes_per_pixel(format()));
+            staging = _owner->staging_ring().allocate(
+                image_size,
+                std::max<VkDeviceSize>(texel_size % 4 ? texel_size * 4 : texel_size, 4)
+            );
+            std::memcpy(staging->data, pixels, image_size);
+        }
+        else
+        {
+            staging_buffer.emplace(
+                _device,
+                _physical_device,
+                image_size,
+                VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+                VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+                nullptr
+            );
+            staging_buffer->memory()->set_data(pixels, image_size);
+        }
         transition_layout(
             VK_IMAGE_LAYOUT_UNDEFINED,
             VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
             oneshot_scope.commands()
         );
         copy_from(
-            staging_buffer.get(),
-            oneshot_scope.commands()
+            staging ? staging->buffer : staging_buffer->get(),
+            oneshot_scope.commands(),
+            0,
+            std::nullopt,
+            staging ? staging->offset : 0
         );
         transition_layout(
             VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
             VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
             oneshot_scope.commands()
         );
-        oneshot_scope.execute_and_wait();
+        if (!staging)
+        {
+            oneshot_scope.execute_and_wait();
+            return;
+        }
+        auto& staging_ring = _owner->staging_ring();
+        auto submission = staging_ring.retire({*staging});
+        try
+        {
+            oneshot_scope.execute_and_wait(submission.fence);
+        }
+        catch (...)
+        {
+            staging_ring.abandon(submission);
+            throw;
+        }
     }
 
     std::optional<device_memory_t::external_memory_info_t> image_t::external_memory_info(VkExternalMemoryHandleTypeFlagBits externalHandleType)
@@ -67,11 +67,14 @@ namespace my_vulkan
         VkFormat format() const;
         VkExtent3D extent() const;
         VkImageLayout layout() const;
+        // for transitions recorded by hand instead of transition_layout
+        void set_layout(VkImageLayout layout);
         void copy_from(
             VkBuffer buffer,
             command_buffer_t::scope_t& command_scope,
             uint32_t pitch = 0,
-            std::optional<VkExtent3D> extent = std::nullopt
+            std::optional<VkExtent3D> extent = std::nullopt,
+            VkDeviceSize buffer_offset = 0
         );
         void copy_from(
             VkBuffer buffer,
@@ -115,6 +118,7 @@ namespace my_vulkan
         image_t(
             VkDevice device,
             VkPhysicalDevice physical_device,
+            device_t* owner,
             VkExtent3D extent,
             VkFormat format,
             VkImageUsageFlags usage,
@@ -129,6 +133,7 @@ namespace my_vulkan
         void cleanup();
         VkDevice _device;
         VkPhysicalDevice _physical_device;
+        device_t* _owner;
         std::optional<VkExternalMemoryHandleTypeFlags> _external_handle_types;
         VkImage _image;
         VkFormat _format;
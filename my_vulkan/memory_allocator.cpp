@@ -0,0 +1,257 @@
+#include "memory_allocator.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+
+#include "utils.hpp"
+
+namespace my_vulkan
+{
+    static uint32_t order_for(VkDeviceSize size)
+    {
+        uint32_t order = 0;
+        while ((memory_allocator_t::min_allocation_size << order) < size)
+            ++order;
+        return order;
+    }
+
+    static VkDeviceSize floor_power_of_two(VkDeviceSize size)
+    {
+        VkDeviceSize result = 1;
+        while (result <= size / 2)
+            result <<= 1;
+        return result;
+    }
+
+    memory_allocator_t::memory_allocator_t(
+        VkDevice device,
+        VkPhysicalDevice physical_device,
+        VkDeviceSize block_size
+    )
+    : _device{device}
+    , _block_size{std::max(floor_power_of_two(block_size), min_allocation_size)}
+    {
+        vkGetPhysicalDeviceMemoryProperties(physical_device, &_memory_properties);
+    }
+
+    memory_allocator_t::~memory_allocator_t()
+    {
+        for (auto& [key, pool] : _pools)
+        {
+            for (auto& block : pool.blocks)
+            {
+                if (block->mapped)
+                    vkUnmapMemory(_device, block->memory);
+                vkFreeMemory(_device, block->memory, nullptr);
+            }
+        }
+    }
+
+    VkMemoryPropertyFlags memory_allocator_t::property_flags(uint32_t type_index) const
+    {
+        return _memory_properties.memoryTypes[type_index].propertyFlags;
+    }
+
+    VkDeviceSize memory_allocator_t::block_size(uint32_t type_index) const
+    {
+        // small heaps (e.g. host visible device local windows) must not be
+        // swallowed by a single block
+        auto heap_index = _memory_properties.memoryTypes[type_index].heapIndex;
+        auto heap_size = _memory_properties.memoryHeaps[heap_index].size;
+        return std::max(
+            std::min(_block_size, floor_power_of_two(heap_size / 8)),
+            min_allocation_size
+        );
+    }
+
+    memory_allocator_t::block_t* memory_allocator_t::make_block(
+        pool_key_t key,
+        VkDeviceSize size,
+        bool dedicated
+    )
+    {
+        auto block = std::make_unique<block_t>();
+        block->key = key;
+        block->size = size;
+        block->mapped = nullptr;
+        block->dedicated = dedicated;
+        block->used = 0;
+        VkMemoryAllocateInfo info{
+            VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO,
+            0,
+            size,
+            key.first
+        };
+        vk_require(
+            vkAllocateMemory(_device, &info, nullptr, &block->memory),
+            "allocating device memory block"
+        );
+        if (property_flags(key.first) & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT)
+        {
+            auto result = vkMapMemory(
+                _device,
+                block->memory,
+                0,
+                VK_WHOLE_SIZE,
+                0,
+                &block->mapped
+            );
+            if (result != VK_SUCCESS)
+            {
+                vkFreeMemory(_device, block->memory, nullptr);
+                vk_require(result, "mapping device memory block");
+            }
+        }
+        if (!dedicated)
+        {
+            auto max_order = order_for(size);
+            block->free_lists.resize(max_order + 1);
+            block->free_lists[max_order].insert(0);
+        }
+        auto& blocks = _pools[key].blocks;
+        blocks.push_back(std::move(block));
+        return blocks.back().get();
+    }
+
+    void memory_allocator_t::destroy_block(block_t* block)
+    {
+        if (block->mapped)
+            vkUnmapMemory(_device, block->memory);
+        vkFreeMemory(_device, block->memory, nullptr);
+        auto& blocks = _pools[block->key].blocks;
+        blocks.erase(
+            std::find_if(
+                blocks.begin(),
+                blocks.end(),
+                [&](auto& candidate){ return candidate.get() == block; }
+            )
+        );
+    }
+
+    memory_allocator_t::allocation_t memory_allocator_t::allocate(
+        const VkMemoryRequirements& requirements,
+        uint32_t type_index,
+        bool linear
+    )
+    {
+        std::unique_lock<std::mutex> lock{_mutex};
+        pool_key_t key{type_index, linear};
+        auto size = block_size(type_index);
+        // buddies are aligned to their own size, so alignment is covered by
+        // rounding the request up to it
+        auto order = order_for(std::max(requirements.size, requirements.alignment));
+        allocation_t result;
+        result.type_index = type_index;
+        if ((min_allocation_size << order) > size / 2)
+        {
+            auto block = make_block(key, requirements.size, true);
+            block->used = requirements.size;
+            result.memory = block->memory;
+            result.offset = 0;
+            result.size = requirements.size;
+            result.mapped = block->mapped;
+            result._block = block;
+            ++_allocation_count;
+            return result;
+        }
+        block_t* block = nullptr;
+        uint32_t found = 0;
+        for (auto& candidate : _pools[key].blocks)
+        {
+            if (candidate->dedicated)
+                continue;
+            for (found = order; found < candidate->free_lists.size(); ++found)
+            {
+                if (!candidate->free_lists[found].empty())
+                    break;
+            }
+            if (found < candidate->free_lists.size())
+            {
+                block = candidate.get();
+                break;
+            }
+        }
+        if (!block)
+        {
+            block = make_block(key, size, false);
+            found = block->free_lists.size() - 1;
+        }
+        auto free_list = block->free_lists[found].begin();
+        auto offset = *free_list;
+        block->free_lists[found].erase(free_list);
+        // split down to the requested order, keeping the upper halves free
+        while (found > order)
+        {
+            --found;
+            block->free_lists[found].insert(offset + (min_allocation_size << found));
+        }
+        block->used += min_allocation_size << order;
+        result.memory = block->memory;
+        result.offset = offset;
+        result.size = min_allocation_size << order;
+        result.mapped = block->mapped ? static_cast<char*>(block->mapped) + offset : nullptr;
+        result._block = block;
+        result._order = order;
+        ++_allocation_count;
+        return result;
+    }
+
+    void memory_allocator_t::free(const allocation_t& allocation)
+    {
+        std::unique_lock<std::mutex> lock{_mutex};
+        auto block = allocation._block;
+        if (!block)
+            return;
+        --_allocation_count;
+        if (block->dedicated)
+        {
+            destroy_block(block);
+            return;
+        }
+        auto order = allocation._order;
+        auto offset = allocation.offset;
+        block->used -= min_allocation_size << order;
+        // merge with free buddies as far up as possible
+        while (order + 1 < block->free_lists.size())
+        {
+            auto buddy = offset ^ (min_allocation_size << order);
+            auto search = block->free_lists[order].find(buddy);
+            if (search == block->free_lists[order].end())
+                break;
+            block->free_lists[order].erase(search);
+            offset = std::min(offset, buddy);
+            ++order;
+        }
+        block->free_lists[order].insert(offset);
+        // keep one empty block around per pool to avoid thrashing
+        if (block->used == 0)
+        {
+            auto& blocks = _pools[block->key].blocks;
+            auto empty_blocks = std::count_if(
+                blocks.begin(),
+                blocks.end(),
+                [](auto& candidate){
+                    return !candidate->dedicated && candidate->used == 0;
+                }
+            );
+            if (empty_blocks > 1)
+                destroy_block(block);
+        }
+    }
+
+    memory_allocator_t::stats_t memory_allocator_t::stats() const
+    {
+        std::unique_lock<std::mutex> lock{_mutex};
+        stats_t result{0, _allocation_count, 0, 0};
+        for (auto& [key, pool] : _pools)
+        {
+            for (auto& block : pool.blocks)
+            {
+                ++result.block_count;
+                result.reserved_bytes += block->size;
+                result.used_bytes += block->used;
+            }
+        }
+        return result;
+    }
+}
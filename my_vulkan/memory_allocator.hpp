@@ -0,0 +1,91 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <utility>
+#include <vector>
+
+namespace my_vulkan
+{
+    // hands out regions of a few large VkDeviceMemory blocks per memory type
+    // instead of one vkAllocateMemory per resource. every block is managed
+    // by a buddy allocator, requests too large for a block get a dedicated
+    // allocation. host visible blocks are mapped once for their lifetime.
+    struct memory_allocator_t
+    {
+        struct block_t;
+        struct allocation_t
+        {
+            VkDeviceMemory memory{0};
+            VkDeviceSize offset{0};
+            VkDeviceSize size{0};
+            void* mapped{nullptr};
+            uint32_t type_index{0};
+        private:
+            friend struct memory_allocator_t;
+            block_t* _block{nullptr};
+            uint32_t _order{0};
+        };
+        struct stats_t
+        {
+            size_t block_count;
+            size_t allocation_count;
+            VkDeviceSize reserved_bytes;
+            VkDeviceSize used_bytes;
+        };
+        static constexpr VkDeviceSize default_block_size = VkDeviceSize{64} << 20;
+        static constexpr VkDeviceSize min_allocation_size = 256;
+        memory_allocator_t(
+            VkDevice device,
+            VkPhysicalDevice physical_device,
+            VkDeviceSize block_size = default_block_size
+        );
+        memory_allocator_t(const memory_allocator_t&) = delete;
+        memory_allocator_t& operator=(const memory_allocator_t&) = delete;
+        ~memory_allocator_t();
+        // linear: buffers and linear images, kept apart from optimal images
+        // so neighbours never violate bufferImageGranularity
+        allocation_t allocate(
+            const VkMemoryRequirements& requirements,
+            uint32_t type_index,
+            bool linear = true
+        );
+        void free(const allocation_t& allocation);
+        stats_t stats() const;
+        VkMemoryPropertyFlags property_flags(uint32_t type_index) const;
+    private:
+        using pool_key_t = std::pair<uint32_t, bool>;
+        struct pool_t
+        {
+            std::vector<std::unique_ptr<block_t>> blocks;
+        };
+        block_t* make_block(
+            pool_key_t key,
+            VkDeviceSize size,
+            bool dedicated
+        );
+        void destroy_block(block_t* block);
+        VkDeviceSize block_size(uint32_t type_index) const;
+        VkDevice _device;
+        VkPhysicalDeviceMemoryProperties _memory_properties;
+        VkDeviceSize _block_size;
+        std::map<pool_key_t, pool_t> _pools;
+        size_t _allocation_count{0};
+        mutable std::mutex _mutex;
+    };
+
+    struct memory_allocator_t::block_t
+    {
+        pool_key_t key;
+        VkDeviceMemory memory;
+        VkDeviceSize size;
+        void* mapped;
+        bool dedicated;
+        VkDeviceSize used;
+        // free offsets by order, order n spans min_allocation_size << n
+        std::vector<std::set<VkDeviceSize>> free_lists;
+    };
+}
@@ -1,22 +1,37 @@
 #pragma once
 
+#include "array_view.hpp"
 #include "buffer.hpp"
 #include "command_buffer.hpp"
 #include "command_pool.hpp"
+#include "command_pool_set.hpp"
+#include "compute_pipeline.hpp"
+#include "descriptor_allocator.hpp"
 #include "descriptor_pool.hpp"
 #include "descriptor_set.hpp"
 #include "descriptor_set_layout.hpp"
+#include "descriptor_update_template.hpp"
 #include "device.hpp"
 #include "fence.hpp"
 #include "framebuffer.hpp"
+#include "gpu_profiler.hpp"
 #include "graphics_pipeline.hpp"
 #include "image.hpp"
 #include "instance.hpp"
+#include "memory_allocator.hpp"
+#include "pipeline_cache.hpp"
+#include "pipeline_registry.hpp"
 #include "queue.hpp"
 #include "render_pass.hpp"
+#include "resource_tracker.hpp"
 #include "semaphore.hpp"
 #include "shader_module.hpp"
+#include "staging_ring.hpp"
 #include "swap_chain.hpp"
 #include "texture_sampler.hpp"
+#include "timeline_semaphore.hpp"
+#include "transfer_engine.hpp"
+#include "uniform_ring.hpp"
+#include "upload_batch.hpp"
 #include "utils.hpp"
 #include "physical_device_utils.hpp"
@@ -0,0 +1,162 @@
+#include "pipeline_cache.hpp"
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+
+#include "device.hpp"
+#include "utils.hpp"
+
+namespace my_vulkan
+{
+    static const char cache_magic[4] = {'M', 'V', 'P', 'C'};
+
+    pipeline_cache_t::pipeline_cache_t(
+        device_t& device,
+        std::optional<std::string> path
+    )
+    : _device{device.get()}
+    , _id_properties{device.physcial_device_id_properties()}
+    , _path{std::move(path)}
+    {
+        vkGetPhysicalDeviceProperties(device.physical_device(), &_properties);
+        std::vector<char> data;
+        if (_path)
+            data = read(*_path);
+        VkPipelineCacheCreateInfo info = {};
+        info.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+        info.initialDataSize = data.size();
+        info.pInitialData = data.empty() ? nullptr : data.data();
+        auto result = vkCreatePipelineCache(_device, &info, nullptr, &_cache);
+        if (result != VK_SUCCESS && !data.empty())
+        {
+            // the driver may still refuse data that passed our checks
+            std::cerr << "WARNING: pipeline cache " << *_path << " rejected\n";
+            info.initialDataSize = 0;
+            info.pInitialData = nullptr;
+            result = vkCreatePipelineCache(_device, &info, nullptr, &_cache);
+            data.clear();
+        }
+        vk_require(result, "creating pipeline cache");
+        _loaded = !data.empty();
+    }
+
+    pipeline_cache_t::~pipeline_cache_t()
+    {
+        if (!_cache)
+            return;
+        if (_path)
+        {
+            try
+            {
+                save();
+            }
+            catch (const std::exception& e)
+            {
+                std::cerr << "WARNING: saving pipeline cache failed: " << e.what() << "\n";
+            }
+        }
+        vkDestroyPipelineCache(_device, _cache, nullptr);
+    }
+
+    VkPipelineCache pipeline_cache_t::get()
+    {
+        return _cache;
+    }
+
+    bool pipeline_cache_t::loaded() const
+    {
+        return _loaded;
+    }
+
+    pipeline_cache_t::header_t pipeline_cache_t::make_header() const
+    {
+        header_t header = {};
+        std::memcpy(header.magic, cache_magic, sizeof(cache_magic));
+        header.header_size = sizeof(header_t);
+        header.vendor_id = _properties.vendorID;
+        header.device_id = _properties.deviceID;
+        header.driver_version = _properties.driverVersion;
+        if (_id_properties)
+            std::memcpy(
+                header.device_uuid,
+                _id_properties->deviceUUID,
+                VK_UUID_SIZE
+            );
+        std::memcpy(
+            header.pipeline_cache_uuid,
+            _properties.pipelineCacheUUID,
+            VK_UUID_SIZE
+        );
+        return header;
+    }
+
+    std::vector<char> pipeline_cache_t::read(const std::string& path) const
+    {
+        std::ifstream file{path, std::ios::binary};
+        if (!file)
+            return {};
+        std::vector<char> contents{
+            std::istreambuf_iterator<char>{file},
+            std::istreambuf_iterator<char>{}
+        };
+        header_t header;
+        if (contents.size() < sizeof(header))
+            return {};
+        std::memcpy(&header, contents.data(), sizeof(header));
+        auto expected = make_header();
+        // everything but the size has to match this device and driver
+        expected.data_size = header.data_size;
+        if (
+            std::memcmp(&header, &expected, sizeof(header)) != 0 ||
+            header.data_size != contents.size() - sizeof(header)
+        )
+        {
+            std::cerr << "WARNING: ignoring pipeline cache " << path
+                << " from another device or driver\n";
+            return {};
+        }
+        contents.erase(contents.begin(), contents.begin() + sizeof(header));
+        return contents;
+    }
+
+    void pipeline_cache_t::save()
+    {
+        if (!_path)
+            throw std::runtime_error{"pipeline cache has no path to save to"};
+        save(*_path);
+    }
+
+    void pipeline_cache_t::save(const std::string& path)
+    {
+        std::unique_lock<std::mutex> lock{_save_mutex};
+        size_t size = 0;
+        vk_require(
+            vkGetPipelineCacheData(_device, _cache, &size, nullptr),
+            "getting pipeline cache size"
+        );
+        std::vector<char> data(size);
+        vk_require(
+            vkGetPipelineCacheData(_device, _cache, &size, data.data()),
+            "getting pipeline cache data"
+        );
+        data.resize(size);
+        auto header = make_header();
+        header.data_size = size;
+        auto temporary = path + ".tmp";
+        {
+            std::ofstream file{temporary, std::ios::binary | std::ios::trunc};
+            file.write((const char*)&header, sizeof(header));
+            file.write(data.data(), std::streamsize(data.size()));
+            if (!file.flush())
+                throw std::runtime_error{"writing " + temporary};
+        }
+        if (std::rename(temporary.c_str(), path.c_str()) != 0)
+        {
+            std::remove(temporary.c_str());
+            throw std::runtime_error{"replacing " + path};
+        }
+    }
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace my_vulkan
+{
+    struct device_t;
+
+    // VkPipelineCache that survives the process. the file carries the
+    // device uuid and driver version it was written with, a file from
+    // another device or driver is ignored and the cache starts empty.
+    struct pipeline_cache_t
+    {
+        explicit pipeline_cache_t(
+            device_t& device,
+            std::optional<std::string> path = std::nullopt
+        );
+        pipeline_cache_t(const pipeline_cache_t&) = delete;
+        pipeline_cache_t& operator=(const pipeline_cache_t&) = delete;
+        // saves if there is a path
+        ~pipeline_cache_t();
+        VkPipelineCache get();
+        // true if the data from path was accepted
+        bool loaded() const;
+        // writes a temporary file and renames it over path, so a crash
+        // never leaves a torn cache behind
+        void save();
+        void save(const std::string& path);
+    private:
+        struct header_t
+        {
+            char magic[4];
+            uint32_t header_size;
+            uint32_t vendor_id;
+            uint32_t device_id;
+            uint32_t driver_version;
+            uint8_t device_uuid[VK_UUID_SIZE];
+            uint8_t pipeline_cache_uuid[VK_UUID_SIZE];
+            uint32_t reserved;
+            uint64_t data_size;
+        };
+        header_t make_header() const;
+        std::vector<char> read(const std::string& path) const;
+        VkDevice _device;
+        VkPhysicalDeviceProperties _properties;
+        std::optional<VkPhysicalDeviceIDProperties> _id_properties;
+        std::optional<std::string> _path;
+        VkPipelineCache _cache{VK_NULL_HANDLE};
+        bool _loaded{false};
+        std::mutex _save_mutex;
+    };
+}
@@ -0,0 +1,362 @@
+#include "pipeline_registry.hpp"
+
+#include <algorithm>
+#include <type_traits>
+
+#include "device.hpp"
+#include "pipeline_cache.hpp"
+
+namespace my_vulkan
+{
+    namespace
+    {
+        // fnv-1a over the fields one by one, struct padding never gets in
+        struct hasher_t
+        {
+            uint64_t value{14695981039346656037ull};
+            void add_bytes(const void* data, size_t size)
+            {
+                auto bytes = (const uint8_t*)data;
+                for (size_t i = 0; i < size; ++i)
+                {
+                    value ^= bytes[i];
+                    value *= 1099511628211ull;
+                }
+            }
+            template<typename T>
+            void add(const T& scalar)
+            {
+                static_assert(std::is_scalar<T>::value, "hash fields one by one");
+                add_bytes(&scalar, sizeof(scalar));
+            }
+        };
+    }
+
+    static bool same_binding(
+        const VkDescriptorSetLayoutBinding& x,
+        const VkDescriptorSetLayoutBinding& y
+    )
+    {
+        return
+            x.binding == y.binding &&
+            x.descriptorType == y.descriptorType &&
+            x.descriptorCount == y.descriptorCount &&
+            x.stageFlags == y.stageFlags &&
+            !x.pImmutableSamplers == !y.pImmutableSamplers;
+    }
+
+    // all immutable samplers of the layout one binding after the other
+    static std::vector<VkSampler> immutable_samplers(
+        const std::vector<VkDescriptorSetLayoutBinding>& uniform_layout
+    )
+    {
+        std::vector<VkSampler> samplers;
+        for (auto& binding : uniform_layout)
+            if (binding.pImmutableSamplers)
+                samplers.insert(
+                    samplers.end(),
+                    binding.pImmutableSamplers,
+                    binding.pImmutableSamplers + binding.descriptorCount
+                );
+        return samplers;
+    }
+
+    static bool same_attribute(
+        const VkVertexInputAttributeDescription& x,
+        const VkVertexInputAttributeDescription& y
+    )
+    {
+        return
+            x.location == y.location &&
+            x.binding == y.binding &&
+            x.format == y.format &&
+            x.offset == y.offset;
+    }
+
+    static bool same_vertex_binding(
+        const VkVertexInputBindingDescription& x,
+        const VkVertexInputBindingDescription& y
+    )
+    {
+        return
+            x.binding == y.binding &&
+            x.stride == y.stride &&
+            x.inputRate == y.inputRate;
+    }
+
+    static bool same_push_constant_range(
+        const VkPushConstantRange& x,
+        const VkPushConstantRange& y
+    )
+    {
+        return
+            x.stageFlags == y.stageFlags &&
+            x.offset == y.offset &&
+            x.size == y.size;
+    }
+
+    static bool same_description(
+        const pipeline_registry_t::description_t& x,
+        const pipeline_registry_t::description_t& y
+    )
+    {
+        bool same_extent =
+            x.dynamic_viewport ||
+            (
+                x.extent.width == y.extent.width &&
+                x.extent.height == y.extent.height
+            );
+        return
+            same_extent &&
+            x.render_pass == y.render_pass &&
+            x.subpass == y.subpass &&
+            std::equal(
+                x.uniform_layout.begin(), x.uniform_layout.end(),
+                y.uniform_layout.begin(), y.uniform_layout.end(),
+                same_binding
+            ) &&
+            same_vertex_binding(x.vertex_layout.binding, y.vertex_layout.binding) &&
+            std::equal(
+                x.vertex_layout.attributes.begin(), x.vertex_layout.attributes.end(),
+                y.vertex_layout.attributes.begin(), y.vertex_layout.attributes.end(),
+                same_attribute
+            ) &&
+            std::equal(
+                x.vertex_layout.extra_bindings.begin(), x.vertex_layout.extra_bindings.end(),
+                y.vertex_layout.extra_bindings.begin(), y.vertex_layout.extra_bindings.end(),
+                same_vertex_binding
+            ) &&
+            x.settings.depth_test == y.settings.depth_test &&
+            x.settings.blending == y.settings.blending &&
+            x.settings.topology == y.settings.topology &&
+            x.dynamic_viewport == y.dynamic_viewport &&
+            std::equal(
+                x.push_constant_ranges.begin(), x.push_constant_ranges.end(),
+                y.push_constant_ranges.begin(), y.push_constant_ranges.end(),
+                same_push_constant_range
+            );
+    }
+
+    static uint64_t hash_key(
+        const pipeline_registry_t::description_t& description,
+        const std::vector<VkSampler>& immutable_samplers,
+        const std::vector<uint8_t>& vertex_code,
+        const std::vector<uint8_t>& fragment_code
+    )
+    {
+        hasher_t hasher;
+        hasher.add(description.dynamic_viewport);
+        if (!description.dynamic_viewport)
+        {
+            hasher.add(description.extent.width);
+            hasher.add(description.extent.height);
+        }
+        hasher.add(description.render_pass);
+        hasher.add(description.subpass);
+        for (auto& binding : description.uniform_layout)
+        {
+            hasher.add(binding.binding);
+            hasher.add(binding.descriptorType);
+            hasher.add(binding.descriptorCount);
+            hasher.add(binding.stageFlags);
+        }
+        for (auto sampler : immutable_samplers)
+            hasher.add(sampler);
+        auto& vertex_binding = description.vertex_layout.binding;
+        hasher.add(vertex_binding.binding);
+        hasher.add(vertex_binding.stride);
+        hasher.add(vertex_binding.inputRate);
+        for (auto& binding : description.vertex_layout.extra_bindings)
+        {
+            hasher.add(binding.binding);
+            hasher.add(binding.stride);
+            hasher.add(binding.inputRate);
+        }
+        for (auto& attribute : description.vertex_layout.attributes)
+        {
+            hasher.add(attribute.location);
+            hasher.add(attribute.binding);
+            hasher.add(attribute.format);
+            hasher.add(attribute.offset);
+        }
+        hasher.add(description.settings.depth_test);
+        hasher.add(description.settings.blending);
+        hasher.add(description.settings.topology);
+        for (auto& range : description.push_constant_ranges)
+        {
+            hasher.add(range.stageFlags);
+            hasher.add(range.offset);
+            hasher.add(range.size);
+        }
+        hasher.add(vertex_code.size());
+        hasher.add_bytes(vertex_code.data(), vertex_code.size());
+        hasher.add(fragment_code.size());
+        hasher.add_bytes(fragment_code.data(), fragment_code.size());
+        return hasher.value;
+    }
+
+    pipeline_registry_t::pipeline_registry_t(device_t& device)
+    : _device{&device}
+    {
+    }
+
+    std::shared_ptr<graphics_pipeline_t> pipeline_registry_t::graphics_pipeline(
+        const description_t& description,
+        const std::vector<uint8_t>& vertex_shader,
+        const std::vector<uint8_t>& fragment_shader
+    )
+    {
+        return find_or_make(
+            {
+                description,
+                immutable_samplers(description.uniform_layout),
+                vertex_shader,
+                fragment_shader
+            },
+            [&](VkPipelineCache cache){
+                return std::make_shared<graphics_pipeline_t>(
+                    _device->get(),
+                    description.extent,
+                    description.render_pass,
+                    description.subpass,
+                    description.uniform_layout,
+                    description.vertex_layout,
+                    vertex_shader,
+                    fragment_shader,
+                    description.settings,
+                    description.dynamic_viewport,
+                    cache,
+                    description.push_constant_ranges
+                );
+            }
+        );
+    }
+
+    std::shared_ptr<graphics_pipeline_t> pipeline_registry_t::graphics_pipeline(
+        const description_t& description,
+        const shader_module_t& vertex_shader,
+        const shader_module_t& fragment_shader
+    )
+    {
+        return find_or_make(
+            {
+                description,
+                immutable_samplers(description.uniform_layout),
+                vertex_shader.code(),
+                fragment_shader.code()
+            },
+            [&](VkPipelineCache cache){
+                return std::make_shared<graphics_pipeline_t>(
+                    _device->get(),
+                    description.extent,
+                    description.render_pass,
+                    description.subpass,
+                    description.uniform_layout,
+                    description.vertex_layout,
+                    vertex_shader,
+                    fragment_shader,
+                    description.settings,
+                    description.dynamic_viewport,
+                    cache,
+                    description.push_constant_ranges
+                );
+            }
+        );
+    }
+
+    template<typename make_t>
+    std::shared_ptr<graphics_pipeline_t> pipeline_registry_t::find_or_make(
+        key_t key,
+        const make_t& make
+    )
+    {
+        auto hash = hash_key(
+            key.description,
+            key.immutable_samplers,
+            key.vertex_code,
+            key.fragment_code
+        );
+        auto same_key = [&](const key_t& other){
+            return
+                same_description(other.description, key.description) &&
+                other.immutable_samplers == key.immutable_samplers &&
+                other.vertex_code == key.vertex_code &&
+                other.fragment_code == key.fragment_code;
+        };
+        {
+            std::unique_lock<std::mutex> lock{_mutex};
+            auto& bucket = _entries[hash];
+            bucket.erase(
+                std::remove_if(
+                    bucket.begin(),
+                    bucket.end(),
+                    [](auto& entry){return entry.pipeline.expired();}
+                ),
+                bucket.end()
+            );
+            for (auto& entry : bucket)
+                if (same_key(entry.key))
+                    if (auto pipeline = entry.pipeline.lock())
+                    {
+                        ++_hits;
+                        return pipeline;
+                    }
+            ++_misses;
+        }
+        // compiled without the lock so compiles on several threads overlap
+        auto pipeline = make(_device->pipeline_cache().get());
+        std::unique_lock<std::mutex> lock{_mutex};
+        auto& bucket = _entries[hash];
+        // somebody else may have compiled the same state in the meantime
+        for (auto& entry : bucket)
+            if (same_key(entry.key))
+                if (auto other = entry.pipeline.lock())
+                    return other;
+        bucket.push_back({std::move(key), pipeline});
+        return pipeline;
+    }
+
+    template<typename predicate_t>
+    void pipeline_registry_t::forget_if(const predicate_t& predicate)
+    {
+        std::unique_lock<std::mutex> lock{_mutex};
+        for (auto& bucket : _entries)
+            bucket.second.erase(
+                std::remove_if(
+                    bucket.second.begin(),
+                    bucket.second.end(),
+                    [&](auto& entry){return predicate(entry.key);}
+                ),
+                bucket.second.end()
+            );
+    }
+
+    void pipeline_registry_t::forget(VkRenderPass render_pass)
+    {
+        forget_if([&](const key_t& key){
+            return key.description.render_pass == render_pass;
+        });
+    }
+
+    void pipeline_registry_t::forget(VkSampler sampler)
+    {
+        forget_if([&](const key_t& key){
+            return std::find(
+                key.immutable_samplers.begin(),
+                key.immutable_samplers.end(),
+                sampler
+            ) != key.immutable_samplers.end();
+        });
+    }
+
+    pipeline_registry_t::statistics_t pipeline_registry_t::statistics() const
+    {
+        std::unique_lock<std::mutex> lock{_mutex};
+        size_t live = 0;
+        for (auto& bucket : _entries)
+            for (auto& entry : bucket.second)
+                if (!entry.pipeline.expired())
+                    ++live;
+        return {_hits, _misses, live};
+    }
+}
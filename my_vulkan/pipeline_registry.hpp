@@ -0,0 +1,89 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#include "graphics_pipeline.hpp"
+
+namespace my_vulkan
+{
+    struct device_t;
+
+    // hands out one shared graphics pipeline per distinct pipeline state,
+    // a pipeline lives as long as somebody holds it
+    struct pipeline_registry_t
+    {
+        // everything but the shaders
+        struct description_t
+        {
+            // ignored with a dynamic viewport
+            VkExtent2D extent;
+            // render passes and immutable samplers are keyed by handle,
+            // see forget
+            VkRenderPass render_pass;
+            uint32_t subpass;
+            std::vector<VkDescriptorSetLayoutBinding> uniform_layout;
+            vertex_layout_t vertex_layout;
+            render_settings_t settings;
+            bool dynamic_viewport;
+            std::vector<VkPushConstantRange> push_constant_ranges{};
+        };
+        struct statistics_t
+        {
+            size_t hits;
+            size_t misses;
+            size_t live_pipelines;
+        };
+        explicit pipeline_registry_t(device_t& device);
+        pipeline_registry_t(const pipeline_registry_t&) = delete;
+        pipeline_registry_t& operator=(const pipeline_registry_t&) = delete;
+        // identical shader code hits the same pipeline
+        std::shared_ptr<graphics_pipeline_t> graphics_pipeline(
+            const description_t& description,
+            const std::vector<uint8_t>& vertex_shader,
+            const std::vector<uint8_t>& fragment_shader
+        );
+        // shaders are identified by the code of the modules, like above
+        std::shared_ptr<graphics_pipeline_t> graphics_pipeline(
+            const description_t& description,
+            const shader_module_t& vertex_shader,
+            const shader_module_t& fragment_shader
+        );
+        statistics_t statistics() const;
+        // drops the pipelines built for a render pass or with an immutable
+        // sampler, so a new object that gets the same handle doesn't hit
+        // them. call before destroying the object, render_pass_t and
+        // texture_sampler_t do when created with a device_t
+        void forget(VkRenderPass render_pass);
+        void forget(VkSampler sampler);
+    private:
+        struct key_t
+        {
+            description_t description;
+            // pImmutableSamplers of the description may dangle
+            std::vector<VkSampler> immutable_samplers;
+            std::vector<uint8_t> vertex_code;
+            std::vector<uint8_t> fragment_code;
+        };
+        struct entry_t
+        {
+            key_t key;
+            std::weak_ptr<graphics_pipeline_t> pipeline;
+        };
+        template<typename predicate_t>
+        void forget_if(const predicate_t& predicate);
+        template<typename make_t>
+        std::shared_ptr<graphics_pipeline_t> find_or_make(
+            key_t key,
+            const make_t& make
+        );
+        device_t* _device;
+        mutable std::mutex _mutex;
+        std::unordered_map<uint64_t, std::vector<entry_t>> _entries;
+        size_t _hits{0};
+        size_t _misses{0};
+    };
+}
@@ -20,16 +20,52 @@ namespace my_vulkan
         std::vector<VkSemaphore> signal_semaphores,
         VkFence fence
     )
+    {
+        submit(
+            buffer,
+            std::move(wait_semaphore_infos),
+            std::move(signal_semaphores),
+            {},
+            fence
+        );
+    }
+
+    void queue_reference_t::submit(
+        VkCommandBuffer buffer,
+        std::vector<wait_semaphore_info_t> wait_semaphore_infos,
+        std::vector<VkSemaphore> signal_semaphores,
+        std::vector<timeline_signal_info_t> timeline_signals,
+        VkFence fence
+    )
     {
         std::vector<VkSemaphore> wait_semaphores;
         std::vector<VkPipelineStageFlags> wait_semaphore_stages;
+        std::vector<uint64_t> wait_values;
+        bool has_values = !timeline_signals.empty();
         for (auto&& info : wait_semaphore_infos)
         {
             wait_semaphores.push_back(info.semaphore);
             wait_semaphore_stages.push_back(info.stage);
+            wait_values.push_back(info.value);
+            has_values = has_values || info.timeline || info.value;
+        }
+        // binary semaphores ignore their entry in the value arrays
+        std::vector<uint64_t> signal_values(signal_semaphores.size(), 0);
+        for (auto&& info : timeline_signals)
+        {
+            signal_semaphores.push_back(info.semaphore);
+            signal_values.push_back(info.value);
         }
+        VkTimelineSemaphoreSubmitInfoKHR timelineInfo = {};
+        timelineInfo.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO_KHR;
+        timelineInfo.waitSemaphoreValueCount = uint32_t(wait_values.size());
+        timelineInfo.pWaitSemaphoreValues = wait_values.data();
+        timelineInfo.signalSemaphoreValueCount = uint32_t(signal_values.size());
+        timelineInfo.pSignalSemaphoreValues = signal_values.data();
         VkSubmitInfo submitInfo = {};
         submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+        if (has_values)
+            submitInfo.pNext = &timelineInfo;
         submitInfo.commandBufferCount = 1;
         submitInfo.pCommandBuffers = &buffer;
         submitInfo.signalSemaphoreCount = uint32_t(signal_semaphores.size());
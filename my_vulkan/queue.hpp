@@ -19,6 +19,16 @@ namespace my_vulkan
         {
             VkSemaphore semaphore;
             VkPipelineStageFlags stage;
+            // only read for timeline semaphores
+            uint64_t value{0};
+            // set for timeline semaphores, a wait on value 0 still needs
+            // the values chained to the submission
+            bool timeline{false};
+        };
+        struct timeline_signal_info_t
+        {
+            VkSemaphore semaphore;
+            uint64_t value;
         };
         void submit(VkCommandBuffer buffer, VkFence fence = 0);
         void submit(
@@ -27,6 +37,13 @@ namespace my_vulkan
             std::vector<VkSemaphore> signal_semaphores,
             VkFence fence = 0
         );
+        void submit(
+            VkCommandBuffer buffer,
+            std::vector<wait_semaphore_info_t> wait_semaphores,
+            std::vector<VkSemaphore> signal_semaphores,
+            std::vector<timeline_signal_info_t> timeline_signals,
+            VkFence fence = 0
+        );
         void submit(std::vector<VkSubmitInfo> submits, VkFence fence = 0);
         struct swapchain_target_t
         {
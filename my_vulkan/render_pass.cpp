@@ -1,4 +1,6 @@
 #include "render_pass.hpp"
+#include "device.hpp"
+#include "pipeline_registry.hpp"
 #include "utils.hpp"
 #include <memory>
 
@@ -82,6 +84,33 @@ namespace my_vulkan
         );
     }
 
+    render_pass_t::render_pass_t(
+        device_t& device,
+        VkRenderPassCreateInfo info
+    )
+    : render_pass_t{device.get(), info}
+    {
+        _owner = &device;
+    }
+
+    render_pass_t::render_pass_t(
+        device_t& device,
+        VkFormat color_format,
+        VkFormat depth_format,
+        VkImageLayout color_attachment_final_layout,
+        VkAttachmentLoadOp attachment_loadop
+    )
+    : render_pass_t{
+        device.get(),
+        color_format,
+        depth_format,
+        color_attachment_final_layout,
+        attachment_loadop
+    }
+    {
+        _owner = &device;
+    }
+
     render_pass_t::render_pass_t(render_pass_t&& other) noexcept
     : _device{0}
     {
@@ -93,6 +122,7 @@ namespace my_vulkan
         cleanup();
         _render_pass = other._render_pass;
         std::swap(_device, other._device);
+        std::swap(_owner, other._owner);
         return *this;
     }
 
@@ -110,6 +140,8 @@ namespace my_vulkan
     {
         if (_device)
         {
+            if (_owner)
+                _owner->pipeline_registry().forget(_render_pass);
             vkDestroyRenderPass(_device, _render_pass, 0);
             _device = 0;
         }
@@ -4,6 +4,8 @@
 
 namespace my_vulkan
 {
+    struct device_t;
+
     struct render_pass_t
     {
         render_pass_t(
@@ -17,6 +19,19 @@ namespace my_vulkan
             VkImageLayout color_attachment_final_layout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR,
             VkAttachmentLoadOp attachment_loadop = VK_ATTACHMENT_LOAD_OP_DONT_CARE
         );
+        // these also drop the registry's pipelines for the pass on
+        // destruction
+        render_pass_t(
+            device_t& device,
+            VkRenderPassCreateInfo info
+        );
+        render_pass_t(
+            device_t& device,
+            VkFormat color_format,
+            VkFormat depth_format = VK_FORMAT_UNDEFINED,
+            VkImageLayout color_attachment_final_layout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR,
+            VkAttachmentLoadOp attachment_loadop = VK_ATTACHMENT_LOAD_OP_DONT_CARE
+        );
         render_pass_t(render_pass_t&& other) noexcept;
         render_pass_t(const render_pass_t&) = delete;
         render_pass_t& operator=(render_pass_t&& other) noexcept;
@@ -28,5 +43,6 @@ namespace my_vulkan
         void cleanup();
         VkDevice _device;
         VkRenderPass _render_pass;
+        device_t* _owner{nullptr};
     };
 };
@@ -0,0 +1,414 @@
+#include "resource_tracker.hpp"
+
+#include "image.hpp"
+#include "utils.hpp"
+
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+#include <utility>
+
+namespace my_vulkan
+{
+    static const VkAccessFlags write_access_mask =
+        VK_ACCESS_SHADER_WRITE_BIT |
+        VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT |
+        VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT |
+        VK_ACCESS_TRANSFER_WRITE_BIT |
+        VK_ACCESS_HOST_WRITE_BIT |
+        VK_ACCESS_MEMORY_WRITE_BIT;
+
+    static bool writes_memory(const resource_usage_t& usage)
+    {
+        return usage.access & write_access_mask;
+    }
+
+    resource_usage_t image_usage(VkImageLayout layout)
+    {
+        switch (layout)
+        {
+            case VK_IMAGE_LAYOUT_UNDEFINED:
+                return {VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, 0, layout};
+            case VK_IMAGE_LAYOUT_PREINITIALIZED:
+                return {VK_PIPELINE_STAGE_HOST_BIT, VK_ACCESS_HOST_WRITE_BIT, layout};
+            case VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL:
+                return {
+                    VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+                    VK_ACCESS_COLOR_ATTACHMENT_READ_BIT |
+                    VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT,
+                    layout
+                };
+            case VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL:
+                return {
+                    VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT |
+                    VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT,
+                    VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT |
+                    VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT,
+                    layout
+                };
+            case VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL:
+                return {
+                    VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT |
+                    VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT |
+                    VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+                    VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT |
+                    VK_ACCESS_SHADER_READ_BIT,
+                    layout
+                };
+            case VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL:
+                return {
+                    VK_PIPELINE_STAGE_VERTEX_SHADER_BIT |
+                    VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT |
+                    VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                    VK_ACCESS_SHADER_READ_BIT,
+                    layout
+                };
+            case VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL:
+                return {VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_READ_BIT, layout};
+            case VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL:
+                return {VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT, layout};
+            case VK_IMAGE_LAYOUT_PRESENT_SRC_KHR:
+                // presentation is ordered by semaphores
+                return {VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0, layout};
+            default:
+                return {
+                    VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
+                    VK_ACCESS_MEMORY_READ_BIT | VK_ACCESS_MEMORY_WRITE_BIT,
+                    layout
+                };
+        }
+    }
+
+    VkImageAspectFlags image_aspects(VkFormat format)
+    {
+        switch (format)
+        {
+            case VK_FORMAT_D16_UNORM:
+            case VK_FORMAT_X8_D24_UNORM_PACK32:
+            case VK_FORMAT_D32_SFLOAT:
+                return VK_IMAGE_ASPECT_DEPTH_BIT;
+            case VK_FORMAT_D16_UNORM_S8_UINT:
+            case VK_FORMAT_D24_UNORM_S8_UINT:
+            case VK_FORMAT_D32_SFLOAT_S8_UINT:
+                return VK_IMAGE_ASPECT_DEPTH_BIT | VK_IMAGE_ASPECT_STENCIL_BIT;
+            case VK_FORMAT_S8_UINT:
+                return VK_IMAGE_ASPECT_STENCIL_BIT;
+            default:
+                return VK_IMAGE_ASPECT_COLOR_BIT;
+        }
+    }
+
+    resource_tracker_t::access_state_t resource_tracker_t::assumed_state(
+        const resource_usage_t& usage
+    )
+    {
+        access_state_t result;
+        result.layout = usage.layout;
+        if (writes_memory(usage))
+        {
+            result.write_stages = usage.stages;
+            result.write_access = usage.access & write_access_mask;
+        }
+        else
+        {
+            result.read_stages = usage.stages;
+        }
+        return result;
+    }
+
+    static VkDeviceSize range_end(VkDeviceSize offset, VkDeviceSize size)
+    {
+        return size == VK_WHOLE_SIZE ?
+            std::numeric_limits<VkDeviceSize>::max() :
+            offset + size;
+    }
+
+    // moves the ranges overlapping [begin, end) to the back
+    template<typename ranges_t>
+    static auto partition_overlapping(
+        ranges_t& ranges,
+        VkDeviceSize begin,
+        VkDeviceSize end
+    )
+    {
+        return std::partition(
+            ranges.begin(),
+            ranges.end(),
+            [&](auto& range){
+                return range.end <= begin || range.begin >= end;
+            }
+        );
+    }
+
+    void resource_tracker_t::assume(VkImage image, resource_usage_t usage)
+    {
+        _images[image] = assumed_state(usage);
+    }
+
+    void resource_tracker_t::assume(
+        VkBuffer buffer,
+        resource_usage_t usage,
+        VkDeviceSize offset,
+        VkDeviceSize size
+    )
+    {
+        auto& ranges = _buffers[buffer];
+        auto end = range_end(offset, size);
+        ranges.erase(partition_overlapping(ranges, offset, end), ranges.end());
+        ranges.push_back({offset, end, assumed_state(usage)});
+    }
+
+    void resource_tracker_t::use(
+        image_t& image,
+        resource_usage_t usage,
+        bool discard
+    )
+    {
+        // images created outside know their layout
+        if (!_images.count(image.get()))
+            _images[image.get()].layout = image.layout();
+        use(image.get(), image_aspects(image.format()), usage, discard);
+        image.set_layout(usage.layout);
+    }
+
+    void resource_tracker_t::use(
+        VkImage image,
+        VkImageAspectFlags aspects,
+        resource_usage_t usage,
+        bool discard
+    )
+    {
+        auto& state = _images[image];
+        auto old_layout = discard ? VK_IMAGE_LAYOUT_UNDEFINED : state.layout;
+        bool layout_change = old_layout != usage.layout;
+        if (pending(state))
+        {
+            if (layout_change)
+                throw std::runtime_error{
+                    "image changes layout twice in one barrier batch"
+                };
+            merge_pending(
+                state,
+                usage,
+                _pending.image_barriers[state.barrier].dstAccessMask
+            );
+            return;
+        }
+        auto dependency = update(state, usage, layout_change);
+        state.layout = usage.layout;
+        if (!dependency)
+            return;
+        state.batch = _batch;
+        state.barrier = _pending.image_barriers.size();
+        state.pending_write = writes_memory(usage);
+        _pending.image_barriers.push_back({
+            VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
+            nullptr,
+            dependency->src_access,
+            dependency->dst_access,
+            old_layout,
+            usage.layout,
+            VK_QUEUE_FAMILY_IGNORED,
+            VK_QUEUE_FAMILY_IGNORED,
+            image,
+            {aspects, 0, VK_REMAINING_MIP_LEVELS, 0, VK_REMAINING_ARRAY_LAYERS}
+        });
+        add_dependency(*dependency);
+    }
+
+    void resource_tracker_t::use(
+        VkBuffer buffer,
+        resource_usage_t usage,
+        VkDeviceSize offset,
+        VkDeviceSize size
+    )
+    {
+        auto& ranges = _buffers[buffer];
+        auto end = range_end(offset, size);
+        auto overlapping = partition_overlapping(ranges, offset, end);
+        // overlapping ranges are merged, the state of the merged range is
+        // the conservative union of theirs
+        buffer_range_t merged{offset, end, {}};
+        std::optional<access_state_t> pending_state;
+        for (auto i = overlapping; i != ranges.end(); ++i)
+        {
+            auto& state = i->state;
+            if (pending(state))
+            {
+                merge_pending(
+                    state,
+                    usage,
+                    _pending.buffer_barriers[state.barrier].dstAccessMask
+                );
+                pending_state = state;
+            }
+            merged.begin = std::min(merged.begin, i->begin);
+            merged.end = std::max(merged.end, i->end);
+            merged.state.write_stages |= state.write_stages;
+            merged.state.write_access |= state.write_access;
+            merged.state.read_stages |= state.read_stages;
+            bool first = i == overlapping;
+            merged.state.visible_stages = first ?
+                state.visible_stages :
+                merged.state.visible_stages & state.visible_stages;
+            merged.state.visible_access = first ?
+                state.visible_access :
+                merged.state.visible_access & state.visible_access;
+        }
+        ranges.erase(overlapping, ranges.end());
+        auto dependency = update(merged.state, usage, false);
+        if (dependency)
+        {
+            merged.state.batch = _batch;
+            merged.state.barrier = _pending.buffer_barriers.size();
+            merged.state.pending_write = writes_memory(usage);
+            _pending.buffer_barriers.push_back({
+                VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER,
+                nullptr,
+                dependency->src_access,
+                dependency->dst_access,
+                VK_QUEUE_FAMILY_IGNORED,
+                VK_QUEUE_FAMILY_IGNORED,
+                buffer,
+                merged.begin,
+                merged.end == std::numeric_limits<VkDeviceSize>::max() ?
+                    VK_WHOLE_SIZE :
+                    merged.end - merged.begin
+            });
+            add_dependency(*dependency);
+        }
+        else if (pending_state)
+        {
+            merged.state.batch = pending_state->batch;
+            merged.state.barrier = pending_state->barrier;
+            merged.state.pending_write = pending_state->pending_write;
+        }
+        ranges.push_back(merged);
+    }
+
+    bool barrier_batch_t::empty() const
+    {
+        return image_barriers.empty() && buffer_barriers.empty();
+    }
+
+    void barrier_batch_t::record(command_buffer_t::scope_t& commands) const
+    {
+        if (empty())
+            return;
+        commands.pipeline_barrier(
+            src_stages,
+            dst_stages,
+            {},
+            buffer_barriers,
+            image_barriers
+        );
+    }
+
+    void resource_tracker_t::flush(command_buffer_t::scope_t& commands)
+    {
+        take_barriers().record(commands);
+    }
+
+    barrier_batch_t resource_tracker_t::take_barriers()
+    {
+        ++_batch;
+        return std::exchange(_pending, {});
+    }
+
+    void resource_tracker_t::forget(VkImage image)
+    {
+        _images.erase(image);
+    }
+
+    void resource_tracker_t::forget(VkBuffer buffer)
+    {
+        _buffers.erase(buffer);
+    }
+
+    void resource_tracker_t::reset()
+    {
+        _images.clear();
+        _buffers.clear();
+    }
+
+    bool resource_tracker_t::pending(const access_state_t& state) const
+    {
+        return state.batch == _batch;
+    }
+
+    void resource_tracker_t::merge_pending(
+        access_state_t& state,
+        const resource_usage_t& usage,
+        VkAccessFlags& pending_dst_access
+    )
+    {
+        // reads can share the barrier, anything else has to wait for the
+        // commands the barrier is for
+        if (state.pending_write || writes_memory(usage))
+            throw std::runtime_error{
+                "resource written and used in one barrier batch, flush in between"
+            };
+        pending_dst_access |= usage.access;
+        _pending.dst_stages |= usage.stages;
+        state.read_stages |= usage.stages;
+        state.visible_stages |= usage.stages;
+        state.visible_access |= usage.access;
+    }
+
+    std::optional<resource_tracker_t::dependency_t> resource_tracker_t::update(
+        access_state_t& state,
+        const resource_usage_t& usage,
+        bool layout_change
+    )
+    {
+        std::optional<dependency_t> result;
+        if (layout_change || writes_memory(usage))
+        {
+            // write after write and write after read, layout transitions
+            // count as writes
+            auto src_stages = state.write_stages | state.read_stages;
+            if (src_stages || layout_change)
+                result = dependency_t{
+                    src_stages,
+                    state.write_access,
+                    usage.stages,
+                    usage.access
+                };
+            bool writes = writes_memory(usage);
+            state.write_stages = usage.stages;
+            state.write_access = usage.access & write_access_mask;
+            // the barrier made the transition visible to the usage itself
+            state.read_stages = writes ? 0 : usage.stages;
+            state.visible_stages = writes ? 0 : usage.stages;
+            state.visible_access = writes ? 0 : usage.access;
+            return result;
+        }
+        // read after write, only if the write is not visible yet
+        bool visible =
+            (usage.stages & ~state.visible_stages) == 0 &&
+            (usage.access & ~state.visible_access) == 0;
+        if (state.write_stages && !visible)
+        {
+            result = dependency_t{
+                state.write_stages,
+                state.write_access,
+                usage.stages,
+                usage.access
+            };
+            state.visible_stages |= usage.stages;
+            state.visible_access |= usage.access;
+        }
+        state.read_stages |= usage.stages;
+        return result;
+    }
+
+    void resource_tracker_t::add_dependency(const dependency_t& dependency)
+    {
+        _pending.src_stages |= dependency.src_stages ?
+            dependency.src_stages :
+            VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
+        _pending.dst_stages |= dependency.dst_stages ?
+            dependency.dst_stages :
+            VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT;
+    }
+}
@@ -0,0 +1,128 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+#include <optional>
+#include <unordered_map>
+#include <vector>
+
+#include "command_buffer.hpp"
+
+namespace my_vulkan
+{
+    struct image_t;
+
+    // how the next commands touch a resource, layout only matters for images
+    struct resource_usage_t
+    {
+        VkPipelineStageFlags stages;
+        VkAccessFlags access;
+        VkImageLayout layout{VK_IMAGE_LAYOUT_UNDEFINED};
+    };
+
+    // the stages and accesses an image in layout is typically used with
+    resource_usage_t image_usage(VkImageLayout layout);
+    VkImageAspectFlags image_aspects(VkFormat format);
+
+    // barriers that go into one vkCmdPipelineBarrier
+    struct barrier_batch_t
+    {
+        VkPipelineStageFlags src_stages{0};
+        VkPipelineStageFlags dst_stages{0};
+        std::vector<VkBufferMemoryBarrier> buffer_barriers;
+        std::vector<VkImageMemoryBarrier> image_barriers;
+        bool empty() const;
+        void record(command_buffer_t::scope_t& commands) const;
+    };
+
+    // remembers the last layout, access and stage of images and buffer
+    // ranges and turns declared usages into the barriers needed, all
+    // barriers declared between two flushes go into one vkCmdPipelineBarrier
+    class resource_tracker_t
+    {
+    public:
+        // the state a resource was left in by commands the tracker did not
+        // see, like the final layout of a render pass
+        void assume(VkImage image, resource_usage_t usage);
+        void assume(
+            VkBuffer buffer,
+            resource_usage_t usage,
+            VkDeviceSize offset = 0,
+            VkDeviceSize size = VK_WHOLE_SIZE
+        );
+        // discard allows transitioning from the undefined layout
+        void use(
+            image_t& image,
+            resource_usage_t usage,
+            bool discard = false
+        );
+        void use(
+            VkImage image,
+            VkImageAspectFlags aspects,
+            resource_usage_t usage,
+            bool discard = false
+        );
+        void use(
+            VkBuffer buffer,
+            resource_usage_t usage,
+            VkDeviceSize offset = 0,
+            VkDeviceSize size = VK_WHOLE_SIZE
+        );
+        // records the pending barriers, has to come before the commands
+        // that use the resources
+        void flush(command_buffer_t::scope_t& commands);
+        // hands out the pending barriers instead of recording them, for
+        // recording them later or more than once
+        barrier_batch_t take_barriers();
+        // stop tracking, the next use starts from scratch
+        void forget(VkImage image);
+        void forget(VkBuffer buffer);
+        void reset();
+    private:
+        struct access_state_t
+        {
+            VkImageLayout layout{VK_IMAGE_LAYOUT_UNDEFINED};
+            VkPipelineStageFlags write_stages{0};
+            VkAccessFlags write_access{0};
+            VkPipelineStageFlags read_stages{0};
+            // accesses that already see the last write
+            VkPipelineStageFlags visible_stages{0};
+            VkAccessFlags visible_access{0};
+            // barrier of the current batch that touches the resource,
+            // reads can still be added to it
+            size_t batch{0};
+            size_t barrier{0};
+            bool pending_write{false};
+        };
+        struct buffer_range_t
+        {
+            VkDeviceSize begin;
+            VkDeviceSize end;
+            access_state_t state;
+        };
+        struct dependency_t
+        {
+            VkPipelineStageFlags src_stages;
+            VkAccessFlags src_access;
+            VkPipelineStageFlags dst_stages;
+            VkAccessFlags dst_access;
+        };
+        static access_state_t assumed_state(const resource_usage_t& usage);
+        bool pending(const access_state_t& state) const;
+        void merge_pending(
+            access_state_t& state,
+            const resource_usage_t& usage,
+            VkAccessFlags& pending_dst_access
+        );
+        std::optional<dependency_t> update(
+            access_state_t& state,
+            const resource_usage_t& usage,
+            bool layout_change
+        );
+        void add_dependency(const dependency_t& dependency);
+        std::unordered_map<VkImage, access_state_t> _images;
+        std::unordered_map<VkBuffer, std::vector<buffer_range_t>> _buffers;
+        barrier_batch_t _pending;
+        // zero is never a batch so fresh states are not pending
+        size_t _batch{1};
+    };
+}
@@ -50,6 +50,7 @@ namespace my_vulkan
     )
     : _device{device}
     , _shader_module{createShaderModule(device, code, size)}
+    , _code(code, code + size)
     {
     }
 
@@ -63,6 +64,7 @@ namespace my_vulkan
     {
         cleanup();
         _shader_module = other._shader_module;
+        _code = std::move(other._code);
         std::swap(_device, other._device);
         return *this;
     }
@@ -72,6 +74,11 @@ namespace my_vulkan
         return _shader_module;
     }
 
+    const std::vector<uint8_t>& shader_module_t::code() const
+    {
+        return _code;
+    }
+
     shader_module_t::~shader_module_t()
     {
         cleanup();
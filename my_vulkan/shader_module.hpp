@@ -28,9 +28,13 @@ namespace my_vulkan
         shader_module_t& operator=(shader_module_t&& other) noexcept;
         ~shader_module_t();
         VkShaderModule get() const;
+        // the SPIR-V the module was created from, handles can be reused
+        // by the driver once a module is gone, the code identifies it
+        const std::vector<uint8_t>& code() const;
     private:
         void cleanup();
         VkDevice _device;
         VkShaderModule _shader_module;
+        std::vector<uint8_t> _code;
     };
 }
@@ -0,0 +1,235 @@
+#include "staging_ring.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+
+#include "utils.hpp"
+
+namespace my_vulkan
+{
+    staging_ring_t::staging_ring_t(
+        device_t& device,
+        VkDeviceSize capacity
+    )
+    : _device{&device}
+    , _buffer{
+        device,
+        capacity,
+        VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT
+    }
+    , _data{static_cast<char*>(_buffer.memory()->mapped_data())}
+    {
+        if (!_data)
+            throw std::runtime_error{"staging ring memory is not mapped"};
+    }
+
+    staging_ring_t::~staging_ring_t()
+    {
+        for (auto& entry : _pending)
+        {
+            if (!entry.done && entry.fence)
+                _fences[*entry.fence].fence.wait();
+        }
+    }
+
+    VkDeviceSize staging_ring_t::capacity() const
+    {
+        return _buffer.size();
+    }
+
+    staging_ring_t::pending_t& staging_ring_t::pending(uint64_t id)
+    {
+        if (id < _first_id || id - _first_id >= _pending.size())
+            throw std::invalid_argument{"staging region is not pending"};
+        return _pending[id - _first_id];
+    }
+
+    std::optional<VkDeviceSize> staging_ring_t::find_space(
+        VkDeviceSize size,
+        VkDeviceSize alignment
+    ) const
+    {
+        auto align = [&](VkDeviceSize offset){
+            return (offset + alignment - 1) / alignment * alignment;
+        };
+        auto oldest = std::find_if(
+            _pending.begin(),
+            _pending.end(),
+            [](auto& entry){ return !entry.oversized; }
+        );
+        if (oldest == _pending.end())
+        {
+            if (size <= capacity())
+                return 0;
+            return std::nullopt;
+        }
+        auto tail = oldest->begin;
+        // head caught up with tail from below: the ring is full
+        if (_head <= tail)
+        {
+            auto offset = align(_head);
+            if (offset + size <= tail)
+                return offset;
+            return std::nullopt;
+        }
+        auto offset = align(_head);
+        if (offset + size <= capacity())
+            return offset;
+        // wrap around, the skipped end is recycled with the entry before it
+        if (size <= tail)
+            return 0;
+        return std::nullopt;
+    }
+
+    bool staging_ring_t::reclaim(bool wait)
+    {
+        bool reclaimed = false;
+        while (!_pending.empty())
+        {
+            auto& oldest = _pending.front();
+            if (!oldest.done)
+            {
+                if (!oldest.fence)
+                    break;
+                auto& fence = _fences[*oldest.fence].fence;
+                if (wait && !reclaimed)
+                    fence.wait();
+                else if (vkGetFenceStatus(_device->get(), fence.get()) != VK_SUCCESS)
+                    break;
+            }
+            if (oldest.fence)
+                --_fences[*oldest.fence].users;
+            _pending.pop_front();
+            ++_first_id;
+            reclaimed = true;
+        }
+        return reclaimed;
+    }
+
+    staging_ring_t::region_t staging_ring_t::allocate(
+        VkDeviceSize size,
+        VkDeviceSize alignment
+    )
+    {
+        std::unique_lock<std::mutex> lock{_mutex};
+        size = std::max(size, VkDeviceSize{1});
+        if (size <= capacity())
+        {
+            reclaim(false);
+            while (true)
+            {
+                if (auto offset = find_space(size, alignment))
+                {
+                    _pending.push_back({*offset, *offset + size, nullptr, std::nullopt, false});
+                    _head = *offset + size;
+                    return {
+                        _buffer.get(),
+                        *offset,
+                        size,
+                        _data + *offset,
+                        _first_id + _pending.size() - 1
+                    };
+                }
+                // blocked by a region that was never retired
+                if (!reclaim(true))
+                    break;
+            }
+        }
+        auto oversized = std::make_unique<buffer_t>(
+            *_device,
+            size,
+            VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT
+        );
+        region_t result{
+            oversized->get(),
+            0,
+            size,
+            oversized->memory()->mapped_data(),
+            _first_id + _pending.size()
+        };
+        _pending.push_back({0, 0, std::move(oversized), std::nullopt, false});
+        return result;
+    }
+
+    staging_ring_t::submission_t staging_ring_t::retire(const std::vector<region_t>& regions)
+    {
+        std::unique_lock<std::mutex> lock{_mutex};
+        if (regions.empty())
+            return {VK_NULL_HANDLE, 0};
+        auto slot = std::find_if(
+            _fences.begin(),
+            _fences.end(),
+            [](auto& candidate){ return candidate.users == 0; }
+        );
+        if (slot == _fences.end())
+        {
+            _fences.push_back({fence_t{_device->get()}, 0, 0});
+            slot = _fences.end() - 1;
+        }
+        else
+        {
+            slot->fence.reset();
+        }
+        auto index = size_t(slot - _fences.begin());
+        for (auto& region : regions)
+        {
+            pending(region.id).fence = index;
+            ++slot->users;
+        }
+        slot->serial = _next_serial++;
+        return {slot->fence.get(), slot->serial};
+    }
+
+    void staging_ring_t::abandon(const submission_t& submission)
+    {
+        std::unique_lock<std::mutex> lock{_mutex};
+        auto slot = find_slot(submission.serial);
+        if (!slot)
+            return;
+        auto index = size_t(slot - _fences.data());
+        for (auto& entry : _pending)
+        {
+            if (entry.fence == index)
+            {
+                entry.fence.reset();
+                entry.done = true;
+                --slot->users;
+            }
+        }
+        reclaim(false);
+    }
+
+    staging_ring_t::fence_slot_t* staging_ring_t::find_slot(uint64_t serial)
+    {
+        // a slot only gets reused after everything retired with it completed
+        for (auto& slot : _fences)
+        {
+            if (slot.users && slot.serial == serial)
+                return &slot;
+        }
+        return nullptr;
+    }
+
+    bool staging_ring_t::is_complete(uint64_t serial)
+    {
+        std::unique_lock<std::mutex> lock{_mutex};
+        auto slot = find_slot(serial);
+        return !slot || vkGetFenceStatus(_device->get(), slot->fence.get()) == VK_SUCCESS;
+    }
+
+    void staging_ring_t::wait(uint64_t serial)
+    {
+        std::unique_lock<std::mutex> lock{_mutex};
+        if (auto slot = find_slot(serial))
+            slot->fence.wait();
+    }
+
+    void staging_ring_t::release(const region_t& region)
+    {
+        std::unique_lock<std::mutex> lock{_mutex};
+        pending(region.id).done = true;
+        reclaim(false);
+    }
+}
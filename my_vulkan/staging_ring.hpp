@@ -0,0 +1,89 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "buffer.hpp"
+#include "fence.hpp"
+
+namespace my_vulkan
+{
+    // one persistently mapped host visible buffer that all uploads copy
+    // their data through. space is handed out in submission order and
+    // recycled once the fence a region was retired with has signaled.
+    struct staging_ring_t
+    {
+        struct region_t
+        {
+            VkBuffer buffer;
+            VkDeviceSize offset;
+            VkDeviceSize size;
+            void* data;
+            uint64_t id;
+        };
+        static constexpr VkDeviceSize default_capacity = VkDeviceSize{32} << 20;
+        staging_ring_t(
+            device_t& device,
+            VkDeviceSize capacity = default_capacity
+        );
+        staging_ring_t(const staging_ring_t&) = delete;
+        staging_ring_t& operator=(const staging_ring_t&) = delete;
+        ~staging_ring_t();
+        // waits for older uploads to retire if the ring is full,
+        // requests larger than the ring get a buffer of their own
+        region_t allocate(
+            VkDeviceSize size,
+            VkDeviceSize alignment = 16
+        );
+        struct submission_t
+        {
+            // to submit the commands reading from the regions with
+            VkFence fence;
+            uint64_t serial;
+        };
+        submission_t retire(const std::vector<region_t>& regions);
+        // when submitting with the fence threw it will never signal, the
+        // regions retired with it go back to the ring
+        void abandon(const submission_t& submission);
+        // fences are recycled, completion is tracked by serial instead
+        bool is_complete(uint64_t serial);
+        void wait(uint64_t serial);
+        // for regions whose commands are already known to be complete
+        void release(const region_t& region);
+        VkDeviceSize capacity() const;
+    private:
+        struct pending_t
+        {
+            VkDeviceSize begin;
+            VkDeviceSize end;
+            std::unique_ptr<buffer_t> oversized;
+            std::optional<size_t> fence;
+            bool done;
+        };
+        struct fence_slot_t
+        {
+            fence_t fence;
+            size_t users;
+            uint64_t serial;
+        };
+        fence_slot_t* find_slot(uint64_t serial);
+        std::optional<VkDeviceSize> find_space(
+            VkDeviceSize size,
+            VkDeviceSize alignment
+        ) const;
+        bool reclaim(bool wait);
+        pending_t& pending(uint64_t id);
+        device_t* _device;
+        buffer_t _buffer;
+        char* _data;
+        VkDeviceSize _head{0};
+        std::deque<pending_t> _pending;
+        uint64_t _first_id{0};
+        std::vector<fence_slot_t> _fences;
+        uint64_t _next_serial{1};
+        std::mutex _mutex;
+    };
+}
@@ -1,4 +1,6 @@
 #include "texture_sampler.hpp"
+#include "device.hpp"
+#include "pipeline_registry.hpp"
 #include "utils.hpp"
 
 namespace my_vulkan
@@ -41,6 +43,12 @@ namespace my_vulkan
         );
     }
 
+    texture_sampler_t::texture_sampler_t(device_t& device, filter_mode_t filter_mode)
+    : texture_sampler_t{device.get(), filter_mode}
+    {
+        _owner = &device;
+    }
+
     texture_sampler_t::texture_sampler_t(texture_sampler_t&& other) noexcept
     : _device{0}
     {
@@ -52,6 +60,7 @@ namespace my_vulkan
         cleanup();
         _sampler = other._sampler;
         std::swap(_device, other._device);
+        std::swap(_owner, other._owner);
         return *this;
     }
 
@@ -64,6 +73,8 @@ namespace my_vulkan
     {
         if (_device)
         {
+            if (_owner)
+                _owner->pipeline_registry().forget(_sampler);
             vkDestroySampler(_device, _sampler, nullptr);
             _device = 0;
         }
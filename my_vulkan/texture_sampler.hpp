@@ -4,6 +4,8 @@
 
 namespace my_vulkan
 {
+    struct device_t;
+
     class texture_sampler_t
     {
     public:
@@ -12,6 +14,12 @@ namespace my_vulkan
             VkDevice device,
             filter_mode_t filter_mode = filter_mode_t::linear
         );
+        // also drops the registry's pipelines using the sampler as an
+        // immutable sampler on destruction
+        explicit texture_sampler_t(
+            device_t& device,
+            filter_mode_t filter_mode = filter_mode_t::linear
+        );
         texture_sampler_t(const texture_sampler_t&) = delete;
         texture_sampler_t(texture_sampler_t&& other) noexcept;
         texture_sampler_t& operator=(texture_sampler_t&& other) noexcept;
@@ -22,5 +30,6 @@ namespace my_vulkan
         void cleanup();
         VkDevice _device;
         VkSampler _sampler;
+        device_t* _owner{nullptr};
     };
 }
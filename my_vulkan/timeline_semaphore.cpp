@@ -0,0 +1,168 @@
+#include "timeline_semaphore.hpp"
+
+#include <utility>
+
+#include "utils.hpp"
+
+namespace my_vulkan
+{
+    static bool wait_semaphores(
+        VkDevice device,
+        PFN_vkWaitSemaphoresKHR fpWaitSemaphores,
+        const std::vector<timeline_semaphore_t::point_t>& points,
+        bool any,
+        uint64_t timeout
+    )
+    {
+        std::vector<VkSemaphore> semaphores;
+        std::vector<uint64_t> values;
+        for (auto& point : points)
+        {
+            semaphores.push_back(point.semaphore);
+            values.push_back(point.value);
+        }
+        VkSemaphoreWaitInfoKHR info = {};
+        info.sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO_KHR;
+        info.flags = any ? VK_SEMAPHORE_WAIT_ANY_BIT_KHR : 0;
+        info.semaphoreCount = uint32_t(semaphores.size());
+        info.pSemaphores = semaphores.data();
+        info.pValues = values.data();
+        auto result = fpWaitSemaphores(device, &info, timeout);
+        if (result == VK_TIMEOUT)
+            return false;
+        vk_require(result, "waiting for timeline semaphores");
+        return true;
+    }
+
+    timeline_semaphore_t::timeline_semaphore_t(
+        device_t& device,
+        uint64_t initial_value
+    )
+    : _device{device.get()}
+    , _fpGetSemaphoreCounterValue{
+        device.get_proc_record_if_needed<PFN_vkGetSemaphoreCounterValueKHR>(
+            "vkGetSemaphoreCounterValueKHR"
+        )
+    }
+    , _fpWaitSemaphores{
+        device.get_proc_record_if_needed<PFN_vkWaitSemaphoresKHR>("vkWaitSemaphoresKHR")
+    }
+    , _fpSignalSemaphore{
+        device.get_proc_record_if_needed<PFN_vkSignalSemaphoreKHR>("vkSignalSemaphoreKHR")
+    }
+    {
+        VkSemaphoreTypeCreateInfoKHR type_info = {};
+        type_info.sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO_KHR;
+        type_info.semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE_KHR;
+        type_info.initialValue = initial_value;
+        VkSemaphoreCreateInfo info = {};
+        info.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+        info.pNext = &type_info;
+        vk_require(
+            vkCreateSemaphore(_device, &info, nullptr, &_semaphore),
+            "create timeline semaphore"
+        );
+    }
+
+    timeline_semaphore_t::timeline_semaphore_t(timeline_semaphore_t&& other) noexcept
+    : _device{nullptr}
+    {
+        *this = std::move(other);
+    }
+
+    timeline_semaphore_t& timeline_semaphore_t::operator=(
+        timeline_semaphore_t&& other
+    ) noexcept
+    {
+        cleanup();
+        _semaphore = other._semaphore;
+        _fpGetSemaphoreCounterValue = other._fpGetSemaphoreCounterValue;
+        _fpWaitSemaphores = other._fpWaitSemaphores;
+        _fpSignalSemaphore = other._fpSignalSemaphore;
+        std::swap(_device, other._device);
+        return *this;
+    }
+
+    timeline_semaphore_t::~timeline_semaphore_t()
+    {
+        cleanup();
+    }
+
+    void timeline_semaphore_t::cleanup()
+    {
+        if (_device)
+        {
+            vkDestroySemaphore(_device, _semaphore, 0);
+            _device = nullptr;
+        }
+    }
+
+    VkSemaphore timeline_semaphore_t::get()
+    {
+        return _semaphore;
+    }
+
+    timeline_semaphore_t::point_t timeline_semaphore_t::at(uint64_t value)
+    {
+        return {_semaphore, value};
+    }
+
+    queue_reference_t::wait_semaphore_info_t timeline_semaphore_t::wait_info(
+        uint64_t value,
+        VkPipelineStageFlags stage
+    )
+    {
+        return {_semaphore, stage, value, true};
+    }
+
+    uint64_t timeline_semaphore_t::value() const
+    {
+        uint64_t result;
+        vk_require(
+            _fpGetSemaphoreCounterValue(_device, _semaphore, &result),
+            "getting timeline semaphore value"
+        );
+        return result;
+    }
+
+    void timeline_semaphore_t::signal(uint64_t value)
+    {
+        VkSemaphoreSignalInfoKHR info = {};
+        info.sType = VK_STRUCTURE_TYPE_SEMAPHORE_SIGNAL_INFO_KHR;
+        info.semaphore = _semaphore;
+        info.value = value;
+        vk_require(
+            _fpSignalSemaphore(_device, &info),
+            "signaling timeline semaphore"
+        );
+    }
+
+    bool timeline_semaphore_t::wait(uint64_t value, uint64_t timeout) const
+    {
+        return wait_semaphores(
+            _device,
+            _fpWaitSemaphores,
+            {{_semaphore, value}},
+            false,
+            timeout
+        );
+    }
+
+    bool timeline_semaphore_t::wait(
+        device_t& device,
+        const std::vector<point_t>& points,
+        bool any,
+        uint64_t timeout
+    )
+    {
+        if (points.empty())
+            return true;
+        return wait_semaphores(
+            device.get(),
+            device.get_proc_record_if_needed<PFN_vkWaitSemaphoresKHR>("vkWaitSemaphoresKHR"),
+            points,
+            any,
+            timeout
+        );
+    }
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+#include <limits>
+#include <vector>
+
+#include "device.hpp"
+
+namespace my_vulkan
+{
+    // VK_KHR_timeline_semaphore, the device has to be created with the
+    // extension enabled
+    struct timeline_semaphore_t
+    {
+        // can be passed to queue_reference_t::submit as a signal
+        using point_t = queue_reference_t::timeline_signal_info_t;
+        explicit timeline_semaphore_t(
+            device_t& device,
+            uint64_t initial_value = 0
+        );
+        timeline_semaphore_t(const timeline_semaphore_t&) = delete;
+        timeline_semaphore_t& operator=(const timeline_semaphore_t&) = delete;
+        timeline_semaphore_t(timeline_semaphore_t&& other) noexcept;
+        timeline_semaphore_t& operator=(timeline_semaphore_t&& other) noexcept;
+        ~timeline_semaphore_t();
+        VkSemaphore get();
+        point_t at(uint64_t value);
+        // for waiting on value in queue_reference_t::submit
+        queue_reference_t::wait_semaphore_info_t wait_info(
+            uint64_t value,
+            VkPipelineStageFlags stage = VK_PIPELINE_STAGE_ALL_COMMANDS_BIT
+        );
+        // last value signaled on the device or the host
+        uint64_t value() const;
+        void signal(uint64_t value);
+        // false on timeout
+        bool wait(
+            uint64_t value,
+            uint64_t timeout = std::numeric_limits<uint64_t>::max()
+        ) const;
+        // waits for all points, or for any of them, with one call
+        static bool wait(
+            device_t& device,
+            const std::vector<point_t>& points,
+            bool any = false,
+            uint64_t timeout = std::numeric_limits<uint64_t>::max()
+        );
+    private:
+        void cleanup();
+        VkDevice _device;
+        VkSemaphore _semaphore;
+        PFN_vkGetSemaphoreCounterValueKHR _fpGetSemaphoreCounterValue;
+        PFN_vkWaitSemaphoresKHR _fpWaitSemaphores;
+        PFN_vkSignalSemaphoreKHR _fpSignalSemaphore;
+    };
+}
@@ -0,0 +1,521 @@
+#include "transfer_engine.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+#include "utils.hpp"
+
+namespace my_vulkan
+{
+    static VkImageMemoryBarrier image_barrier(
+        image_t& image,
+        VkImageLayout old_layout,
+        VkImageLayout new_layout,
+        uint32_t src_family,
+        uint32_t dst_family,
+        VkAccessFlags src_access
+    )
+    {
+        VkImageMemoryBarrier barrier = {};
+        barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+        barrier.srcAccessMask = src_access;
+        barrier.dstAccessMask = 0;
+        barrier.oldLayout = old_layout;
+        barrier.newLayout = new_layout;
+        barrier.srcQueueFamilyIndex = src_family;
+        barrier.dstQueueFamilyIndex = dst_family;
+        barrier.image = image.get();
+        barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        barrier.subresourceRange.baseMipLevel = 0;
+        barrier.subresourceRange.levelCount = 1;
+        barrier.subresourceRange.baseArrayLayer = 0;
+        barrier.subresourceRange.layerCount = 1;
+        return barrier;
+    }
+
+    static VkBufferMemoryBarrier buffer_barrier(
+        buffer_t& buffer,
+        VkDeviceSize offset,
+        VkDeviceSize size,
+        uint32_t src_family,
+        uint32_t dst_family,
+        VkAccessFlags src_access
+    )
+    {
+        VkBufferMemoryBarrier barrier = {};
+        barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+        barrier.srcAccessMask = src_access;
+        barrier.dstAccessMask = 0;
+        barrier.srcQueueFamilyIndex = src_family;
+        barrier.dstQueueFamilyIndex = dst_family;
+        barrier.buffer = buffer.get();
+        barrier.offset = offset;
+        barrier.size = size;
+        return barrier;
+    }
+
+    transfer_engine_t::handoff_t::handoff_t(
+        command_buffer_t commands,
+        semaphore_t semaphore,
+        staging_ring_t* staging_ring,
+        uint64_t serial,
+        std::optional<fence_t> fence
+    )
+    : _commands{std::move(commands)}
+    , _semaphore{std::move(semaphore)}
+    , _staging_ring{staging_ring}
+    , _serial{serial}
+    , _fence{std::move(fence)}
+    , _pending{true}
+    {
+    }
+
+    transfer_engine_t::handoff_t::handoff_t(handoff_t&& other) noexcept
+    : _commands{std::move(other._commands)}
+    , _semaphore{std::move(other._semaphore)}
+    , _wait_semaphore{std::move(other._wait_semaphore)}
+    , _staging_ring{other._staging_ring}
+    , _serial{other._serial}
+    , _fence{std::move(other._fence)}
+    , _buffer_barriers{std::move(other._buffer_barriers)}
+    , _image_barriers{std::move(other._image_barriers)}
+    , _readback{std::move(other._readback)}
+    , _pending{other._pending}
+    {
+        other._pending = false;
+    }
+
+    transfer_engine_t::handoff_t& transfer_engine_t::handoff_t::operator=(
+        handoff_t&& other
+    ) noexcept
+    {
+        cleanup();
+        _commands = std::move(other._commands);
+        _semaphore = std::move(other._semaphore);
+        _wait_semaphore = std::move(other._wait_semaphore);
+        _staging_ring = other._staging_ring;
+        _serial = other._serial;
+        _fence = std::move(other._fence);
+        _buffer_barriers = std::move(other._buffer_barriers);
+        _image_barriers = std::move(other._image_barriers);
+        _readback = std::move(other._readback);
+        std::swap(_pending, other._pending);
+        return *this;
+    }
+
+    transfer_engine_t::handoff_t::~handoff_t()
+    {
+        cleanup();
+    }
+
+    void transfer_engine_t::handoff_t::cleanup()
+    {
+        // the semaphores may only go once the submission is done with
+        // them. one that was taken is not ours to destroy, nothing else
+        // ever waited on one that was not
+        if (_pending)
+            wait();
+    }
+
+    semaphore_t transfer_engine_t::handoff_t::take_semaphore()
+    {
+        if (!_semaphore)
+            throw std::logic_error{"handoff semaphore was already taken"};
+        auto semaphore = std::move(*_semaphore);
+        _semaphore.reset();
+        return semaphore;
+    }
+
+    void transfer_engine_t::handoff_t::acquire(
+        command_buffer_t::scope_t& commands,
+        VkPipelineStageFlags dst_stage,
+        VkAccessFlags dst_access
+    )
+    {
+        if (_buffer_barriers.empty() && _image_barriers.empty())
+            return;
+        // same barriers as the release, only the access masks differ
+        auto buffer_barriers = _buffer_barriers;
+        for (auto& barrier : buffer_barriers)
+        {
+            barrier.srcAccessMask = 0;
+            barrier.dstAccessMask = dst_access;
+        }
+        auto image_barriers = _image_barriers;
+        for (auto& barrier : image_barriers)
+        {
+            barrier.srcAccessMask = 0;
+            barrier.dstAccessMask = dst_access;
+        }
+        commands.pipeline_barrier(
+            VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+            dst_stage,
+            {},
+            std::move(buffer_barriers),
+            std::move(image_barriers)
+        );
+    }
+
+    bool transfer_engine_t::handoff_t::ready()
+    {
+        if (!_pending)
+            return true;
+        if (_fence)
+            return vkGetFenceStatus(_commands.device(), _fence->get()) == VK_SUCCESS;
+        return _staging_ring->is_complete(_serial);
+    }
+
+    void transfer_engine_t::handoff_t::wait()
+    {
+        if (!_pending)
+            return;
+        if (_fence)
+            _fence->wait();
+        else
+            _staging_ring->wait(_serial);
+        _pending = false;
+    }
+
+    const void* transfer_engine_t::handoff_t::readback_data()
+    {
+        if (!_readback)
+            return nullptr;
+        wait();
+        _readback->memory()->invalidate();
+        return _readback->memory()->mapped_data();
+    }
+
+    transfer_engine_t::readback_t::readback_t(
+        semaphore_t semaphore,
+        image_t* image,
+        buffer_t* buffer,
+        VkImageLayout layout
+    )
+    : _semaphore{std::move(semaphore)}
+    , _image{image}
+    , _buffer{buffer}
+    , _layout{layout}
+    {
+    }
+
+    VkSemaphore transfer_engine_t::readback_t::semaphore()
+    {
+        return _semaphore.get();
+    }
+
+    transfer_engine_t::transfer_engine_t(device_t& device)
+    : transfer_engine_t{
+        device,
+        device.transfer_queue(),
+        device.graphics_queue()
+    }
+    {
+    }
+
+    transfer_engine_t::transfer_engine_t(
+        device_t& device,
+        queue_reference_t& transfer_queue,
+        queue_reference_t& destination_queue
+    )
+    : _device{&device}
+    , _transfer_queue{&transfer_queue}
+    , _src_family{transfer_queue.family_index()}
+    , _dst_family{destination_queue.family_index()}
+    , _command_pool{device.get(), transfer_queue}
+    , _commands{_command_pool.make_buffer()}
+    , _scope{_commands.begin(VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT)}
+    {
+        if (_src_family == _dst_family)
+        {
+            _src_family = VK_QUEUE_FAMILY_IGNORED;
+            _dst_family = VK_QUEUE_FAMILY_IGNORED;
+        }
+    }
+
+    transfer_engine_t::~transfer_engine_t()
+    {
+        for (auto& region : _regions)
+            _device->staging_ring().release(region);
+    }
+
+    bool transfer_engine_t::ownership_transfer() const
+    {
+        return _src_family != _dst_family;
+    }
+
+    void transfer_engine_t::upload(
+        buffer_t& buffer,
+        const void* data,
+        VkDeviceSize size,
+        VkDeviceSize offset
+    )
+    {
+        auto region = _device->staging_ring().allocate(size);
+        std::memcpy(region.data, data, size);
+        _regions.push_back(region);
+        _scope.copy(region.buffer, buffer.get(), {{region.offset, offset, size}});
+        _buffer_barriers.push_back(buffer_barrier(
+            buffer,
+            offset,
+            size,
+            _src_family,
+            _dst_family,
+            VK_ACCESS_TRANSFER_WRITE_BIT
+        ));
+    }
+
+    void transfer_engine_t::upload(
+        image_t& image,
+        const void* pixels,
+        std::optional<size_t> pitch,
+        VkImageLayout final_layout
+    )
+    {
+        auto extent = image.extent();
+        auto texel_size = VkDeviceSize(bytes_per_pixel(image.format()));
+        auto row_pitch = pitch.value_or(extent.width * texel_size);
+        auto size = row_pitch * extent.height;
+        // copy offsets must be a multiple of 4 and of the texel size
+        auto region = _device->staging_ring().allocate(
+            size,
+            std::max<VkDeviceSize>(texel_size % 4 ? texel_size * 4 : texel_size, 4)
+        );
+        std::memcpy(region.data, pixels, size);
+        _regions.push_back(region);
+        // the old contents are discarded, so the image does not need to be
+        // acquired from its current owner first
+        image.transition_layout(
+            VK_IMAGE_LAYOUT_UNDEFINED,
+            VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+            _scope
+        );
+        image.copy_from(
+            region.buffer,
+            _scope,
+            texel_size ? uint32_t(row_pitch / texel_size) : 0,
+            std::nullopt,
+            region.offset
+        );
+        _image_barriers.push_back(image_barrier(
+            image,
+            VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+            final_layout,
+            _src_family,
+            _dst_family,
+            VK_ACCESS_TRANSFER_WRITE_BIT
+        ));
+        image.set_layout(final_layout);
+    }
+
+    transfer_engine_t::readback_t transfer_engine_t::begin_readback(
+        image_t& image,
+        command_buffer_t::scope_t& commands,
+        VkPipelineStageFlags src_stage,
+        VkAccessFlags src_access
+    )
+    {
+        auto layout = image.layout();
+        commands.pipeline_barrier(
+            src_stage,
+            VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+            std::vector<VkImageMemoryBarrier>{image_barrier(
+                image,
+                layout,
+                VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+                _dst_family,
+                _src_family,
+                src_access
+            )}
+        );
+        return {semaphore_t{*_device}, &image, nullptr, layout};
+    }
+
+    transfer_engine_t::readback_t transfer_engine_t::begin_readback(
+        buffer_t& buffer,
+        command_buffer_t::scope_t& commands,
+        VkPipelineStageFlags src_stage,
+        VkAccessFlags src_access
+    )
+    {
+        if (ownership_transfer())
+        {
+            commands.pipeline_barrier(
+                src_stage,
+                VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+                std::vector<VkBufferMemoryBarrier>{buffer_barrier(
+                    buffer,
+                    0,
+                    VK_WHOLE_SIZE,
+                    _dst_family,
+                    _src_family,
+                    src_access
+                )}
+            );
+        }
+        return {semaphore_t{*_device}, nullptr, &buffer, VK_IMAGE_LAYOUT_UNDEFINED};
+    }
+
+    transfer_engine_t::handoff_t transfer_engine_t::submit()
+    {
+        return submit(std::nullopt, nullptr);
+    }
+
+    transfer_engine_t::handoff_t transfer_engine_t::submit(readback_t readback)
+    {
+        auto size = readback._buffer ?
+            readback._buffer->size() :
+            VkDeviceSize(
+                readback._image->extent().width *
+                readback._image->extent().height *
+                bytes_per_pixel(readback._image->format())
+            );
+        auto result = std::make_unique<buffer_t>(
+            *_device,
+            size,
+            VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT
+        );
+        std::vector<VkBufferMemoryBarrier> buffer_acquire;
+        std::vector<VkImageMemoryBarrier> image_acquire;
+        if (readback._buffer)
+        {
+            buffer_acquire.push_back(buffer_barrier(
+                *readback._buffer,
+                0,
+                VK_WHOLE_SIZE,
+                _dst_family,
+                _src_family,
+                0
+            ));
+        }
+        else
+        {
+            image_acquire.push_back(image_barrier(
+                *readback._image,
+                readback._layout,
+                VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+                _dst_family,
+                _src_family,
+                0
+            ));
+        }
+        if (ownership_transfer())
+        {
+            for (auto& barrier : buffer_acquire)
+                barrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+            for (auto& barrier : image_acquire)
+                barrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+            _scope.pipeline_barrier(
+                VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+                VK_PIPELINE_STAGE_TRANSFER_BIT,
+                {},
+                buffer_acquire,
+                image_acquire
+            );
+        }
+        if (readback._buffer)
+        {
+            _scope.copy(readback._buffer->get(), result->get(), {{0, 0, size}});
+            if (ownership_transfer())
+            {
+                _buffer_barriers.push_back(buffer_barrier(
+                    *readback._buffer,
+                    0,
+                    VK_WHOLE_SIZE,
+                    _src_family,
+                    _dst_family,
+                    0
+                ));
+            }
+        }
+        else
+        {
+            readback._image->copy_to(result->get(), _scope);
+            // hand the image back in the layout it was released in
+            _image_barriers.push_back(image_barrier(
+                *readback._image,
+                VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+                readback._layout,
+                _src_family,
+                _dst_family,
+                0
+            ));
+        }
+        VkMemoryBarrier host_barrier = {};
+        host_barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+        host_barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        host_barrier.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+        _scope.pipeline_barrier(
+            VK_PIPELINE_STAGE_TRANSFER_BIT,
+            VK_PIPELINE_STAGE_HOST_BIT,
+            std::vector<VkMemoryBarrier>{host_barrier}
+        );
+        return submit(std::move(readback._semaphore), std::move(result));
+    }
+
+    transfer_engine_t::handoff_t transfer_engine_t::submit(
+        std::optional<semaphore_t> wait_semaphore,
+        std::unique_ptr<buffer_t> readback
+    )
+    {
+        // all releases in one barrier, the destination queue waits on the
+        // semaphore so the dst stage does not matter here
+        if (!_buffer_barriers.empty() || !_image_barriers.empty())
+        {
+            _scope.pipeline_barrier(
+                VK_PIPELINE_STAGE_TRANSFER_BIT,
+                VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+                {},
+                _buffer_barriers,
+                _image_barriers
+            );
+        }
+        _scope.end();
+        auto submission = _device->staging_ring().retire(_regions);
+        std::optional<fence_t> fence;
+        if (!submission.fence)
+            fence.emplace(_device->get());
+        semaphore_t semaphore{*_device};
+        std::vector<queue_reference_t::wait_semaphore_info_t> waits;
+        if (wait_semaphore)
+            waits.push_back({wait_semaphore->get(), VK_PIPELINE_STAGE_TRANSFER_BIT});
+        try
+        {
+            _transfer_queue->submit(
+                _commands.get(),
+                waits,
+                {semaphore.get()},
+                fence ? fence->get() : submission.fence
+            );
+        }
+        catch (...)
+        {
+            // the regions are not ours to release any more
+            _device->staging_ring().abandon(submission);
+            _regions.clear();
+            throw;
+        }
+        handoff_t result{
+            std::move(_commands),
+            std::move(semaphore),
+            &_device->staging_ring(),
+            submission.serial,
+            std::move(fence)
+        };
+        result._wait_semaphore = std::move(wait_semaphore);
+        result._readback = std::move(readback);
+        // barriers with ignored families have nothing left to acquire
+        if (ownership_transfer())
+        {
+            result._buffer_barriers = std::move(_buffer_barriers);
+            result._image_barriers = std::move(_image_barriers);
+        }
+        _regions.clear();
+        _buffer_barriers.clear();
+        _image_barriers.clear();
+        _commands = _command_pool.make_buffer();
+        _scope = _commands.begin(VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT);
+        return result;
+    }
+}
@@ -0,0 +1,157 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+#include <memory>
+#include <optional>
+#include <vector>
+
+#include "buffer.hpp"
+#include "command_buffer.hpp"
+#include "command_pool.hpp"
+#include "device.hpp"
+#include "fence.hpp"
+#include "image.hpp"
+#include "queue.hpp"
+#include "semaphore.hpp"
+#include "staging_ring.hpp"
+
+namespace my_vulkan
+{
+    // records uploads and readbacks for the transfer queue and hands the
+    // resources over to the destination queue (graphics by default).
+    // if both queues share a family no ownership transfer is needed and
+    // the semaphore alone orders the two submissions.
+    // not thread safe, use one engine per thread. handoffs must not
+    // outlive the engine that submitted them.
+    struct transfer_engine_t
+    {
+        // result of a transfer submission. the destination queue has to
+        // wait on take_semaphore() and record acquire() before using the
+        // resources. destroying an unfinished handoff waits for it.
+        struct handoff_t
+        {
+            handoff_t(const handoff_t&) = delete;
+            handoff_t(handoff_t&& other) noexcept;
+            handoff_t& operator=(const handoff_t&) = delete;
+            handoff_t& operator=(handoff_t&& other) noexcept;
+            ~handoff_t();
+            // signaled by the transfer submission. the caller owns it from
+            // here on and keeps it until the submission waiting on it has
+            // completed, the handoff can not tell when that is
+            semaphore_t take_semaphore();
+            // records the acquire half of the ownership transfers
+            void acquire(
+                command_buffer_t::scope_t& commands,
+                VkPipelineStageFlags dst_stage = VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
+                VkAccessFlags dst_access = VK_ACCESS_MEMORY_READ_BIT | VK_ACCESS_MEMORY_WRITE_BIT
+            );
+            bool ready();
+            void wait();
+            // waits for the submission, null if nothing was read back
+            const void* readback_data();
+        private:
+            friend struct transfer_engine_t;
+            handoff_t(
+                command_buffer_t commands,
+                semaphore_t semaphore,
+                staging_ring_t* staging_ring,
+                uint64_t serial,
+                std::optional<fence_t> fence
+            );
+            void cleanup();
+            command_buffer_t _commands;
+            std::optional<semaphore_t> _semaphore;
+            std::optional<semaphore_t> _wait_semaphore;
+            staging_ring_t* _staging_ring;
+            uint64_t _serial;
+            std::optional<fence_t> _fence;
+            std::vector<VkBufferMemoryBarrier> _buffer_barriers;
+            std::vector<VkImageMemoryBarrier> _image_barriers;
+            std::unique_ptr<buffer_t> _readback;
+            bool _pending{false};
+        };
+        // a resource released by the destination queue for reading it back
+        struct readback_t
+        {
+            readback_t(const readback_t&) = delete;
+            readback_t(readback_t&& other) noexcept = default;
+            readback_t& operator=(const readback_t&) = delete;
+            readback_t& operator=(readback_t&& other) noexcept = default;
+            // signal this from the submission that recorded the release,
+            // it has to be submitted before the readback
+            VkSemaphore semaphore();
+        private:
+            friend struct transfer_engine_t;
+            readback_t(
+                semaphore_t semaphore,
+                image_t* image,
+                buffer_t* buffer,
+                VkImageLayout layout
+            );
+            semaphore_t _semaphore;
+            image_t* _image;
+            buffer_t* _buffer;
+            VkImageLayout _layout;
+        };
+        explicit transfer_engine_t(device_t& device);
+        transfer_engine_t(
+            device_t& device,
+            queue_reference_t& transfer_queue,
+            queue_reference_t& destination_queue
+        );
+        transfer_engine_t(const transfer_engine_t&) = delete;
+        transfer_engine_t& operator=(const transfer_engine_t&) = delete;
+        // hands back the staging space of uploads that were never submitted
+        ~transfer_engine_t();
+        // only the written range changes owner, the rest of the buffer
+        // stays with the destination queue
+        void upload(
+            buffer_t& buffer,
+            const void* data,
+            VkDeviceSize size,
+            VkDeviceSize offset = 0
+        );
+        // pitch in bytes per row, tightly packed rows by default
+        void upload(
+            image_t& image,
+            const void* pixels,
+            std::optional<size_t> pitch = std::nullopt,
+            VkImageLayout final_layout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL
+        );
+        handoff_t submit();
+        // record the release into the destination queue's commands after
+        // the last access to the resource, src_stage and src_access
+        // describe that access
+        readback_t begin_readback(
+            image_t& image,
+            command_buffer_t::scope_t& commands,
+            VkPipelineStageFlags src_stage,
+            VkAccessFlags src_access
+        );
+        readback_t begin_readback(
+            buffer_t& buffer,
+            command_buffer_t::scope_t& commands,
+            VkPipelineStageFlags src_stage,
+            VkAccessFlags src_access
+        );
+        // submits the pending uploads together with the readback, the
+        // resource is handed back to the destination queue afterwards
+        handoff_t submit(readback_t readback);
+        bool ownership_transfer() const;
+    private:
+        handoff_t submit(
+            std::optional<semaphore_t> wait_semaphore,
+            std::unique_ptr<buffer_t> readback
+        );
+        device_t* _device;
+        queue_reference_t* _transfer_queue;
+        uint32_t _src_family;
+        uint32_t _dst_family;
+        command_pool_t _command_pool;
+        command_buffer_t _commands;
+        command_buffer_t::scope_t _scope;
+        std::vector<staging_ring_t::region_t> _regions;
+        std::vector<VkBufferMemoryBarrier> _buffer_barriers;
+        std::vector<VkImageMemoryBarrier> _image_barriers;
+    };
+}
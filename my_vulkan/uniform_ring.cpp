@@ -0,0 +1,117 @@
+#include "uniform_ring.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+namespace my_vulkan
+{
+    static VkDeviceSize uniform_alignment(device_t& device)
+    {
+        VkPhysicalDeviceProperties properties;
+        vkGetPhysicalDeviceProperties(device.physical_device(), &properties);
+        // 16 keeps std140 blocks aligned where the limit is smaller
+        return std::max<VkDeviceSize>(
+            properties.limits.minUniformBufferOffsetAlignment,
+            16
+        );
+    }
+
+    uniform_ring_t::uniform_ring_t(
+        device_t& device,
+        VkDeviceSize block_size,
+        VkBufferUsageFlags usage,
+        VkDeviceSize capacity
+    )
+    : _block_size{block_size}
+    , _alignment{uniform_alignment(device)}
+    , _buffer{
+        device,
+        std::max(capacity, block_size) / block_size * block_size,
+        usage,
+        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT
+    }
+    , _data{static_cast<char*>(_buffer.memory()->mapped_data())}
+    , _free_blocks(size_t(_buffer.size() / block_size), true)
+    {
+        if (!_data)
+            throw std::runtime_error{"uniform ring memory is not mapped"};
+        // dynamic offsets are 32 bits
+        if (_buffer.size() > (VkDeviceSize{1} << 32))
+            throw std::invalid_argument{"uniform ring capacity is too large"};
+        _frames.resize(1);
+    }
+
+    VkDeviceSize uniform_ring_t::alignment() const
+    {
+        return _alignment;
+    }
+
+    size_t uniform_ring_t::num_blocks() const
+    {
+        std::unique_lock<std::mutex> lock{_mutex};
+        return size_t(std::count(_free_blocks.begin(), _free_blocks.end(), false));
+    }
+
+    void uniform_ring_t::begin_frame(size_t frame)
+    {
+        std::unique_lock<std::mutex> lock{_mutex};
+        if (frame >= _frames.size())
+            _frames.resize(frame + 1);
+        auto& target = _frames[frame];
+        for (auto& run : target.runs)
+            std::fill_n(_free_blocks.begin() + run.first, run.count, true);
+        target.runs.clear();
+        target.head = 0;
+        _frame = frame;
+        ++_frame_serial;
+    }
+
+    uint64_t uniform_ring_t::frame_serial() const
+    {
+        std::unique_lock<std::mutex> lock{_mutex};
+        return _frame_serial;
+    }
+
+    uniform_ring_t::run_t uniform_ring_t::take_run(size_t count)
+    {
+        auto first = std::search_n(
+            _free_blocks.begin(),
+            _free_blocks.end(),
+            count,
+            true
+        );
+        if (first == _free_blocks.end())
+            throw std::runtime_error{"uniform ring is full"};
+        std::fill_n(first, count, false);
+        return {size_t(first - _free_blocks.begin()), count};
+    }
+
+    uniform_ring_t::allocation_t uniform_ring_t::allocate(VkDeviceSize size)
+    {
+        std::unique_lock<std::mutex> lock{_mutex};
+        size = std::max(size, VkDeviceSize{1});
+        auto& frame = _frames[_frame];
+        auto offset = (frame.head + _alignment - 1) / _alignment * _alignment;
+        if (
+            frame.runs.empty() ||
+            offset + size > (frame.runs.back().first + frame.runs.back().count) * _block_size
+        )
+        {
+            frame.runs.push_back(take_run(size_t((size + _block_size - 1) / _block_size)));
+            offset = frame.runs.back().first * _block_size;
+        }
+        frame.head = offset + size;
+        return {_buffer.get(), uint32_t(offset), _data + offset};
+    }
+
+    uniform_ring_t::allocation_t uniform_ring_t::push(
+        const void* data,
+        VkDeviceSize size
+    )
+    {
+        auto allocation = allocate(size);
+        std::memcpy(allocation.data, data, size);
+        return allocation;
+    }
+}
@@ -0,0 +1,75 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "buffer.hpp"
+
+namespace my_vulkan
+{
+    // persistently mapped uniform buffer memory for data written once per
+    // draw and bound with a dynamic offset. space allocated in a frame is
+    // recycled when the same frame begins again, so each frame in flight
+    // needs its own index. frames take whole blocks of one fixed buffer,
+    // so descriptors written with it never have to change.
+    struct uniform_ring_t
+    {
+        struct allocation_t
+        {
+            // the same for every allocation of a ring
+            VkBuffer buffer;
+            // meant as the dynamic offset
+            uint32_t offset;
+            void* data;
+        };
+        static constexpr VkDeviceSize default_block_size = VkDeviceSize{1} << 20;
+        static constexpr VkDeviceSize default_capacity = VkDeviceSize{16} << 20;
+        // usage can add e.g. indirect buffer use for draw commands
+        explicit uniform_ring_t(
+            device_t& device,
+            VkDeviceSize block_size = default_block_size,
+            VkBufferUsageFlags usage = VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
+            VkDeviceSize capacity = default_capacity
+        );
+        uniform_ring_t(const uniform_ring_t&) = delete;
+        uniform_ring_t& operator=(const uniform_ring_t&) = delete;
+        // the previous use of frame has to be complete
+        void begin_frame(size_t frame);
+        // counts begin_frame calls. allocations are only safe to bind while
+        // it has not changed, after that their frame may be recycled
+        uint64_t frame_serial() const;
+        // aligned for dynamic uniform buffer offsets, safe to call from
+        // several recording threads. throws when the frames in flight
+        // hold every block
+        allocation_t allocate(VkDeviceSize size);
+        // copies data into a fresh allocation
+        allocation_t push(const void* data, VkDeviceSize size);
+        VkDeviceSize alignment() const;
+        // blocks currently held by frames
+        size_t num_blocks() const;
+    private:
+        // consecutive blocks, allocations larger than a block get several
+        struct run_t
+        {
+            size_t first;
+            size_t count;
+        };
+        struct frame_t
+        {
+            std::vector<run_t> runs;
+            VkDeviceSize head{0};
+        };
+        run_t take_run(size_t count);
+        VkDeviceSize _block_size;
+        VkDeviceSize _alignment;
+        buffer_t _buffer;
+        char* _data;
+        std::vector<bool> _free_blocks;
+        std::vector<frame_t> _frames;
+        size_t _frame{0};
+        uint64_t _frame_serial{0};
+        mutable std::mutex _mutex;
+    };
+}
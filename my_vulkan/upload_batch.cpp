@@ -0,0 +1,210 @@
+#include "upload_batch.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+#include "utils.hpp"
+
+namespace my_vulkan
+{
+    upload_batch_t::token_t::token_t(
+        command_buffer_t commands,
+        staging_ring_t* staging_ring,
+        uint64_t serial,
+        std::optional<fence_t> fence
+    )
+    : _commands{std::move(commands)}
+    , _staging_ring{staging_ring}
+    , _serial{serial}
+    , _fence{std::move(fence)}
+    , _pending{true}
+    {
+    }
+
+    upload_batch_t::token_t::token_t(token_t&& other) noexcept
+    : _commands{std::move(other._commands)}
+    , _staging_ring{other._staging_ring}
+    , _serial{other._serial}
+    , _fence{std::move(other._fence)}
+    , _pending{other._pending}
+    {
+        other._pending = false;
+    }
+
+    upload_batch_t::token_t& upload_batch_t::token_t::operator=(
+        token_t&& other
+    ) noexcept
+    {
+        cleanup();
+        _commands = std::move(other._commands);
+        _staging_ring = other._staging_ring;
+        _serial = other._serial;
+        _fence = std::move(other._fence);
+        std::swap(_pending, other._pending);
+        return *this;
+    }
+
+    upload_batch_t::token_t::~token_t()
+    {
+        cleanup();
+    }
+
+    void upload_batch_t::token_t::cleanup()
+    {
+        if (_pending)
+            wait();
+    }
+
+    bool upload_batch_t::token_t::ready()
+    {
+        if (!_pending)
+            return true;
+        if (_fence)
+            return vkGetFenceStatus(_commands.device(), _fence->get()) == VK_SUCCESS;
+        return _staging_ring->is_complete(_serial);
+    }
+
+    void upload_batch_t::token_t::wait()
+    {
+        if (!_pending)
+            return;
+        if (_fence)
+            _fence->wait();
+        else
+            _staging_ring->wait(_serial);
+        _pending = false;
+    }
+
+    upload_batch_t::upload_batch_t(
+        device_t& device,
+        command_pool_t& command_pool
+    )
+    : _device{&device}
+    , _command_pool{&command_pool}
+    , _commands{command_pool.make_buffer()}
+    , _scope{_commands.begin(VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT)}
+    {
+    }
+
+    upload_batch_t::~upload_batch_t()
+    {
+        for (auto& region : _regions)
+            _device->staging_ring().release(region);
+    }
+
+    staging_ring_t::region_t upload_batch_t::stage(
+        const void* data,
+        VkDeviceSize size,
+        VkDeviceSize alignment
+    )
+    {
+        auto region = _device->staging_ring().allocate(size, alignment);
+        std::memcpy(region.data, data, size);
+        _regions.push_back(region);
+        return region;
+    }
+
+    command_buffer_t::scope_t& upload_batch_t::commands()
+    {
+        return _scope;
+    }
+
+    void upload_batch_t::upload(
+        buffer_t& buffer,
+        const void* data,
+        VkDeviceSize size,
+        VkDeviceSize offset
+    )
+    {
+        auto region = stage(data, size);
+        _scope.copy(region.buffer, buffer.get(), {{region.offset, offset, size}});
+        _has_buffer_copies = true;
+    }
+
+    void upload_batch_t::upload(
+        image_t& image,
+        const void* pixels,
+        std::optional<size_t> pitch,
+        VkImageLayout final_layout
+    )
+    {
+        auto extent = image.extent();
+        auto texel_size = VkDeviceSize(bytes_per_pixel(image.format()));
+        auto row_pitch = pitch.value_or(extent.width * texel_size);
+        // copy offsets must be a multiple of 4 and of the texel size
+        auto region = stage(
+            pixels,
+            row_pitch * extent.height,
+            std::max<VkDeviceSize>(texel_size % 4 ? texel_size * 4 : texel_size, 4)
+        );
+        // every texel is overwritten, no need to keep the old contents
+        image.transition_layout(
+            VK_IMAGE_LAYOUT_UNDEFINED,
+            VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+            _scope
+        );
+        image.copy_from(
+            region.buffer,
+            _scope,
+            texel_size ? uint32_t(row_pitch / texel_size) : 0,
+            std::nullopt,
+            region.offset
+        );
+        if (final_layout != VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL)
+            image.transition_layout(final_layout, _scope);
+    }
+
+    void upload_batch_t::transition(
+        image_t& image,
+        VkImageLayout layout
+    )
+    {
+        image.transition_layout(layout, _scope);
+    }
+
+    upload_batch_t::token_t upload_batch_t::submit()
+    {
+        if (!_commands.device())
+            throw std::logic_error{"upload batch was already submitted"};
+        if (_has_buffer_copies)
+        {
+            // one barrier for all buffer copies instead of one per buffer
+            VkMemoryBarrier barrier = {};
+            barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+            barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+            barrier.dstAccessMask = VK_ACCESS_MEMORY_READ_BIT;
+            _scope.pipeline_barrier(
+                VK_PIPELINE_STAGE_TRANSFER_BIT,
+                VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
+                std::vector<VkMemoryBarrier>{barrier}
+            );
+        }
+        _scope.end();
+        auto submission = _device->staging_ring().retire(_regions);
+        std::optional<fence_t> fence;
+        if (!submission.fence)
+            fence.emplace(_device->get());
+        try
+        {
+            _command_pool->queue().submit(
+                _commands.get(),
+                fence ? fence->get() : submission.fence
+            );
+        }
+        catch (...)
+        {
+            // the regions are not ours to release any more
+            _device->staging_ring().abandon(submission);
+            _regions.clear();
+            throw;
+        }
+        _regions.clear();
+        return token_t{
+            std::move(_commands),
+            &_device->staging_ring(),
+            submission.serial,
+            std::move(fence)
+        };
+    }
+}
@@ -0,0 +1,89 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+#include <limits>
+#include <optional>
+#include <vector>
+
+#include "buffer.hpp"
+#include "command_buffer.hpp"
+#include "command_pool.hpp"
+#include "device.hpp"
+#include "fence.hpp"
+#include "image.hpp"
+#include "staging_ring.hpp"
+
+namespace my_vulkan
+{
+    // records any number of uploads and layout transitions into one
+    // command buffer that is submitted once
+    struct upload_batch_t
+    {
+        // completion of a submitted batch, keeps its command buffer alive.
+        // destroying an unfinished token waits for it.
+        struct token_t
+        {
+            token_t(const token_t&) = delete;
+            token_t(token_t&& other) noexcept;
+            token_t& operator=(const token_t&) = delete;
+            token_t& operator=(token_t&& other) noexcept;
+            ~token_t();
+            bool ready();
+            void wait();
+        private:
+            friend struct upload_batch_t;
+            token_t(
+                command_buffer_t commands,
+                staging_ring_t* staging_ring,
+                uint64_t serial,
+                std::optional<fence_t> fence
+            );
+            void cleanup();
+            command_buffer_t _commands;
+            staging_ring_t* _staging_ring;
+            uint64_t _serial;
+            std::optional<fence_t> _fence;
+            bool _pending{false};
+        };
+        upload_batch_t(
+            device_t& device,
+            command_pool_t& command_pool
+        );
+        upload_batch_t(const upload_batch_t&) = delete;
+        upload_batch_t& operator=(const upload_batch_t&) = delete;
+        // hands back the staging space of a batch that was never submitted
+        ~upload_batch_t();
+        void upload(
+            buffer_t& buffer,
+            const void* data,
+            VkDeviceSize size,
+            VkDeviceSize offset = 0
+        );
+        // pitch in bytes per row, tightly packed rows by default
+        void upload(
+            image_t& image,
+            const void* pixels,
+            std::optional<size_t> pitch = std::nullopt,
+            VkImageLayout final_layout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL
+        );
+        void transition(
+            image_t& image,
+            VkImageLayout layout
+        );
+        // copies data into the staging ring, for commands recorded by hand
+        staging_ring_t::region_t stage(
+            const void* data,
+            VkDeviceSize size,
+            VkDeviceSize alignment = 16
+        );
+        command_buffer_t::scope_t& commands();
+        token_t submit();
+    private:
+        device_t* _device;
+        command_pool_t* _command_pool;
+        command_buffer_t _commands;
+        command_buffer_t::scope_t _scope;
+        std::vector<staging_ring_t::region_t> _regions;
+        bool _has_buffer_copies{false};
+    };
+}
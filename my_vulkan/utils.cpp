@@ -140,14 +140,13 @@ namespace my_vulkan
         std::vector<VkQueueFamilyProperties> queueFamilies(queueFamilyCount);
         vkGetPhysicalDeviceQueueFamilyProperties(device, &queueFamilyCount, queueFamilies.data());
 
+        indices.transfer = find_transfer_queue(device);
         int i = 0;
         for (const auto& queueFamily : queueFamilies)
         {
             if (queueFamily.queueCount > 0 && queueFamily.queueFlags & VK_QUEUE_GRAPHICS_BIT)
                 indices.graphics = i;
 
-            if (queueFamily.queueCount > 0 && queueFamily.queueFlags & VK_QUEUE_TRANSFER_BIT)
-                indices.transfer = i;
             if (surface)
             {
                 VkBool32 presentSupport = false;
@@ -570,6 +569,25 @@ namespace my_vulkan
         VkPhysicalDevice device
     )
     {
+        // prefer a family that does nothing but transfers, those are
+        // backed by dma engines that run alongside rendering
+        uint32_t num_queues = 0;
+        vkGetPhysicalDeviceQueueFamilyProperties(device, &num_queues, 0);
+        std::vector<VkQueueFamilyProperties> properties(num_queues);
+        vkGetPhysicalDeviceQueueFamilyProperties(device, &num_queues, properties.data());
+        for (VkQueueFlags excluded : {
+            VkQueueFlags(VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT),
+            VkQueueFlags(VK_QUEUE_GRAPHICS_BIT)
+        })
+        {
+            for (uint32_t i = 0; i < num_queues; ++i)
+                if (
+                    properties[i].queueCount > 0 &&
+                    (properties[i].queueFlags & VK_QUEUE_TRANSFER_BIT) &&
+                    !(properties[i].queueFlags & excluded)
+                )
+                    return i;
+        }
         return find_queue(device, VK_QUEUE_TRANSFER_BIT);
     }
 
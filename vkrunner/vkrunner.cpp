@@ -4,6 +4,9 @@
 #include <my_vulkan/device.hpp>
 #include <my_vulkan/render_pass.hpp>
 #include <my_vulkan/graphics_pipeline.hpp>
+#include <my_vulkan/compute_pipeline.hpp>
+#include <my_vulkan/command_pool.hpp>
+#include <my_vulkan/descriptor_pool.hpp>
 #include <my_vulkan/helpers/offscreen_render_target.hpp>
 
 #include <opencv2/imgcodecs.hpp>
@@ -21,9 +24,12 @@
 
 #include <vector>
 #include <string>
+#include <cmath>
+#include <cstring>
 #include <istream>
 #include <fstream>
 #include <iostream>
+#include <map>
 #include <optional>
 
 static inline void ltrim(std::string &s) {
@@ -217,6 +223,9 @@ struct bits_t
 {
     std::optional<my_vulkan::shader_module_t> vertex_shader;
     std::optional<my_vulkan::shader_module_t> fragment_shader;
+    std::optional<my_vulkan::shader_module_t> compute_shader;
+    // contents of the push constant block, set by push commands
+    std::vector<uint8_t> push_constants = std::vector<uint8_t>(128, 0);
     std::vector<std::string> test_script;
     // todo: parse/generate these
     VkFormat color_format = VK_FORMAT_B8G8R8A8_UNORM;
@@ -370,6 +379,222 @@ bool probe_rect(const cv::Mat4b& bgra, rect_t rect, glm::vec4 color, const std::
     return true;
 }
 
+static const VkShaderStageFlags push_constant_stages =
+    VK_SHADER_STAGE_VERTEX_BIT |
+    VK_SHADER_STAGE_FRAGMENT_BIT |
+    VK_SHADER_STAGE_COMPUTE_BIT;
+
+static std::vector<VkPushConstantRange> push_constant_ranges(bits_t& bits)
+{
+    return {{
+        push_constant_stages,
+        0,
+        uint32_t(bits.push_constants.size())
+    }};
+}
+
+template<typename T>
+void write_values(
+    std::vector<uint8_t>& target,
+    size_t offset,
+    const std::vector<std::string>& values
+)
+{
+    if (offset + values.size() * sizeof(T) > target.size())
+        throw std::runtime_error{"push outside of push constant block"};
+    for (size_t i = 0; i < values.size(); ++i)
+    {
+        auto value = boost::lexical_cast<T>(values[i]);
+        std::memcpy(target.data() + offset + i * sizeof(T), &value, sizeof(T));
+    }
+}
+
+// push <type> <offset> <values...>
+void push_values(bits_t& bits, const std::vector<std::string>& tokens)
+{
+    auto type = tokens[1];
+    auto offset = boost::lexical_cast<size_t>(tokens[2]);
+    std::vector<std::string> values{tokens.begin() + 3, tokens.end()};
+    if (type == "int" || type.rfind("ivec", 0) == 0)
+        write_values<int32_t>(bits.push_constants, offset, values);
+    else if (type == "uint" || type.rfind("uvec", 0) == 0)
+        write_values<uint32_t>(bits.push_constants, offset, values);
+    else if (type == "float" || type.rfind("vec", 0) == 0)
+        write_values<float>(bits.push_constants, offset, values);
+    else
+        throw std::runtime_error{"unsupported push type " + type};
+}
+
+template<typename T>
+bool probe_values(
+    const uint8_t* data,
+    const std::vector<std::string>& expected,
+    bool fuzzy
+)
+{
+    bool result = true;
+    for (size_t i = 0; i < expected.size(); ++i)
+    {
+        T value;
+        std::memcpy(&value, data + i * sizeof(T), sizeof(T));
+        auto wanted = boost::lexical_cast<T>(expected[i]);
+        bool same = fuzzy ?
+            std::abs(double(value) - double(wanted)) <= 0.01 :
+            value == wanted;
+        if (!same)
+            std::cerr << " value " << value << " != " << wanted << std::endl;
+        result &= same;
+    }
+    return result;
+}
+
+// probe ssbo <type> <binding> <offset> <== or ~=> <values...>
+bool probe_ssbo(
+    my_vulkan::buffer_t& buffer,
+    const std::vector<std::string>& tokens
+)
+{
+    auto type = tokens[2];
+    auto offset = boost::lexical_cast<size_t>(tokens[4]);
+    auto op = tokens[5];
+    std::vector<std::string> expected{tokens.begin() + 6, tokens.end()};
+    if (op != "==" && op != "~=")
+        throw std::runtime_error{"unsupported probe operator " + op};
+    if (offset + expected.size() * 4 > buffer.size())
+        throw std::runtime_error{"probe outside of ssbo"};
+    my_vulkan::device_memory_t::mapping_t mapping{*buffer.memory()};
+    mapping.invalidate();
+    auto data = static_cast<const uint8_t*>(mapping.data()) + offset;
+    bool fuzzy = op == "~=";
+    if (type == "int" || type.rfind("ivec", 0) == 0)
+        return probe_values<int32_t>(data, expected, fuzzy);
+    if (type == "uint" || type.rfind("uvec", 0) == 0)
+        return probe_values<uint32_t>(data, expected, fuzzy);
+    if (type == "float" || type.rfind("vec", 0) == 0)
+        return probe_values<float>(data, expected, fuzzy);
+    throw std::runtime_error{"unsupported probe type " + type};
+}
+
+bool run_compute_test(base_setup_t& setup, bits_t& bits)
+{
+    auto device = setup.logical_device.get();
+    std::map<uint32_t, my_vulkan::buffer_t> ssbos;
+    std::optional<my_vulkan::compute_pipeline_t> pipeline;
+    std::optional<my_vulkan::descriptor_pool_t> descriptor_pool;
+    std::optional<my_vulkan::descriptor_set_t> descriptor_set;
+    my_vulkan::command_pool_t command_pool{
+        device,
+        setup.logical_device.graphics_queue()
+    };
+    bool success = true;
+    for (auto& line : bits.test_script)
+    {
+        auto tokens = tokenize_script_command(line);
+        if (tokens.size() == 3 && tokens[0] == "ssbo")
+        {
+            auto binding = boost::lexical_cast<uint32_t>(tokens[1]);
+            auto size = boost::lexical_cast<VkDeviceSize>(tokens[2]);
+            my_vulkan::buffer_t buffer{
+                setup.logical_device,
+                size,
+                VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+                VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT
+            };
+            buffer.memory()->set_data(std::vector<uint8_t>(size, 0));
+            ssbos.erase(binding);
+            ssbos.emplace(binding, std::move(buffer));
+            pipeline.reset();
+        }
+        if (tokens.size() >= 4 && tokens[0] == "push")
+            push_values(bits, tokens);
+        if (tokens.size() == 4 && tokens[0] == "compute")
+        {
+            if (!pipeline)
+            {
+                std::vector<VkDescriptorSetLayoutBinding> layout;
+                for (auto& ssbo : ssbos)
+                    layout.push_back(my_vulkan::storage_buffer_binding(ssbo.first));
+                pipeline.emplace(
+                    device,
+                    layout,
+                    *bits.compute_shader,
+                    push_constant_ranges(bits)
+                );
+                descriptor_set.reset();
+                descriptor_pool.reset();
+                if (!layout.empty())
+                {
+                    descriptor_pool.emplace(
+                        device,
+                        std::vector<VkDescriptorPoolSize>{{
+                            VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+                            uint32_t(layout.size())
+                        }},
+                        1
+                    );
+                    descriptor_set.emplace(
+                        descriptor_pool->make_descriptor_set(
+                            pipeline->uniform_layout()
+                        )
+                    );
+                    for (auto& ssbo : ssbos)
+                        descriptor_set->update_storage_buffer_write(
+                            ssbo.first,
+                            ssbo.second.get()
+                        );
+                }
+            }
+            std::cerr << "compute " << tokens[1] << " " << tokens[2] << " " << tokens[3] << std::endl;
+            auto oneshot = command_pool.begin_oneshot();
+            auto& commands = oneshot.commands();
+            commands.bind_pipeline(VK_PIPELINE_BIND_POINT_COMPUTE, pipeline->get());
+            if (descriptor_set)
+                commands.bind_descriptor_set(
+                    VK_PIPELINE_BIND_POINT_COMPUTE,
+                    pipeline->layout(),
+                    {descriptor_set->get()}
+                );
+            commands.push_constants(
+                pipeline->layout(),
+                push_constant_stages,
+                0,
+                uint32_t(bits.push_constants.size()),
+                bits.push_constants.data()
+            );
+            commands.dispatch(
+                boost::lexical_cast<uint32_t>(tokens[1]),
+                boost::lexical_cast<uint32_t>(tokens[2]),
+                boost::lexical_cast<uint32_t>(tokens[3])
+            );
+            commands.pipeline_barrier(
+                VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                VK_PIPELINE_STAGE_HOST_BIT,
+                {VkMemoryBarrier{
+                    VK_STRUCTURE_TYPE_MEMORY_BARRIER,
+                    nullptr,
+                    VK_ACCESS_SHADER_WRITE_BIT,
+                    VK_ACCESS_HOST_READ_BIT
+                }}
+            );
+            oneshot.execute_and_wait();
+        }
+        if (tokens.size() >= 7 && tokens[0] == "probe" && tokens[1] == "ssbo")
+        {
+            auto binding = boost::lexical_cast<uint32_t>(tokens[3]);
+            auto ssbo = ssbos.find(binding);
+            if (ssbo == ssbos.end())
+                throw std::runtime_error{"no ssbo at binding " + tokens[3]};
+            auto result = probe_ssbo(ssbo->second, tokens);
+            if (result)
+                std::cerr << "-> success" << std::endl;
+            else
+                std::cerr << "-> failure" << std::endl;
+            success &= result;
+        }
+    }
+    return success;
+}
+
 int main(int argc, const char** argv)
 {
     if (argc < 2)
@@ -403,6 +628,13 @@ int main(int argc, const char** argv)
                 ".vert",
                 version
             );
+        else if (section.name == "compute shader")
+            bits.compute_shader = load_shader_source(
+                setup.logical_device.get(),
+                section.lines,
+                ".comp",
+                version
+            );
         else if (section.name == "vertex shader passthrough")
             bits.vertex_shader = my_vulkan::shader_module_t{
                 setup.logical_device.get(),
@@ -450,7 +682,9 @@ int main(int argc, const char** argv)
             my_vulkan::render_settings_t{
                 .topology = bits.topology
             },
-            false // dynamic viewport
+            false, // dynamic viewport
+            VK_NULL_HANDLE,
+            push_constant_ranges(bits)
         };
         my_vulkan::framebuffer_t framebuffer{
             setup.logical_device.get(),
@@ -512,6 +746,8 @@ int main(int argc, const char** argv)
         for (auto& line : bits.test_script)
         {
             auto tokens = tokenize_script_command(line);
+            if (tokens.size() >= 4 && tokens[0] == "push")
+                push_values(bits, tokens);
             if (tokens.size() == 6 && tokens[0] == "draw" && tokens[1] == "rect")
             {
                 notify_draw();
@@ -526,6 +762,13 @@ int main(int argc, const char** argv)
                     }
                 };
                 std::cerr << "draw rect " << rect.origin << " " << rect.size << std::endl;
+                current_scope->commands->push_constants(
+                    graphics_pipeline.layout(),
+                    push_constant_stages,
+                    0,
+                    uint32_t(bits.push_constants.size()),
+                    bits.push_constants.data()
+                );
                 buffers.push_back(draw_rect(
                     setup,
                     bits,
@@ -558,6 +801,11 @@ int main(int argc, const char** argv)
             }
         }
     }
+    if (bits.compute_shader)
+    {
+        std::cerr << "beginning compute test" << std::endl;
+        success &= run_compute_test(setup, bits);
+    }
     if (success)
         return 0;
     else